@@ -85,7 +85,11 @@ unsigned int HardSIDBuilder::create(unsigned int sids)
     {
         try
         {
+#ifdef _WIN32
             std::auto_ptr<HardSID> sid(new HardSID(this));
+#else
+            std::auto_ptr<HardSID> sid(new HardSID(this, m_device));
+#endif
 
             // SID init failed?
             if (!sid->getStatus())
@@ -118,7 +122,8 @@ unsigned int HardSIDBuilder::availDevices() const
 #ifdef _WIN32
     return hsid2.Instance ? hsid2.Devices() : 0;
 #else
-    return m_count;
+    // As many fake devices as wanted
+    return m_device.empty() ? m_count : 16;
 #endif
 }
 
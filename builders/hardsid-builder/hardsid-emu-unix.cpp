@@ -26,6 +26,8 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <cerrno>
 #include <cstdio>
 #include <sstream>
 #include <string>
@@ -52,6 +54,8 @@ unsigned int HardSID::sid = 0;
 
 const char* HardSID::getCredits()
 {
+    sidlock lock(m_creditMutex);
+
     if (m_credit.empty())
     {
         // Setup credits
@@ -64,12 +68,15 @@ const char* HardSID::getCredits()
     return m_credit.c_str();
 }
 
-HardSID::HardSID (sidbuilder *builder) :
+HardSID::HardSID (sidbuilder *builder, const std::string &device) :
     sidemu(builder),
     Event("HardSID Delay"),
     m_handle(0),
+    m_fake(false),
     m_instance(sid++)
 {
+    m_queue.setDevice(this);
+
     unsigned int num = 16;
     for ( unsigned int i = 0; i < 16; i++ )
     {
@@ -87,6 +94,22 @@ HardSID::HardSID (sidbuilder *builder) :
 
     m_instance = num;
 
+    if (!device.empty())
+    {
+        std::ostringstream ss;
+        ss << device;
+        if (m_instance)
+            ss << "." << m_instance;
+        const std::string path = ss.str();
+
+        m_handle = open (path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+        if (m_handle < 0)
+        {
+            m_error.assign("HARDSID ERROR: Cannot access \"").append(path).append("\"");
+            return;
+        }
+    }
+    else
     {
         char device[20];
         sprintf (device, "/dev/sid%u", m_instance);
@@ -110,22 +133,69 @@ HardSID::HardSID (sidbuilder *builder) :
         }
     }
 
+    // Anything but the driver gets the delays in the stream
+    struct stat st;
+    m_fake = fstat (m_handle, &st) == 0 && !S_ISCHR(st.st_mode);
+
     m_status = true;
     reset ();
 }
 
 HardSID::~HardSID()
 {
+    m_queue.flush();
     sid--;
     m_sidFree[m_instance] = 0;
     if (m_handle)
         close (m_handle);
 }
 
+void HardSID::send(const uint32_t *packets, unsigned int count)
+{
+    const char *data = reinterpret_cast<const char*>(packets);
+    size_t size = count * sizeof (uint32_t);
+
+    while (size)
+    {
+        const ssize_t written = ::write (m_handle, data, size);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+        data += written;
+        size -= written;
+    }
+}
+
+void HardSID::transfer(const uint32_t *packets, unsigned int count)
+{
+    if (m_fake)
+    {
+        send(packets, count);
+        return;
+    }
+
+    // The driver takes the delays by ioctl
+    unsigned int start = 0;
+    for (unsigned int i = 0; i < count; i++)
+    {
+        if (sidwritequeue::isDelay(packets[i]))
+        {
+            send(packets + start, i - start);
+            ioctl(m_handle, HSID_IOCTL_DELAY, (int) sidwritequeue::cycles(packets[i]));
+            start = i + 1;
+        }
+    }
+    send(packets + start, count - start);
+}
+
 void HardSID::reset(uint8_t volume)
 {
     for (unsigned int i= 0; i < voices; i++)
         muted[i] = false;
+    m_queue.clear();
     ioctl(m_handle, HSID_IOCTL_RESET, volume);
     m_accessClk = 0;
     if (m_context != 0)
@@ -140,13 +210,7 @@ void HardSID::clock()
     event_clock_t cycles = m_context->getTime(m_accessClk, EVENT_CLOCK_PHI1);
     m_accessClk += cycles;
 
-    while (cycles > 0xffff)
-    {
-        ioctl(m_handle, HSID_IOCTL_DELAY, 0xffff);
-        cycles -= 0xffff;
-    }
-    if (cycles)
-        ioctl(m_handle, HSID_IOCTL_DELAY, cycles);
+    m_queue.delay(cycles);
 }
 
 uint8_t HardSID::read(uint_least8_t addr)
@@ -157,14 +221,11 @@ uint8_t HardSID::read(uint_least8_t addr)
     event_clock_t cycles = m_context->getTime(m_accessClk, EVENT_CLOCK_PHI1);
     m_accessClk += cycles;
 
-    while ( cycles > 0xffff )
-    {
-        /* delay */
-        ioctl(m_handle, HSID_IOCTL_DELAY, 0xffff);
-        cycles -= 0xffff;
-    }
+    // The read must come after the queued writes
+    m_queue.delay(cycles);
+    m_queue.flush();
 
-    unsigned int packet = (( cycles & 0xffff ) << 16 ) | (( addr & 0x1f ) << 8 );
+    unsigned int packet = sidwritequeue::packet(0, addr, 0);
     ioctl(m_handle, HSID_IOCTL_READ, &packet);
 
     return (uint8_t) (packet & 0xff);
@@ -178,17 +239,7 @@ void HardSID::write(uint_least8_t addr, uint8_t data)
     event_clock_t cycles = m_context->getTime (m_accessClk, EVENT_CLOCK_PHI1);
     m_accessClk += cycles;
 
-    while ( cycles > 0xffff )
-    {
-        /* delay */
-        ioctl(m_handle, HSID_IOCTL_DELAY, 0xffff);
-        cycles -= 0xffff;
-    }
-
-    unsigned int packet = (( cycles & 0xffff ) << 16 ) | (( addr & 0x1f ) << 8 )
-        | (data & 0xff);
-
-    ::write (m_handle, &packet, sizeof (packet));
+    m_queue.write(cycles, addr, data);
 }
 
 void HardSID::voice(unsigned int num, bool mute)
@@ -215,7 +266,7 @@ void HardSID::event()
     else
     {
         m_accessClk += cycles;
-        ioctl(m_handle, HSID_IOCTL_DELAY, (uint) cycles);
+        m_queue.delay(cycles);
         m_context->schedule (*this, HARDSID_DELAY_CYCLES, EVENT_CLOCK_PHI1);
     }
 }
@@ -227,6 +278,7 @@ void HardSID::filter(bool enable)
 
 void HardSID::flush()
 {
+    m_queue.clear();
     ioctl(m_handle, HSID_IOCTL_FLUSH);
 }
 
@@ -240,6 +292,7 @@ bool HardSID::lock(EventContext* env)
 
 void HardSID::unlock()
 {
+    m_queue.flush();
     m_context->cancel(*this);
     sidemu::unlock();
 }
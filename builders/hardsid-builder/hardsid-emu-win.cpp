@@ -44,6 +44,8 @@ unsigned int HardSID::sid = 0;
 
 const char* HardSID::getCredits()
 {
+    sidlock lock(m_creditMutex);
+
     if (m_credit.empty())
     {
         // Setup credits
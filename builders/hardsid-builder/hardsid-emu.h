@@ -28,6 +28,7 @@
 #include "sidemu.h"
 #include "EventScheduler.h"
 #include "sidplayfp/siddefs.h"
+#include "sidwritequeue.h"
 
 #ifdef HAVE_CONFIG_H
 #  include "config.h"
@@ -95,6 +96,9 @@ struct HsidDLL2
  * HardSID SID Specialisation
  ***************************************************************************/
 class HardSID : public sidemu, private Event
+#ifndef _WIN32
+    , private sidwritequeue::device
+#endif
 {
 private:
     friend class HardSIDBuilder;
@@ -103,6 +107,12 @@ private:
 #ifndef _WIN32
     static         bool m_sidFree[16];
     int            m_handle;
+
+    /// Batches the writes, one system call per frame
+    sidwritequeue  m_queue;
+
+    /// Writing to a file or pipe rather than to the driver
+    bool           m_fake;
 #endif
 
     static const unsigned int voices;
@@ -116,7 +126,15 @@ public:
     static const char* getCredits();
 
 public:
+#ifdef _WIN32
     HardSID(sidbuilder *builder);
+#else
+    /**
+     * @param device a file or named pipe to use instead
+     *        of the devices, may be empty
+     */
+    HardSID(sidbuilder *builder, const std::string &device);
+#endif
     ~HardSID();
 
     // Standard component functions
@@ -145,6 +163,11 @@ private:
     // shoot to 100% CPU usage when song nolonger
     // writes to SID.
     void event();
+
+#ifndef _WIN32
+    void transfer(const uint32_t *packets, unsigned int count);
+    void send(const uint32_t *packets, unsigned int count);
+#endif
 };
 
 #endif // HARDSID_EMU_H
@@ -23,6 +23,8 @@
 #ifndef  HARDSID_H
 #define  HARDSID_H
 
+#include <string>
+
 #include "sidplayfp/sidbuilder.h"
 #include "sidplayfp/siddefs.h"
 
@@ -36,6 +38,8 @@ private:
 
 #ifndef _WIN32
     static unsigned int m_count;
+
+    std::string m_device;
 #endif
 
     int init ();
@@ -55,6 +59,20 @@ public:
 
     void flush();
 
+#ifndef _WIN32
+    /**
+     * Send the register writes to a file or a named pipe
+     * instead of the /dev/sid devices, to test without the hardware.
+     * They are stored as the 32 bit packets the driver gets,
+     * including the delays, see sidwritequeue.
+     * The second SID writes to the name followed by ".1" and so on.
+     * Must be called before create.
+     *
+     * @param path the file, empty to use the devices
+     */
+    void setDevice(const char *path) { m_device = path; }
+#endif
+
     /**
      * enable/disable filter.
      */
@@ -52,6 +52,8 @@ unsigned int Innov::sid = 0;
 
 const char* Innov::getCredits()
 {
+    sidlock lock(m_creditMutex);
+
     if (m_credit.empty())
     {
         // Setup credits
@@ -43,10 +43,13 @@ u32 vcpu_freq;
 
 Innov::Innov(sidbuilder *builder) :
 sidemu(builder),
-Event("Innov Delay")
+Event("Innov Delay"),
+m_writer(*this, INNOV_LATENCY_CYCLES)
 {
     ++sid;
 
+    m_queue.setDevice(&m_writer);
+
     timer_grab();
     /*
     m_error.assign("HARDSID ERROR: Cannot access \"").append(device).append("\"");
@@ -95,6 +98,10 @@ void Innov::reset(uint8_t volume)
     for (unsigned int i = 0; i < voices; i++)
         muted[i] = false;
 
+    // Nothing is played after this so the port is ours
+    m_queue.clear();
+    m_writer.reset();
+
     for (unsigned int i = 0; i < 24; i++) {
         out(i, 0);
     }
@@ -118,12 +125,17 @@ uint8_t Innov::read(uint_least8_t addr)
     }
     */
 
-    m_accessClk += (u32)m_context->getTime(m_accessClk, EVENT_CLOCK_PHI1);
-
     //printf("_DEBUG: Innov::read | cycles = %lu\n", cycles);    
 
     synchronize();
 
+    // The read must come after the queued writes
+    if (m_writer.running())
+    {
+        m_queue.flush();
+        m_writer.drain();
+    }
+
     //ioctl(m_handle, HSID_IOCTL_READ, &packet);
 
     unsigned int packet = in(addr);
@@ -136,11 +148,19 @@ void Innov::write(uint_least8_t addr, uint8_t data)
 {
     //printf("_DEBUG: Innov::write call!\n");
 
-    m_accessClk += (u32)m_context->getTime(m_accessClk, EVENT_CLOCK_PHI1);
+    const event_clock_t cycles = m_context->getTime(m_accessClk, EVENT_CLOCK_PHI1);
+    m_accessClk += cycles;
 
     //printf("_DEBUG: Innov::write | cycles = %lu\n", cycles);
 
-    synchronize();
+    // Played later by the playback thread
+    if (m_writer.running())
+    {
+        m_queue.write(cycles, addr, data);
+        return;
+    }
+
+    wait();
 
     out(addr, data);
 }
@@ -158,6 +178,9 @@ void Innov::unlock()
 {
     //printf("_DEBUG: Innov::unlock call!\n");
 
+    m_queue.flush();
+    m_writer.drain();
+
     m_context->cancel(*this);
     sidemu::unlock();
 }
@@ -167,14 +190,23 @@ void Innov::sampling(float systemfreq, float outputfreq,
 {
     vcpu_freq = (u32)systemfreq;
     reset_timer();
+
+    // Where threads are available the writes are batched
+    // and played by a thread, otherwise they wait inline
+    m_writer.start(systemfreq);
     // All other parameters ignored
 }
 
 
 void Innov::synchronize()
 {
-    m_accessClk += (u32)m_context->getTime(m_accessClk, EVENT_CLOCK_PHI1);
-    wait();
+    const event_clock_t cycles = m_context->getTime(m_accessClk, EVENT_CLOCK_PHI1);
+    m_accessClk += cycles;
+
+    if (m_writer.running())
+        m_queue.delay(cycles);
+    else
+        wait();
 }
 
 void Innov::event()
@@ -30,6 +30,8 @@
 #include "../../sidplayfp/sidemu.h"
 #include "../../sidplayfp/EventScheduler.h"
 #include "../../sidplayfp/siddefs.h"
+#include "../../sidplayfp/sidwritequeue.h"
+#include "../../sidplayfp/sidtimedwriter.h"
 #include "innov.h"
 
 #ifdef HAVE_CONFIG_H
@@ -50,10 +52,13 @@ class sidbuilder;
 // Approx 60ms TODO: Necessary?
 #define HARDSID_DELAY_CYCLES 60000
 
+// How far the emulation may run ahead of the playback thread, about 3 frames
+#define INNOV_LATENCY_CYCLES (3 * sidwritequeue::BATCH_CYCLES)
+
 /***************************************************************************
  * Innov SID Specialisation
  ***************************************************************************/
-class Innov : public sidemu, private Event
+class Innov : public sidemu, private Event, private sidtimedwriter::port
 {
 private:
     friend class InnovBuilder;
@@ -64,6 +69,10 @@ private:
     // Must stay in this order
     bool           muted[INNOV_VOICES];
 
+    /// Batches the writes for the playback thread
+    sidwritequeue  m_queue;
+    sidtimedwriter m_writer;
+
 public:
     static const char* getCredits() {
         return "Innovation SSI-2001 Engine v. 1.1\n";
@@ -104,11 +113,14 @@ private:
 
     /// Realtime wait until target time
     void wait();
-    /// Update m_accessClk and wait()
+    /// Update m_accessClk and wait(), or queue the delay
     void synchronize();
     /// Reset internal timers
     bool reset_timer();
 
+    /// Called from the playback thread
+    void replay(uint_least8_t addr, uint8_t data) { out(addr, data); }
+
     static u8 in(unsigned port);
     static void out(unsigned port, u8 data);
 };
@@ -22,6 +22,7 @@
 
 #include "resid-emu.h"
 
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 #include <sstream>
@@ -30,8 +31,25 @@
 #include "resid/siddefs.h"
 #include "resid/spline.h"
 
+#include "sidthread.h"
+#include "sidstate.h"
+
+/**
+ * reSID builds its shared model tables when the first
+ * SID is created, so creation must be serialized.
+ */
+static sidmutex residMutex;
+
+static RESID_NS::SID *createSID()
+{
+    sidlock lock(residMutex);
+    return new RESID_NS::SID;
+}
+
 const char* ReSID::getCredits()
 {
+    sidlock lock(m_creditMutex);
+
     if (m_credit.empty())
     {
         // Setup credits
@@ -48,10 +66,11 @@ const char* ReSID::getCredits()
 
 ReSID::ReSID (sidbuilder *builder) :
     sidemu(builder),
-    m_sid(*(new RESID_NS::SID)),
+    m_sid(*createSID()),
     m_voiceMask(0x07)
 {
-    m_buffer = new short[OUTPUTBUFFERSIZE];
+    m_buffer = new int[OUTPUTBUFFERSIZE];
+    m_sidBuffer = new short[OUTPUTBUFFERSIZE];
     reset (0);
 }
 
@@ -59,6 +78,7 @@ ReSID::~ReSID()
 {
     delete &m_sid;
     delete[] m_buffer;
+    delete[] m_sidBuffer;
 }
 
 void ReSID::bias(double dac_bias)
@@ -90,7 +110,15 @@ void ReSID::clock()
 {
     RESID_NS::cycle_count cycles = m_context->getTime(m_accessClk, EVENT_CLOCK_PHI1);
     m_accessClk += cycles;
-    m_bufferpos += m_sid.clock(cycles, (short *) m_buffer + m_bufferpos, OUTPUTBUFFERSIZE - m_bufferpos, 1);
+
+    if (m_silent)
+        m_sid.clock_silent(cycles);
+    else
+    {
+        const int n = m_sid.clock(cycles, m_sidBuffer, OUTPUTBUFFERSIZE - m_bufferpos, 1);
+        std::copy(m_sidBuffer, m_sidBuffer + n, m_buffer + m_bufferpos);
+        m_bufferpos += n;
+    }
 }
 
 void ReSID::filter(bool enable)
@@ -126,6 +154,31 @@ void ReSID::sampling(float systemclock, float freq,
     m_status = true;
 }
 
+bool ReSID::serializeChip(sidstate &s)
+{
+    if (s.saving())
+    {
+        RESID_NS::SID::State state = m_sid.read_state();
+        s.io(state);
+        return true;
+    }
+
+    RESID_NS::SID::State state;
+    s.io(state);
+    if (s.failed())
+        return false;
+
+    if (!m_sid.write_state(state))
+    {
+        s.fail();
+        return false;
+    }
+
+    // Keep the channels muted by the user
+    m_sid.set_voice_mask(m_voiceMask);
+    return true;
+}
+
 void ReSID::voice (unsigned int num, bool mute)
 {
     if (mute)
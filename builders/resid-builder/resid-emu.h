@@ -49,6 +49,12 @@ private:
     RESID_NS::SID &m_sid;
     uint8_t       m_voiceMask;
 
+    /// reSID output, clipped to 16 bits by the emulation itself
+    short         *m_sidBuffer;
+
+protected:
+    bool serializeChip(sidstate &s);
+
 public:
     static const char* getCredits();
 
@@ -406,6 +406,9 @@ Filter::Filter()
     class_init = true;
   }
 
+  // No DAC bias until adjust_filter_bias is called.
+  Vw_bias = 0;
+
   enable_filter(true);
   set_chip_model(MOS6581);
   set_voice_mask(0x07);
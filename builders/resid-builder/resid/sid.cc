@@ -21,6 +21,7 @@
 
 #include "sid.h"
 #include <math.h>
+#include <string.h>
 
 #ifndef round
 #define round(x) (x>=0.0?floor(x+0.5):ceil(x-0.5))
@@ -288,6 +289,24 @@ SID::State::State()
     envelope_state[i] = EnvelopeGenerator::RELEASE;
     hold_zero[i] = true;
     envelope_pipeline[i] = 0;
+
+    msb_rising[i] = false;
+    waveform_output[i] = 0;
+    noise_output[i] = 0;
+  }
+
+  filter_Vhp = 0;
+  filter_Vbp = filter_Vbp_x = filter_Vbp_vc = 0;
+  filter_Vlp = filter_Vlp_x = filter_Vlp_vc = 0;
+
+  extfilt_Vlp = 0;
+  extfilt_Vhp = 0;
+
+  sample_offset = 0;
+  sample_index = 0;
+  sample_prev = sample_now = 0;
+  for (i = 0; i < (1 << 14); i++) {
+    sample[i] = 0;
   }
 }
 
@@ -352,21 +371,131 @@ SID::State SID::read_state()
     state.envelope_state[i] = voice[i].envelope.state;
     state.hold_zero[i] = voice[i].envelope.hold_zero;
     state.envelope_pipeline[i] = voice[i].envelope.envelope_pipeline;
+
+    state.msb_rising[i] = voice[i].wave.msb_rising;
+    state.waveform_output[i] = voice[i].wave.waveform_output;
+    state.noise_output[i] = voice[i].wave.noise_output;
+  }
+
+  state.filter_Vhp = filter.Vhp;
+  state.filter_Vbp = filter.Vbp;
+  state.filter_Vbp_x = filter.Vbp_x;
+  state.filter_Vbp_vc = filter.Vbp_vc;
+  state.filter_Vlp = filter.Vlp;
+  state.filter_Vlp_x = filter.Vlp_x;
+  state.filter_Vlp_vc = filter.Vlp_vc;
+
+  state.extfilt_Vlp = extfilt.Vlp;
+  state.extfilt_Vhp = extfilt.Vhp;
+
+  state.sample_offset = sample_offset;
+  state.sample_index = sample_index;
+  state.sample_prev = sample_prev;
+  state.sample_now = sample_now;
+  if (sample) {
+    for (i = 0; i < RINGSIZE; i++) {
+      state.sample[i] = sample[i];
+    }
   }
 
   return state;
 }
 
 
+// Restored state is raw memory, check bools and enums by their bytes
+// as loading an invalid value is undefined.
+template<class T>
+static bool is_valid(const T& value, const T& a, const T& b)
+{
+  return memcmp(&value, &a, sizeof(T)) == 0 ||
+    memcmp(&value, &b, sizeof(T)) == 0;
+}
+
+
 // ----------------------------------------------------------------------------
 // Write state.
 // ----------------------------------------------------------------------------
-void SID::write_state(const State& state)
+bool SID::write_state(const State& state)
 {
   int i;
 
+  // Reject state the emulation can't run from, the counters index
+  // tables and the filter values must not overflow its arithmetic.
+  for (i = 0; i < 3; i++) {
+    const reg16 period = state.exponential_counter_period[i];
+    int rate;
+    for (rate = 0; rate < 16; rate++) {
+      if (state.rate_counter_period[i] ==
+          EnvelopeGenerator::rate_counter_period[rate]) {
+        break;
+      }
+    }
+
+    if (rate == 16 ||
+        state.rate_counter[i] > 0x7fff ||
+        (period != 1 && period != 2 && period != 4 &&
+         period != 8 && period != 16 && period != 30) ||
+        state.exponential_counter[i] >= period ||
+        state.envelope_counter[i] > 0xff ||
+        !(is_valid(state.envelope_state[i],
+                   EnvelopeGenerator::ATTACK, EnvelopeGenerator::DECAY_SUSTAIN) ||
+          is_valid(state.envelope_state[i],
+                   EnvelopeGenerator::RELEASE, EnvelopeGenerator::RELEASE)) ||
+        !is_valid(state.hold_zero[i], true, false) ||
+        !is_valid(state.msb_rising[i], true, false) ||
+        // Decay stops at zero only by holding it there,
+        // the pending decrement is never left at zero either
+        (state.envelope_state[i] == EnvelopeGenerator::DECAY_SUSTAIN &&
+         state.envelope_counter[i] == 0 && !state.hold_zero[i]) ||
+        (state.envelope_pipeline[i] != 0 &&
+         (state.envelope_pipeline[i] != 1 || state.envelope_counter[i] == 0)) ||
+        state.shift_register_reset[i] < 0 ||
+        state.shift_pipeline[i] < 0 ||
+        state.floating_output_ttl[i] < 0 ||
+        state.accumulator[i] > 0xffffff ||
+        state.shift_register[i] > 0x7fffff ||
+        state.pulse_output[i] > 0xfff ||
+        state.waveform_output[i] > 0xfff ||
+        state.noise_output[i] > 0xfff) {
+      return false;
+    }
+  }
+
+  if (sid_model == MOS6581) {
+    // The integrators index the op-amp tables with the capacitor charge.
+    const Filter::model_filter_t& mf = Filter::model_filter[0];
+    if (state.filter_Vhp >> 16 != 0 ||
+        state.filter_Vbp >> 16 != 0 || state.filter_Vbp_x >> 16 != 0 ||
+        state.filter_Vlp >> 16 != 0 || state.filter_Vlp_x >> 16 != 0 ||
+        state.filter_Vbp_vc < mf.vc_min || state.filter_Vbp_vc > mf.vc_max ||
+        state.filter_Vlp_vc < mf.vc_min || state.filter_Vlp_vc > mf.vc_max) {
+      return false;
+    }
+  }
+  else {
+    if (state.filter_Vhp >> 18 < -1 || state.filter_Vhp >> 18 > 0 ||
+        state.filter_Vbp >> 18 < -1 || state.filter_Vbp >> 18 > 0 ||
+        state.filter_Vlp >> 18 < -1 || state.filter_Vlp >> 18 > 0) {
+      return false;
+    }
+  }
+
+  if (state.extfilt_Vlp >> 26 < -1 || state.extfilt_Vlp >> 26 > 0 ||
+      state.extfilt_Vhp >> 26 < -1 || state.extfilt_Vhp >> 26 > 0 ||
+      state.write_pipeline < 0 ||
+      state.write_address > 0x1f ||
+      state.sample_offset <= -cycles_per_sample ||
+      state.sample_offset > FIXP_MASK) {
+    return false;
+  }
+
+  // Write the registers directly, write() would delay them
+  // through the pipeline on the MOS8580 and only the last one
+  // would take effect.
   for (i = 0; i <= 0x18; i++) {
-    write(i, state.sid_register[i]);
+    write_address = i;
+    bus_value = state.sid_register[i];
+    write();
   }
 
   bus_value = state.bus_value;
@@ -391,7 +520,36 @@ void SID::write_state(const State& state)
     voice[i].envelope.state = state.envelope_state[i];
     voice[i].envelope.hold_zero = state.hold_zero[i];
     voice[i].envelope.envelope_pipeline = state.envelope_pipeline[i];
+
+    voice[i].wave.msb_rising = state.msb_rising[i];
+    voice[i].wave.waveform_output = state.waveform_output[i];
+    voice[i].wave.noise_output = state.noise_output[i];
+    voice[i].wave.no_noise_or_noise_output =
+      voice[i].wave.no_noise | voice[i].wave.noise_output;
+  }
+
+  filter.Vhp = state.filter_Vhp;
+  filter.Vbp = state.filter_Vbp;
+  filter.Vbp_x = state.filter_Vbp_x;
+  filter.Vbp_vc = state.filter_Vbp_vc;
+  filter.Vlp = state.filter_Vlp;
+  filter.Vlp_x = state.filter_Vlp_x;
+  filter.Vlp_vc = state.filter_Vlp_vc;
+
+  extfilt.Vlp = state.extfilt_Vlp;
+  extfilt.Vhp = state.extfilt_Vhp;
+
+  sample_offset = state.sample_offset;
+  sample_index = state.sample_index & RINGMASK;
+  sample_prev = state.sample_prev;
+  sample_now = state.sample_now;
+  if (sample) {
+    for (i = 0; i < RINGSIZE; i++) {
+      sample[i] = sample[i + RINGSIZE] = state.sample[i];
+    }
   }
+
+  return true;
 }
 
 
@@ -734,6 +892,68 @@ void SID::clock(cycle_count delta_t)
 }
 
 
+// ----------------------------------------------------------------------------
+// SID clocking with no audio production.
+// The voices are clocked cycle by cycle as in clock(), so that OSC3, ENV3
+// and the noise register are exact, but the filters are left alone.
+// Once back to normal clocking the output takes a while to settle.
+// ----------------------------------------------------------------------------
+void SID::clock_silent(cycle_count delta_t)
+{
+  int i;
+
+  // Keep the sampling phase, as clock_fast() etc. would have done,
+  // so that the samples line up after switching back.
+  const cycle_count round = sampling == SAMPLE_FAST ? 1 << (FIXP_SHIFT - 1) : 0;
+  cycle_count delta_t_phase = delta_t;
+
+  for (;;) {
+    cycle_count next_sample_offset = sample_offset + cycles_per_sample + round;
+    cycle_count delta_t_sample = next_sample_offset >> FIXP_SHIFT;
+
+    if (delta_t_sample >= delta_t_phase) {
+      sample_offset -= delta_t_phase << FIXP_SHIFT;
+      break;
+    }
+
+    delta_t_phase -= delta_t_sample;
+    sample_offset = (next_sample_offset & FIXP_MASK) - round;
+  }
+
+  for (; delta_t > 0; delta_t--) {
+    // Clock amplitude modulators.
+    for (i = 0; i < 3; i++) {
+      voice[i].envelope.clock();
+    }
+
+    // Clock oscillators.
+    for (i = 0; i < 3; i++) {
+      voice[i].wave.clock();
+    }
+
+    // Synchronize oscillators.
+    for (i = 0; i < 3; i++) {
+      voice[i].wave.synchronize();
+    }
+
+    // Calculate waveform output.
+    for (i = 0; i < 3; i++) {
+      voice[i].wave.set_waveform_output();
+    }
+
+    // Pipelined writes on the MOS8580.
+    if (unlikely(write_pipeline)) {
+      write();
+    }
+
+    // Age bus value.
+    if (unlikely(!--bus_value_ttl)) {
+      bus_value = 0;
+    }
+  }
+}
+
+
 // ----------------------------------------------------------------------------
 // SID clocking with audio sampling.
 // Fixed point arithmetics are used.
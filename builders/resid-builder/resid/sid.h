@@ -50,6 +50,7 @@ public:
   void clock();
   void clock(cycle_count delta_t);
   int clock(cycle_count& delta_t, short* buf, int n, int interleave = 1);
+  void clock_silent(cycle_count delta_t);
   void reset();
   
   // Read/write registers.
@@ -85,10 +86,28 @@ public:
     EnvelopeGenerator::State envelope_state[3];
     bool hold_zero[3];
     cycle_count envelope_pipeline[3];
+
+    bool msb_rising[3];
+    reg12 waveform_output[3];
+    unsigned short noise_output[3];
+
+    int filter_Vhp;
+    int filter_Vbp, filter_Vbp_x, filter_Vbp_vc;
+    int filter_Vlp, filter_Vlp_x, filter_Vlp_vc;
+
+    int extfilt_Vlp;
+    int extfilt_Vhp;
+
+    cycle_count sample_offset;
+    int sample_index;
+    short sample_prev, sample_now;
+    // Resampling ring buffer, RINGSIZE samples without the overflow copy.
+    short sample[1 << 14];
   };
     
   State read_state();
-  void write_state(const State& state);
+  // Returns false, leaving the SID alone, for state out of range.
+  bool write_state(const State& state);
 
   // 16-bit input (EXT IN).
   void input(short sample);
@@ -26,6 +26,8 @@
 #include <new>
 
 #include "residfp-emu.h"
+#include "residfp/FilterModelConfig.h"
+#include "residfp/resample/SincResampler.h"
 
 ReSIDfpBuilder::~ReSIDfpBuilder()
 {   // Remove all SID emulations
@@ -80,3 +82,63 @@ void ReSIDfpBuilder::filter8580Curve(double filterCurve)
 {
     std::for_each(sidobjs.begin(), sidobjs.end(), applyParameter<ReSIDfp, double>(&ReSIDfp::filter8580Curve, filterCurve));
 }
+
+uint_least64_t ReSIDfpBuilder::silentCycles() const
+{
+    uint_least64_t cycles = 0;
+    for (emuset_t::const_iterator it = sidobjs.begin(); it != sidobjs.end(); ++it)
+    {
+        cycles += static_cast<const ReSIDfp*>(*it)->silentCycles();
+    }
+    return cycles;
+}
+
+uint_least64_t ReSIDfpBuilder::skippedCycles() const
+{
+    uint_least64_t cycles = 0;
+    for (emuset_t::const_iterator it = sidobjs.begin(); it != sidobjs.end(); ++it)
+    {
+        cycles += static_cast<const ReSIDfp*>(*it)->skippedCycles();
+    }
+    return cycles;
+}
+
+void ReSIDfpBuilder::tableCache(const char *path)
+{
+    reSIDfp::FilterModelConfig::setCacheFile(path);
+}
+
+bool ReSIDfpBuilder::loadResamplerCache(const char *path)
+{
+    return reSIDfp::SincResampler::loadCache(path);
+}
+
+bool ReSIDfpBuilder::saveResamplerCache(const char *path)
+{
+    return reSIDfp::SincResampler::saveCache(path);
+}
+
+void ReSIDfpBuilder::warmUpResampler(double systemClock, unsigned int frequency)
+{
+    ReSIDfp::precomputeSampling((float)systemClock, (float)frequency);
+}
+
+void ReSIDfpBuilder::warmUpResampler()
+{
+    // CPU clocks as derived from the color burst frequency by the engine
+    const double clocks[] =
+    {
+        4433618.75 * 4. / 18.,  // PAL
+        3579545.455 * 4. / 14., // NTSC
+    };
+
+    const unsigned int frequencies[] = { 44100, 48000, 96000 };
+
+    for (unsigned int i = 0; i < sizeof(clocks) / sizeof(clocks[0]); i++)
+    {
+        for (unsigned int j = 0; j < sizeof(frequencies) / sizeof(frequencies[0]); j++)
+        {
+            warmUpResampler(clocks[i], frequencies[j]);
+        }
+    }
+}
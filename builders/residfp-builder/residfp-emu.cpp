@@ -28,13 +28,26 @@
 
 #include "residfp/siddefs-fp.h"
 #include "sidplayfp/siddefs.h"
+#include "sidstate.h"
 
 #ifdef HAVE_CONFIG_H
 #  include "config.h"
 #endif
 
+/**
+ * End of the accurate passband,
+ * half frequency rounded to the nearest multiple of 5000.
+ */
+static int highestAccurateFrequency(float freq)
+{
+    const int halfFreq = 5000*(((int)freq+5000)/10000);
+    return std::min(halfFreq, 20000);
+}
+
 const char* ReSIDfp::getCredits()
 {
+    sidlock lock(m_creditMutex);
+
     if (m_credit.empty())
     {
         // Setup credits
@@ -54,7 +67,7 @@ ReSIDfp::ReSIDfp(sidbuilder *builder) :
     sidemu(builder),
     m_sid(*(new RESID_NAMESPACE::SID))
 {
-    m_buffer = new short[OUTPUTBUFFERSIZE];
+    m_buffer = new int[OUTPUTBUFFERSIZE];
     reset (0);
 }
 
@@ -62,6 +75,7 @@ ReSIDfp::~ReSIDfp()
 {
     delete &m_sid;
     delete[] m_buffer;
+    delete[] m_stemBuffer;
 }
 
 void ReSIDfp::filter6581Curve(double filterCurve)
@@ -98,7 +112,73 @@ void ReSIDfp::clock()
 {
     const event_clock_t cycles = m_context->getTime(m_accessClk, EVENT_CLOCK_PHI1);
     m_accessClk += cycles;
-    m_bufferpos += m_sid.clock(cycles, m_buffer+m_bufferpos);
+
+    if (m_silent)
+    {
+        m_sid.clockSilent(cycles);
+    }
+    else if (m_stemBuffer)
+    {
+        int* const stemBuf[3] =
+        {
+            stemBuffer(0) + m_bufferpos,
+            stemBuffer(1) + m_bufferpos,
+            stemBuffer(2) + m_bufferpos
+        };
+        m_bufferpos += m_sid.clock(cycles, m_buffer+m_bufferpos, stemBuf);
+    }
+    else
+    {
+        m_bufferpos += m_sid.clock(cycles, m_buffer+m_bufferpos);
+    }
+}
+
+bool ReSIDfp::stems(SidConfig::stem_mode_t mode)
+{
+    reSIDfp::StemMode stemMode;
+    switch (mode)
+    {
+    case SidConfig::STEMS_OFF:
+        stemMode = reSIDfp::STEMS_OFF;
+        break;
+    case SidConfig::STEMS_UNFILTERED:
+        stemMode = reSIDfp::STEMS_UNFILTERED;
+        break;
+    case SidConfig::STEMS_FILTERED:
+        stemMode = reSIDfp::STEMS_FILTERED;
+        break;
+    default:
+        return false;
+    }
+
+    m_sid.setStems(stemMode);
+
+    delete[] m_stemBuffer;
+    m_stemBuffer = 0;
+
+    // Samples not mixed yet have no stems, they start silent
+    if (stemMode != reSIDfp::STEMS_OFF)
+        m_stemBuffer = new int[3 * OUTPUTBUFFERSIZE]();
+
+    return true;
+}
+
+bool ReSIDfp::serializeChip(sidstate &s)
+{
+    std::vector<uint8_t> state;
+
+    if (s.saving())
+    {
+        m_sid.saveState(state);
+        s.io(state);
+        return true;
+    }
+
+    s.io(state);
+    if (s.failed() || state.empty())
+        return false;
+
+    return m_sid.loadState(&state[0], state.size());
 }
 
 void ReSIDfp::filter(bool enable)
@@ -126,9 +206,7 @@ void ReSIDfp::sampling(float systemclock, float freq,
 
     try
     {
-        // Round half frequency to the nearest multiple of 5000
-        const int halfFreq = 5000*(((int)freq+5000)/10000);
-        m_sid.setSamplingParameters (systemclock, sampleMethod, freq, std::min(halfFreq, 20000));
+        m_sid.setSamplingParameters (systemclock, sampleMethod, freq, highestAccurateFrequency(freq));
     }
     catch (RESID_NAMESPACE::SIDError const &e)
     {
@@ -140,6 +218,11 @@ void ReSIDfp::sampling(float systemclock, float freq,
     m_status = true;
 }
 
+void ReSIDfp::precomputeSampling(float systemclock, float freq)
+{
+    RESID_NAMESPACE::SID::precomputeResampler(systemclock, freq, highestAccurateFrequency(freq));
+}
+
 // Set the emulated SID model
 void ReSIDfp::model(SidConfig::sid_model_t model)
 {
@@ -39,6 +39,9 @@ class ReSIDfp: public sidemu
 private:
     RESID_NAMESPACE::SID &m_sid;
 
+protected:
+    bool serializeChip(sidstate &s);
+
 public:
     static const char* getCredits();
 
@@ -57,6 +60,7 @@ public:
     void clock();
     void filter(bool enable);
     void voice(unsigned int num, bool mute) { m_sid.mute(num, mute); }
+    bool stems(SidConfig::stem_mode_t mode);
 
     bool getStatus() const { return m_status; }
 
@@ -64,9 +68,14 @@ public:
     void sampling(float systemclock, float freq,
         SidConfig::sampling_method_t method, bool fast);
 
+    static void precomputeSampling(float systemclock, float freq);
+
     void filter6581Curve(double filterCurve);
     void filter8580Curve(double filterCurve);
     void model(SidConfig::sid_model_t model);
+
+    uint_least64_t silentCycles() const { return m_sid.getSilentCycles(); }
+    uint_least64_t skippedCycles() const { return m_sid.getSkippedCycles(); }
 };
 
 #endif // RESIDFP_EMU_H
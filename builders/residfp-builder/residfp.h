@@ -23,6 +23,8 @@
 #ifndef RESIDFP_H
 #define RESIDFP_H
 
+#include <stdint.h>
+
 #include "sidplayfp/sidbuilder.h"
 #include "sidplayfp/siddefs.h"
 
@@ -74,6 +76,59 @@ public:
      */
     void filter8580Curve(double filterCurve);
     //@}
+
+    /// @name statistics
+    /// Counters summed over all SIDs since their last reset.
+    //@{
+    /**
+     * Cycles emulated with all the voices silent.
+     */
+    uint_least64_t silentCycles() const;
+
+    /**
+     * Silent cycles where the filters had settled
+     * and their emulation was skipped.
+     */
+    uint_least64_t skippedCycles() const;
+    //@}
+
+    /**
+     * Set a file used to cache the 6581 filter tables.
+     * The tables are built on first use, which takes a while,
+     * and stored there so later runs can map them directly.
+     * Must be called before creating the first emu.
+     *
+     * @param path the cache file, 0 to disable
+     */
+    static void tableCache(const char *path);
+
+    /**
+     * Load resampling filters saved with #saveResamplerCache.
+     *
+     * @param path the cache file
+     * @return false if the file can't be read or is corrupted
+     */
+    static bool loadResamplerCache(const char *path);
+
+    /**
+     * Save all the resampling filters computed so far.
+     *
+     * @param path the cache file
+     * @return false on write errors
+     */
+    static bool saveResamplerCache(const char *path);
+
+    /**
+     * Compute the resampling filters for the given
+     * clock and sample rate ahead of time.
+     * Without arguments the common PAL and NTSC
+     * at 44.1, 48 and 96 kHz combinations are computed.
+     *
+     * @param systemClock the emulated CPU clock in Hz
+     * @param frequency the output sample rate in Hz
+     */
+    static void warmUpResampler(double systemClock, unsigned int frequency);
+    static void warmUpResampler();
 };
 
 #endif // RESIDFP_H
@@ -24,7 +24,10 @@
 
 #include "EnvelopeGenerator.h"
 
+#include <algorithm>
+
 #include "Dac.h"
+#include "StateStream.h"
 
 namespace reSIDfp
 {
@@ -117,6 +120,50 @@ void EnvelopeGenerator::setChipModel(ChipModel chipModel)
     }
 }
 
+void EnvelopeGenerator::serialize(StateStream& s)
+{
+    s.io(lfsr);
+    s.io(rate);
+    s.io(exponential_counter);
+    s.io(exponential_counter_period);
+    s.io(attack);
+    s.io(decay);
+    s.io(sustain);
+    s.io(release);
+
+    // Restored as an int, an invalid State can't even be compared
+    int stateValue = state;
+    s.io(stateValue);
+    s.io(hold_zero);
+    s.io(envelope_pipeline);
+    s.io(gate);
+    s.io(envelope_counter);
+
+    if (!s.saving())
+    {
+        // The registers index adsrtable, the rate must come from it
+        // and the exponential counter must be able to reach its period
+        const bool periodValid =
+            exponential_counter_period == 1 || exponential_counter_period == 2
+            || exponential_counter_period == 4 || exponential_counter_period == 8
+            || exponential_counter_period == 16 || exponential_counter_period == 30;
+
+        if (((attack | decay | sustain | release) & ~0xf) != 0
+            || (lfsr & ~0x7fff) != 0
+            || std::find(adsrtable, adsrtable + 16, rate) == adsrtable + 16
+            || !periodValid
+            || exponential_counter < 0 || exponential_counter >= exponential_counter_period
+            || (stateValue != ATTACK && stateValue != DECAY_SUSTAIN && stateValue != RELEASE))
+        {
+            s.fail();
+        }
+        else
+        {
+            state = static_cast<State>(stateValue);
+        }
+    }
+}
+
 void EnvelopeGenerator::reset()
 {
     envelope_counter = 0;
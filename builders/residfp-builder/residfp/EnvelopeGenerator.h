@@ -28,6 +28,8 @@
 namespace reSIDfp
 {
 
+class StateStream;
+
 /**
  * A 15 bit [LFSR] is used to implement the envelope rates, in effect dividing
  * the clock to the envelope counter by the currently selected rate period.
@@ -142,6 +144,12 @@ public:
      */
     short output() const { return dac[envelope_counter]; }
 
+    /**
+     * Check whether the envelope is frozen with no output.
+     * Only switching to attack can change this.
+     */
+    bool isSilent() const { return hold_zero && !envelope_pipeline && dac[envelope_counter] == 0; }
+
     /**
      * Constructor.
      */
@@ -165,6 +173,11 @@ public:
      */
     void reset();
 
+    /**
+     * Save or restore the envelope state.
+     */
+    void serialize(StateStream& s);
+
     /**
      * Write control register.
      *
@@ -24,6 +24,8 @@
 
 #include "ExternalFilter.h"
 
+#include "StateStream.h"
+
 namespace reSIDfp
 {
 
@@ -44,6 +46,20 @@ void ExternalFilter::setClockFrequency(double frequency)
     w0hp_1_s17 = (int)(100. / frequency * (1 << 17) + 0.5);
 }
 
+void ExternalFilter::serialize(StateStream& s)
+{
+    s.io(Vlp);
+    s.io(Vhp);
+
+    // Both follow the 16 bit input scaled by 2^11,
+    // anything larger overflows clock()
+    if (!s.saving()
+        && (Vlp < -(1 << 26) || Vlp > (1 << 26) || Vhp < -(1 << 26) || Vhp > (1 << 26)))
+    {
+        s.fail();
+    }
+}
+
 void ExternalFilter::reset()
 {
     // State of filter.
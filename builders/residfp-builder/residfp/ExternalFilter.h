@@ -28,6 +28,8 @@
 namespace reSIDfp
 {
 
+class StateStream;
+
 /**
  * The audio output stage in a Commodore 64 consists of two STC networks, a
  * low-pass filter with 3-dB frequency 16kHz followed by a high-pass filter with
@@ -65,6 +67,16 @@ public:
      */
     int clock(int Vi);
 
+    /**
+     * Clock the filter and check whether it has settled.
+     *
+     * @param Vi input
+     * @param out the filter output
+     * @return true if the state didn't change, so the output
+     *         is going to stay the same as long as the input does
+     */
+    bool clockSettled(int Vi, int& out);
+
     /**
      * Constructor.
      */
@@ -81,6 +93,11 @@ public:
      * SID reset.
      */
     void reset();
+
+    /**
+     * Save or restore the filter state.
+     */
+    void serialize(StateStream& s);
 };
 
 } // namespace reSIDfp
@@ -100,6 +117,15 @@ int ExternalFilter::clock(int Vi)
     return (Vlp - Vhp) >> 11;
 }
 
+RESID_INLINE
+bool ExternalFilter::clockSettled(int Vi, int& out)
+{
+    const int oldVlp = Vlp;
+    const int oldVhp = Vhp;
+    out = clock(Vi);
+    return Vlp == oldVlp && Vhp == oldVhp;
+}
+
 } // namespace reSIDfp
 
 #endif
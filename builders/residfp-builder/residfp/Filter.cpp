@@ -22,6 +22,8 @@
 
 #include "Filter.h"
 
+#include "StateStream.h"
+
 namespace reSIDfp
 {
 
@@ -36,6 +38,7 @@ void Filter::enable(bool enable)
     else
     {
         filt1 = filt2 = filt3 = filtE = false;
+        updatedMixing();
     }
 }
 
@@ -47,6 +50,47 @@ void Filter::reset()
     writeRES_FILT(0);
 }
 
+unsigned char Filter::readMODE_VOL() const
+{
+    return vol
+        | (lp ? 0x10 : 0)
+        | (bp ? 0x20 : 0)
+        | (hp ? 0x40 : 0)
+        | (voice3off ? 0x80 : 0);
+}
+
+void Filter::serialize(StateStream& s)
+{
+    unsigned char mode_vol = readMODE_VOL();
+
+    s.io(fc);
+    s.io(filt);
+    s.io(mode_vol);
+
+    if (!s.saving())
+    {
+        // The cutoff indexes the 11 bit DAC tables
+        if ((fc & ~0x7ffu) != 0)
+        {
+            s.fail();
+            fc &= 0x7ff;
+        }
+
+        updatedCenterFrequency();
+        writeRES_FILT(filt);
+        writeMODE_VOL(mode_vol);
+    }
+}
+
+void Filter::copyRegisters(const Filter& other)
+{
+    writeFC_LO(other.fc & 0x007);
+    writeFC_HI(other.fc >> 3);
+    writeRES_FILT(other.filt);
+    writeMODE_VOL(other.readMODE_VOL());
+    enable(other.enabled);
+}
+
 void Filter::writeFC_LO(unsigned char fc_lo)
 {
     fc = (fc & 0x7f8) | (fc_lo & 0x007);
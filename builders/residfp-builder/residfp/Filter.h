@@ -26,6 +26,8 @@
 namespace reSIDfp
 {
 
+class StateStream;
+
 /**
  * SID filter base class
  */
@@ -57,6 +59,11 @@ private:
     /// Selects which inputs to route through filter.
     unsigned char filt;
 
+    /**
+     * Get the value of the Mode/Volume register.
+     */
+    unsigned char readMODE_VOL() const;
+
 protected:
     /**
      * Set filter cutoff frequency.
@@ -101,6 +108,17 @@ public:
      */
     virtual int clock(int v1, int v2, int v3) = 0;
 
+    /**
+     * Clock the filter with all the voices silent
+     * and check whether it has settled.
+     *
+     * @param out the filter output
+     * @return true if the state didn't change, so the output
+     *         is going to stay the same as long as the input does.
+     *         By default the filter is never reported as settled.
+     */
+    virtual bool clockSettled(int& out) { out = clock(0, 0, 0); return false; }
+
     /**
      * Enable filter.
      *
@@ -113,6 +131,20 @@ public:
      */
     void reset();
 
+    /**
+     * Save or restore the filter registers.
+     * Derived filters add their own state.
+     */
+    virtual void serialize(StateStream& s);
+
+    /**
+     * Take the register values and the enable state of another filter.
+     * The state of the filter itself is left alone.
+     *
+     * @param other the filter to copy from
+     */
+    void copyRegisters(const Filter& other);
+
     /**
      * Write Frequency Cutoff Low register.
      *
@@ -24,6 +24,8 @@
 
 #include "Filter6581.h"
 
+#include "StateStream.h"
+
 namespace reSIDfp
 {
 
@@ -32,6 +34,20 @@ Filter6581::~Filter6581()
     delete [] f0_dac;
 }
 
+bool Filter6581::clockSettled(int& out)
+{
+    const int oldVhp = Vhp;
+    const int oldVbp = Vbp;
+    const int oldVlp = Vlp;
+    const Integrator oldHp(*hpIntegrator);
+    const Integrator oldBp(*bpIntegrator);
+
+    out = clock(0, 0, 0);
+
+    return Vhp == oldVhp && Vbp == oldVbp && Vlp == oldVlp
+        && *hpIntegrator == oldHp && *bpIntegrator == oldBp;
+}
+
 void Filter6581::updatedCenterFrequency()
 {
     const unsigned short Vw = f0_dac[fc];
@@ -81,6 +97,28 @@ void Filter6581::updatedMixing()
     currentMixer = mixer[no];
 }
 
+void Filter6581::serialize(StateStream& s)
+{
+    Filter::serialize(s);
+
+    s.io(Vhp);
+    s.io(Vbp);
+    s.io(Vlp);
+    s.io(ve);
+
+    // The filter voltages index the summer, resonance and mixer tables,
+    // reset doesn't touch them so they can't be left as they are
+    if (!s.saving() && ((Vhp | Vbp | Vlp | ve) & ~0xffff) != 0)
+    {
+        s.fail();
+        Vhp = Vbp = Vlp = 0;
+        ve = mixer[0][0];
+    }
+
+    hpIntegrator->serialize(s);
+    bpIntegrator->serialize(s);
+}
+
 void Filter6581::setFilterCurve(double curvePosition)
 {
     delete [] f0_dac;
@@ -385,6 +385,10 @@ public:
 
     int clock(int voice1, int voice2, int voice3);
 
+    bool clockSettled(int& out);
+
+    void serialize(StateStream& s);
+
     void input(int sample) { ve = (sample * voiceScaleS14 * 3 >> 10) + mixer[0][0]; }
 
     /**
@@ -22,4 +22,37 @@
 
 #include "Filter8580.h"
 
+#include <cmath>
+
+#include "StateStream.h"
+
 // This is needed when compiling with --disable-inline
+
+namespace reSIDfp
+{
+
+void Filter8580::serialize(StateStream& s)
+{
+    Filter::serialize(s);
+
+    s.io(Vlp);
+    s.io(Vbp);
+    s.io(Vhp);
+    s.io(ve);
+    s.io(noise);
+
+    // About twice what the filter reaches, NaN fails as well,
+    // the output would overflow the external filter.
+    // Reset doesn't touch them so they can't be left as they are.
+    const float limit = 1 << 15;
+    if (!s.saving()
+        && (!(std::fabs(Vlp) <= limit) || !(std::fabs(Vbp) <= limit) || !(std::fabs(Vhp) <= limit)
+            || ve < -(1 << 15) || ve > (1 << 15) || (ve & 0xf) != 0))
+    {
+        s.fail();
+        Vlp = Vbp = Vhp = 0.f;
+        ve = 0;
+    }
+}
+
+} // namespace reSIDfp
@@ -104,6 +104,8 @@ public:
 
     int clock(int voice1, int voice2, int voice3);
 
+    void serialize(StateStream& s);
+
     /**
      * Set filter cutoff frequency.
      */
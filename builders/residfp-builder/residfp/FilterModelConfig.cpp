@@ -22,12 +22,29 @@
 
 #include "FilterModelConfig.h"
 
+#include <stdint.h>
+
 #include <cmath>
 #include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 
 #include "Dac.h"
 #include "Integrator.h"
 #include "OpAmp.h"
+#include "Mutex.h"
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#ifdef HAVE_SYS_MMAN_H
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#endif
 
 namespace reSIDfp
 {
@@ -75,10 +92,48 @@ const Spline::Point FilterModelConfig::opamp_voltage[OPAMP_SIZE] =
   { 10.31,  0.81 },  // Approximate end of actual range
 };
 
+/**
+ * Total size of the lookup tables:
+ * opamp_rev, vcr_kVg and vcr_n_Ids_term, 20 summer slices,
+ * 28 mixer slices plus the single entry of mixer[0] and 16 gain tables.
+ */
+static const size_t TABLES_SIZE = (3 + 20 + 28 + 16) * (1 << 16) + 1;
+
+/**
+ * Bump when the table generation changes
+ * in ways not covered by the parameters hash.
+ */
+static const uint32_t CACHE_VERSION = 1;
+
+static const char CACHE_MAGIC[8] = { 'R', 'S', 'F', 'P', 'F', 'M', 'C', 0 };
+
+/**
+ * Header of the cache file, followed by the tables in native byte order.
+ * A file written on a machine with different endianness
+ * or floating point layout fails the hash check and gets rebuilt.
+ */
+struct CacheHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t hash;
+    uint32_t size;
+    uint32_t reserved;
+};
+
+static const size_t CACHE_FILE_SIZE = sizeof(CacheHeader) + TABLES_SIZE * sizeof(unsigned short);
+
 std::auto_ptr<FilterModelConfig> FilterModelConfig::instance(0);
 
+std::string FilterModelConfig::cacheFile;
+
+/// Serializes creation of the shared instance.
+static Mutex instanceMutex;
+
 FilterModelConfig* FilterModelConfig::getInstance()
 {
+    MutexLock lock(instanceMutex);
+
     if (!instance.get())
     {
         instance.reset(new FilterModelConfig());
@@ -87,6 +142,13 @@ FilterModelConfig* FilterModelConfig::getInstance()
     return instance.get();
 }
 
+void FilterModelConfig::setCacheFile(const char* path)
+{
+    MutexLock lock(instanceMutex);
+
+    cacheFile = path ? path : "";
+}
+
 FilterModelConfig::FilterModelConfig() :
     voice_voltage_range(1.5),
     voice_DC_voltage(5.0),
@@ -105,12 +167,204 @@ FilterModelConfig::FilterModelConfig() :
     vmax(kVddt < opamp_voltage[0].y ? opamp_voltage[0].y : kVddt),
     denorm(vmax - vmin),
     norm(1.0 / denorm),
-    N16(norm * ((1 << 16) - 1))
+    N16(norm * ((1 << 16) - 1)),
+    tables(0),
+    tablesMapped(false)
 {
-    // Convert op-amp voltage transfer to 16 bit values.
-
     Dac::kinkedDac(dac, DAC_BITS, 2.2, false);
 
+    if (cacheFile.empty() || !loadCache(cacheFile.c_str()))
+    {
+        tables = new unsigned short[TABLES_SIZE];
+        setupTables();
+        buildTables();
+
+        if (!cacheFile.empty())
+        {
+            saveCache(cacheFile.c_str());
+        }
+    }
+}
+
+FilterModelConfig::~FilterModelConfig()
+{
+    if (tablesMapped)
+    {
+#ifdef HAVE_SYS_MMAN_H
+        munmap(reinterpret_cast<char*>(tables) - sizeof(CacheHeader), CACHE_FILE_SIZE);
+#endif
+    }
+    else
+    {
+        delete [] tables;
+    }
+}
+
+unsigned int FilterModelConfig::parametersHash() const
+{
+    const double params[] =
+    {
+        voice_voltage_range, voice_DC_voltage, C,
+        Vdd, Vth, Ut, k, uCox, WL_vcr, WL_snake,
+        vmin, vmax, N16
+    };
+
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(params);
+    for (size_t i = 0; i < sizeof(params); i++)
+    {
+        hash = (hash ^ p[i]) * 16777619u;
+    }
+
+    p = reinterpret_cast<const unsigned char*>(opamp_voltage);
+    for (size_t i = 0; i < sizeof(opamp_voltage); i++)
+    {
+        hash = (hash ^ p[i]) * 16777619u;
+    }
+
+    return hash;
+}
+
+void FilterModelConfig::setupTables()
+{
+    unsigned short* p = tables;
+
+    opamp_rev = p;
+    p += 1 << 16;
+
+    vcr_kVg = p;
+    p += 1 << 16;
+
+    vcr_n_Ids_term = p;
+    p += 1 << 16;
+
+    for (int i = 0; i < 5; i++)
+    {
+        summer[i] = p;
+        p += (2 + i) << 16;
+    }
+
+    for (int i = 0; i < 8; i++)
+    {
+        mixer[i] = p;
+        p += (i == 0) ? 1 : i << 16;
+    }
+
+    for (int i = 0; i < 16; i++)
+    {
+        gain[i] = p;
+        p += 1 << 16;
+    }
+
+    assert(p == tables + TABLES_SIZE);
+}
+
+bool FilterModelConfig::loadCache(const char* path)
+{
+    CacheHeader expected;
+    memcpy(expected.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    expected.version = CACHE_VERSION;
+    expected.hash = parametersHash();
+    expected.size = (uint32_t)TABLES_SIZE;
+    expected.reserved = 0;
+
+#ifdef HAVE_SYS_MMAN_H
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size != CACHE_FILE_SIZE)
+    {
+        close(fd);
+        return false;
+    }
+
+    // Pages are loaded on demand and shared with other processes
+    void* map = mmap(0, CACHE_FILE_SIZE, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (map == MAP_FAILED)
+        return false;
+
+    if (memcmp(map, &expected, sizeof(CacheHeader)) != 0)
+    {
+        munmap(map, CACHE_FILE_SIZE);
+        return false;
+    }
+
+    // Mapped read only, the tables are never written after being built
+    tables = reinterpret_cast<unsigned short*>(static_cast<char*>(map) + sizeof(CacheHeader));
+    tablesMapped = true;
+#else
+    std::ifstream in(path, std::ios::in | std::ios::binary);
+
+    CacheHeader header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(CacheHeader))
+        || memcmp(&header, &expected, sizeof(CacheHeader)) != 0)
+    {
+        return false;
+    }
+
+    unsigned short* data = new unsigned short[TABLES_SIZE];
+
+    if (!in.read(reinterpret_cast<char*>(data), TABLES_SIZE * sizeof(unsigned short)))
+    {
+        delete [] data;
+        return false;
+    }
+
+    tables = data;
+#endif
+
+    setupTables();
+    return true;
+}
+
+void FilterModelConfig::saveCache(const char* path) const
+{
+    CacheHeader header;
+    memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = CACHE_VERSION;
+    header.hash = parametersHash();
+    header.size = (uint32_t)TABLES_SIZE;
+    header.reserved = 0;
+
+    // Write to a temporary file and rename it so that
+    // other processes never see a partial cache.
+    const std::string tmpPath = std::string(path) + ".tmp";
+
+    {
+        std::ofstream out(tmpPath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+        out.write(reinterpret_cast<const char*>(&header), sizeof(CacheHeader));
+        out.write(reinterpret_cast<const char*>(tables), TABLES_SIZE * sizeof(unsigned short));
+
+        if (!out.good())
+        {
+            out.close();
+            std::remove(tmpPath.c_str());
+            return;
+        }
+    }
+
+    if (std::rename(tmpPath.c_str(), path) != 0)
+    {
+        // Rename doesn't replace existing files everywhere
+        std::remove(path);
+        if (std::rename(tmpPath.c_str(), path) != 0)
+        {
+            std::remove(tmpPath.c_str());
+        }
+    }
+}
+
+void FilterModelConfig::buildTables()
+{
+    // Convert op-amp voltage transfer to 16 bit values.
+
     Spline::Point scaled_voltage[OPAMP_SIZE];
 
     for (unsigned int i = 0; i < OPAMP_SIZE; i++)
@@ -148,7 +402,6 @@ FilterModelConfig::FilterModelConfig() :
         const int size = idiv << 16;
         const double n = idiv;
         opampModel.reset();
-        summer[i] = new unsigned short[size];
 
         for (int vi = 0; vi < size; vi++)
         {
@@ -170,7 +423,6 @@ FilterModelConfig::FilterModelConfig() :
         const int size = (i == 0) ? 1 : i << 16;
         const double n = i * 8.0 / 6.0;
         opampModel.reset();
-        mixer[i] = new unsigned short[size];
 
         for (int vi = 0; vi < size; vi++)
         {
@@ -191,7 +443,6 @@ FilterModelConfig::FilterModelConfig() :
         const int size = 1 << 16;
         const double n = n8 / 8.0;
         opampModel.reset();
-        gain[n8] = new unsigned short[size];
 
         for (int vi = 0; vi < size; vi++)
         {
@@ -248,24 +499,6 @@ FilterModelConfig::FilterModelConfig() :
     }
 }
 
-FilterModelConfig::~FilterModelConfig()
-{
-    for (int i = 0; i < 5; i++)
-    {
-        delete [] summer[i];
-    }
-
-    for (int i = 0; i < 8; i++)
-    {
-        delete [] mixer[i];
-    }
-
-    for (int i = 0; i < 16; i++)
-    {
-        delete [] gain[i];
-    }
-}
-
 unsigned short* FilterModelConfig::getDAC(double adjustment) const
 {
     const double dac_zero = getDacZero(adjustment);
@@ -24,6 +24,7 @@
 #define FILTERMODELCONFIG_H
 
 #include <memory>
+#include <string>
 
 #include "Spline.h"
 
@@ -46,6 +47,9 @@ private:
     // This allows access to the private constructor
     friend class std::auto_ptr<FilterModelConfig>;
 
+    /// Path of the table cache, empty if disabled.
+    static std::string cacheFile;
+
     static const Spline::Point opamp_voltage[OPAMP_SIZE];
 
     const double voice_voltage_range;
@@ -79,6 +83,15 @@ private:
     /// Fixed point scaling for 16 bit op-amp output.
     const double N16;
 
+    /**
+     * All the lookup tables in a single block,
+     * either allocated or mapped from the cache file.
+     */
+    //@{
+    unsigned short* tables;
+    bool tablesMapped;
+    //@}
+
     /// Lookup tables for gain and summer op-amps in output stage / filter.
     //@{
     unsigned short* mixer[8];
@@ -91,22 +104,65 @@ private:
 
     /// VCR - 6581 only.
     //@{
-    unsigned short vcr_kVg[1 << 16];
-    unsigned short vcr_n_Ids_term[1 << 16];
+    unsigned short* vcr_kVg;
+    unsigned short* vcr_n_Ids_term;
     //@}
 
     /// Reverse op-amp transfer function.
-    unsigned short opamp_rev[1 << 16];
+    unsigned short* opamp_rev;
 
 private:
     double getDacZero(double adjustment) const { return dac_zero - (adjustment - 0.5) * 2.; }
 
+    /**
+     * Hash of the model parameters, identifies
+     * the tables stored in the cache.
+     */
+    unsigned int parametersHash() const;
+
+    /**
+     * Point the table pointers into the table block.
+     */
+    void setupTables();
+
+    /**
+     * Solve the op-amp model to fill the tables.
+     */
+    void buildTables();
+
+    /**
+     * Map the tables from the cache file.
+     *
+     * @return false if the file is missing or doesn't match
+     */
+    bool loadCache(const char* path);
+
+    /**
+     * Store the tables in the cache file.
+     */
+    void saveCache(const char* path) const;
+
     FilterModelConfig();
     ~FilterModelConfig();
 
 public:
+    /**
+     * Get the shared instance, creating it on first use.
+     * Safe to call from multiple threads.
+     */
     static FilterModelConfig* getInstance();
 
+    /**
+     * Set a file where the tables are stored after being built,
+     * so later runs can map them instead of solving the op-amp model.
+     * The file is validated against the model parameters
+     * and rewritten when stale.
+     * Has no effect once the instance has been created.
+     *
+     * @param path the cache file, 0 to disable
+     */
+    static void setCacheFile(const char* path);
+
     /**
      * The digital range of one voice is 20 bits; create a scaling term
      * for multiplication which fits in 11 bits.
@@ -22,4 +22,25 @@
 
 #include "Integrator.h"
 
+#include "StateStream.h"
+
 // This is needed when compiling with --disable-inline
+
+namespace reSIDfp
+{
+
+void Integrator::serialize(StateStream& s)
+{
+    s.io(vx);
+    s.io(vc);
+
+    // Both index the op-amp tables, see solve()
+    if (!s.saving() && ((vx & ~0xffff) != 0 || vc < -(1 << 30) || vc >= (1 << 30)))
+    {
+        s.fail();
+        vx = 0;
+        vc = 0;
+    }
+}
+
+} // namespace reSIDfp
@@ -31,6 +31,8 @@
 namespace reSIDfp
 {
 
+class StateStream;
+
 /**
  * Find output voltage in inverting integrator SID op-amp circuits, using a
  * single fixpoint iteration step.
@@ -179,6 +181,16 @@ public:
     void setVw(unsigned short Vw) { Vddt_Vw_2 = (kVddt - Vw) * (kVddt - Vw) >> 1; }
 
     int solve(int vi);
+
+    /**
+     * Save or restore the integrator state.
+     */
+    void serialize(StateStream& s);
+
+    /**
+     * Check whether two integrators are in the same state.
+     */
+    bool operator==(const Integrator& other) const { return vx == other.vx && vc == other.vc; }
 };
 
 } // namespace reSIDfp
@@ -0,0 +1,100 @@
+/*
+ * This file is part of libsidplayfp, a SID player engine.
+ *
+ * Copyright 2011-2014 Leandro Nini <drfiemost@users.sourceforge.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef MUTEX_H
+#define MUTEX_H
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#if defined(_WIN32)
+#  include <windows.h>
+#elif defined(HAVE_PTHREAD_H)
+#  include <pthread.h>
+#endif
+
+namespace reSIDfp
+{
+
+/**
+ * Mutual exclusion lock protecting the tables shared among SID instances.
+ *
+ * Uses a critical section on Windows and pthreads where available,
+ * otherwise it does nothing as there are no threads to protect from.
+ */
+class Mutex
+{
+private:
+#if defined(_WIN32)
+    CRITICAL_SECTION m_mutex;
+#elif defined(HAVE_PTHREAD_H)
+    pthread_mutex_t m_mutex;
+#endif
+
+private:
+    // prevent copying
+    Mutex(const Mutex&);
+    Mutex& operator=(const Mutex&);
+
+public:
+#if defined(_WIN32)
+    Mutex() { InitializeCriticalSection(&m_mutex); }
+    ~Mutex() { DeleteCriticalSection(&m_mutex); }
+
+    void lock() { EnterCriticalSection(&m_mutex); }
+    void unlock() { LeaveCriticalSection(&m_mutex); }
+#elif defined(HAVE_PTHREAD_H)
+    Mutex() { pthread_mutex_init(&m_mutex, 0); }
+    ~Mutex() { pthread_mutex_destroy(&m_mutex); }
+
+    void lock() { pthread_mutex_lock(&m_mutex); }
+    void unlock() { pthread_mutex_unlock(&m_mutex); }
+#else
+    Mutex() {}
+
+    void lock() {}
+    void unlock() {}
+#endif
+};
+
+/**
+ * Holds a Mutex for the lifetime of the object.
+ */
+class MutexLock
+{
+private:
+    Mutex &m_mutex;
+
+private:
+    // prevent copying
+    MutexLock(const MutexLock&);
+    MutexLock& operator=(const MutexLock&);
+
+public:
+    MutexLock(Mutex &mutex) :
+        m_mutex(mutex) { m_mutex.lock(); }
+
+    ~MutexLock() { m_mutex.unlock(); }
+};
+
+} // namespace reSIDfp
+
+#endif
@@ -25,12 +25,15 @@
 #include "SID.h"
 
 #include <limits>
+#include <memory>
 
 #include "array.h"
 #include "Filter6581.h"
 #include "Filter8580.h"
 #include "Potentiometer.h"
+#include "StateStream.h"
 #include "WaveformCalculator.h"
+#include "resample/PolyphaseResampler.h"
 #include "resample/TwoPassSincResampler.h"
 #include "resample/ZeroOrderResampler.h"
 
@@ -49,18 +52,45 @@ const int BUS_TTL_6581 = 0x1000;
 const int BUS_TTL_8580 = 0xa2000;
 //@}
 
+/**
+ * A voice rendered on its own, through copies
+ * of the filters and of the resampler.
+ */
+struct SID::Stem
+{
+    Filter6581 filter6581;
+    Filter8580 filter8580;
+    ExternalFilter externalFilter;
+    std::auto_ptr<Resampler> resampler;
+
+    /// Filter of the current chip model.
+    Filter* filter;
+
+    Stem() :
+        filter(&filter6581) {}
+};
+
 SID::SID() :
     filter6581(new Filter6581()),
     filter8580(new Filter8580()),
     externalFilter(new ExternalFilter()),
     resampler(0),
     potX(new Potentiometer()),
-    potY(new Potentiometer())
+    potY(new Potentiometer()),
+    clockFrequency(0.),
+    samplingFrequency(0.),
+    highestAccurateFrequency(0.),
+    samplingMethod(DECIMATE),
+    filter6581Curve(0.5),
+    filter8580Curve(12500.),
+    stemMode(STEMS_OFF)
 {
     voice[0] = new Voice();
     voice[1] = new Voice();
     voice[2] = new Voice();
 
+    stem[0] = stem[1] = stem[2] = 0;
+
     muted[0] = muted[1] = muted[2] = false;
 
     reset();
@@ -78,26 +108,140 @@ SID::~SID()
     delete voice[1];
     delete voice[2];
     delete resampler;
+    delete stem[0];
+    delete stem[1];
+    delete stem[2];
 }
 
 void SID::setFilter6581Curve(double filterCurve)
 {
     filter6581->setFilterCurve(filterCurve);
+    filter6581Curve = filterCurve;
+
+    for (int i = 0; i < 3; i++)
+    {
+        if (stem[i] != 0)
+            stem[i]->filter6581.setFilterCurve(filterCurve);
+    }
+
+    settled = false;
 }
 
 void SID::setFilter8580Curve(double filterCurve)
 {
     filter8580->setFilterCurve(filterCurve);
+    filter8580Curve = filterCurve;
+
+    for (int i = 0; i < 3; i++)
+    {
+        if (stem[i] != 0)
+            stem[i]->filter8580.setFilterCurve(filterCurve);
+    }
+
+    settled = false;
 }
 
 void SID::enableFilter(bool enable)
 {
     filter6581->enable(enable);
     filter8580->enable(enable);
+    updateStems();
+    settled = false;
+}
+
+void SID::setStems(StemMode mode)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        delete stem[i];
+        stem[i] = 0;
+    }
+
+    stemMode = mode;
+    settled = false;
+
+    if (mode == STEMS_OFF)
+        return;
+
+    for (int i = 0; i < 3; i++)
+    {
+        stem[i] = new Stem();
+        stem[i]->filter6581.setFilterCurve(filter6581Curve);
+        stem[i]->filter8580.setFilterCurve(filter8580Curve);
+
+        if (resampler != 0)
+        {
+            stem[i]->externalFilter.setClockFrequency(clockFrequency);
+            stem[i]->resampler.reset(createResampler());
+        }
+    }
+
+    updateStems();
+}
+
+void SID::updateStems()
+{
+    for (int i = 0; i < 3; i++)
+    {
+        Stem* const s = stem[i];
+        if (s == 0)
+            continue;
+
+        s->filter6581.copyRegisters(*filter6581);
+        s->filter8580.copyRegisters(*filter8580);
+
+        if (stemMode == STEMS_UNFILTERED)
+        {
+            s->filter6581.enable(false);
+            s->filter8580.enable(false);
+        }
+
+        if (model == MOS6581)
+            s->filter = &s->filter6581;
+        else
+            s->filter = &s->filter8580;
+    }
+}
+
+void SID::clockStems(int* block, int n, int* const* stemBuf, int pos)
+{
+    int stemBlock[3][BLOCK_SIZE];
+
+    for (int j = 0; j < n; j++)
+    {
+        /* clock waveform generators */
+        voice[0]->wave()->clock();
+        voice[1]->wave()->clock();
+        voice[2]->wave()->clock();
+
+        /* clock envelope generators */
+        voice[0]->envelope()->clock();
+        voice[1]->envelope()->clock();
+        voice[2]->envelope()->clock();
+
+        const int v1 = voice[0]->output(voice[2]->wave());
+        const int v2 = voice[1]->output(voice[0]->wave());
+        const int v3 = voice[2]->output(voice[1]->wave());
+
+        block[j] = externalFilter->clock(filter->clock(v1, v2, v3));
+
+        // Each voice alone in its own filter, as if the others were muted
+        stemBlock[0][j] = stem[0]->externalFilter.clock(stem[0]->filter->clock(v1, 0, 0));
+        stemBlock[1][j] = stem[1]->externalFilter.clock(stem[1]->filter->clock(0, v2, 0));
+        stemBlock[2][j] = stem[2]->externalFilter.clock(stem[2]->filter->clock(0, 0, v3));
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        stem[i]->resampler->inputBlock(stemBlock[i], n, stemBuf[i] + pos);
+    }
 }
 
 void SID::writeImmediate(int offset, unsigned char value)
 {
+    // Any write may change the voices or the filter setup
+    settled = false;
+
     switch (offset)
     {
     case 0x00:
@@ -208,6 +352,12 @@ void SID::writeImmediate(int offset, unsigned char value)
         break;
     }
 
+    // The stems follow the filter setup
+    if (unlikely(stemMode != STEMS_OFF) && offset >= 0x15 && offset <= 0x18)
+    {
+        updateStems();
+    }
+
     /* Update voicesync just in case. */
     voiceSync(false);
 }
@@ -264,6 +414,7 @@ void SID::setChipModel(ChipModel model)
     }
 
     this->model = model;
+    settled = false;
 
     /* calculate waveform-related tables, feed them to the generator */
     matrix_t* tables = WaveformCalculator::getInstance()->buildTable(model);
@@ -275,6 +426,8 @@ void SID::setChipModel(ChipModel model)
         voice[i]->wave()->setChipModel(model);
         voice[i]->wave()->setWaveformModels(tables);
     }
+
+    updateStems();
 }
 
 void SID::reset()
@@ -293,16 +446,34 @@ void SID::reset()
         resampler->reset();
     }
 
+    for (int i = 0; i < 3; i++)
+    {
+        if (stem[i] == 0)
+            continue;
+
+        stem[i]->filter6581.reset();
+        stem[i]->filter8580.reset();
+        stem[i]->externalFilter.reset();
+
+        if (stem[i]->resampler.get())
+            stem[i]->resampler->reset();
+    }
+
     busValue = 0;
     busValueTtl = 0;
     delayedOffset = -1;
     voiceSync(false);
+
+    settled = false;
+    silentCycles = 0;
+    skippedCycles = 0;
 }
 
 void SID::input(int value)
 {
     filter6581->input(value);
     filter8580->input(value);
+    settled = false;
 }
 
 unsigned char SID::read(int offset)
@@ -354,31 +525,70 @@ void SID::write(int offset, unsigned char value)
     }
 }
 
-void SID::setSamplingParameters(double clockFrequency, SamplingMethod method, double samplingFrequency, double highestAccurateFrequency)
+Resampler* SID::createResampler() const
 {
-    externalFilter->setClockFrequency(clockFrequency);
-
-    delete resampler;
-
-    switch (method)
+    switch (samplingMethod)
     {
     case DECIMATE:
-        resampler = new ZeroOrderResampler(clockFrequency, samplingFrequency);
-        break;
+        return new ZeroOrderResampler(clockFrequency, samplingFrequency);
 
     case RESAMPLE:
-        resampler = new TwoPassSincResampler(clockFrequency, samplingFrequency, highestAccurateFrequency);
-        break;
+        return new TwoPassSincResampler(clockFrequency, samplingFrequency, highestAccurateFrequency);
+
+    case RESAMPLE_POLYPHASE:
+        return new PolyphaseResampler(clockFrequency, samplingFrequency, highestAccurateFrequency);
 
     default:
         throw SIDError("Unknown sampling method\n");
     }
 }
 
+void SID::setSamplingParameters(double clockFrequency, SamplingMethod method, double samplingFrequency, double highestAccurateFrequency)
+{
+    externalFilter->setClockFrequency(clockFrequency);
+    settled = false;
+
+    delete resampler;
+    resampler = 0;
+
+    this->clockFrequency = clockFrequency;
+    this->samplingMethod = method;
+    this->samplingFrequency = samplingFrequency;
+    this->highestAccurateFrequency = highestAccurateFrequency;
+
+    resampler = createResampler();
+
+    for (int i = 0; i < 3; i++)
+    {
+        if (stem[i] == 0)
+            continue;
+
+        stem[i]->externalFilter.setClockFrequency(clockFrequency);
+        stem[i]->resampler.reset(createResampler());
+    }
+}
+
+void SID::precomputeResampler(double clockFrequency, double samplingFrequency, double highestAccurateFrequency)
+{
+    // The tables outlive the resampler
+    TwoPassSincResampler resampler(clockFrequency, samplingFrequency, highestAccurateFrequency);
+}
+
 void SID::clockSilent(int cycles)
 {
     ageBusValue(cycles);
 
+    // Keep the output phase so that the samples line up
+    // with the ones the normal clocking would have produced
+    if (resampler)
+        resampler->skip(cycles);
+
+    for (int i = 0; i < 3; i++)
+    {
+        if (stem[i] != 0 && stem[i]->resampler.get())
+            stem[i]->resampler->skip(cycles);
+    }
+
     while (cycles != 0)
     {
         int delta_t = std::min(nextVoiceSync, cycles);
@@ -397,8 +607,16 @@ void SID::clockSilent(int cycles)
                 voice[1]->wave()->clock();
                 voice[2]->wave()->clock();
 
-                /* clock ENV3 only */
+                /* clock envelope generators */
+                voice[0]->envelope()->clock();
+                voice[1]->envelope()->clock();
                 voice[2]->envelope()->clock();
+
+                // Needed for OSC3 and for combined waveforms
+                // writing to the noise register
+                voice[0]->wave()->output(voice[2]->wave());
+                voice[1]->wave()->output(voice[0]->wave());
+                voice[2]->wave()->output(voice[1]->wave());
             }
 
             if (delayedOffset != -1)
@@ -418,4 +636,68 @@ void SID::clockSilent(int cycles)
     }
 }
 
+void SID::serialize(StateStream& s)
+{
+    s.tag(model);
+    s.tag(resampler != 0);
+
+    s.io(busValueTtl);
+    s.io(nextVoiceSync);
+    s.io(delayedOffset);
+    s.io(settledOutput);
+    s.io(silentCycles);
+    s.io(skippedCycles);
+    s.io(delayedValue);
+    s.io(busValue);
+    s.io(settled);
+
+    if (!s.saving()
+        && (busValueTtl < 0 || nextVoiceSync < 0 || delayedOffset < -1 || delayedOffset > 0x1f))
+    {
+        s.fail();
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        voice[i]->serialize(s);
+    }
+
+    filter6581->serialize(s);
+    filter8580->serialize(s);
+    externalFilter->serialize(s);
+
+    if (resampler != 0)
+    {
+        resampler->serialize(s);
+    }
+
+    s.tag(stemMode);
+
+    for (int i = 0; i < 3; i++)
+    {
+        if (stem[i] == 0)
+            continue;
+
+        stem[i]->filter6581.serialize(s);
+        stem[i]->filter8580.serialize(s);
+        stem[i]->externalFilter.serialize(s);
+
+        if (stem[i]->resampler.get())
+            stem[i]->resampler->serialize(s);
+    }
+}
+
+void SID::saveState(std::vector<unsigned char>& state)
+{
+    StateStream s(state);
+    serialize(s);
+}
+
+bool SID::loadState(const unsigned char* data, size_t size)
+{
+    StateStream s(data, size);
+    serialize(s);
+    return s.done();
+}
+
 } // namespace reSIDfp
@@ -23,6 +23,11 @@
 #ifndef SIDFP_H
 #define SIDFP_H
 
+#include <stdint.h>
+
+#include <cstddef>
+#include <vector>
+
 #include "siddefs-fp.h"
 
 namespace reSIDfp
@@ -35,6 +40,7 @@ class ExternalFilter;
 class Potentiometer;
 class Voice;
 class Resampler;
+class StateStream;
 
 /**
  * SID error exception.
@@ -59,6 +65,12 @@ private:
     /// Bus value stays alive for some time after each operation.
     static const int BUS_TTL;
 
+    /// Cycles rendered before handing them over to the resampler.
+    static const int BLOCK_SIZE = 512;
+
+    /// Separate output of a voice.
+    struct Stem;
+
     /// Currently active filter
     Filter* filter;
 
@@ -86,6 +98,23 @@ private:
     /// SID voices
     Voice* voice[3];
 
+    /// Separate output of each voice, only set up when enabled.
+    Stem* stem[3];
+
+    /// Sampling parameters, kept to set up the stems.
+    //@{
+    double clockFrequency;
+    double samplingFrequency;
+    double highestAccurateFrequency;
+    SamplingMethod samplingMethod;
+    //@}
+
+    /// Filter curves, kept to set up the stems.
+    //@{
+    double filter6581Curve;
+    double filter8580Curve;
+    //@}
+
     /// Time to live for the last written value
     int busValueTtl;
 
@@ -98,9 +127,21 @@ private:
     /// Delayed MOS8580 write register
     int delayedOffset;
 
+    /// Output once the filters have settled with all voices silent.
+    int settledOutput;
+
+    /// Cycles run with all the voices silent.
+    uint64_t silentCycles;
+
+    /// Silent cycles where the filters had settled and were skipped.
+    uint64_t skippedCycles;
+
     /// Currently active chip model.
     ChipModel model;
 
+    /// How the voices are rendered separately.
+    StemMode stemMode;
+
     /// Delayed MOS8580 write value
     unsigned char delayedValue;
 
@@ -110,6 +151,9 @@ private:
     /// Flags for muted channels
     bool muted[3];
 
+    /// Whether #settledOutput is valid.
+    bool settled;
+
 private:
     /**
      * Write value to register during this clock cycle.
@@ -133,6 +177,43 @@ private:
      */
     int output() const;
 
+    /**
+     * Check whether all the envelopes are frozen at zero.
+     * Only a register write can change this.
+     */
+    bool voicesSilent() const;
+
+    /**
+     * Render cycles while all the voices are silent.
+     * The filters are clocked until they settle,
+     * after that the settled output is repeated.
+     *
+     * @param block where to store the output
+     * @param n the number of cycles
+     */
+    void clockSilentVoices(int* block, int n);
+
+    /**
+     * Render cycles along with the output of each voice,
+     * then resample the voices into the stem buffers.
+     *
+     * @param block where to store the output
+     * @param n the number of cycles
+     * @param stemBuf the stem buffers, one for each voice
+     * @param pos where to store the samples in the stem buffers
+     */
+    void clockStems(int* block, int n, int* const* stemBuf, int pos);
+
+    /**
+     * Create a resampler for the current sampling parameters.
+     */
+    Resampler* createResampler() const;
+
+    /**
+     * Set up the filters of the stems after a change.
+     */
+    void updateStems();
+
     /**
      * Calculate the numebr of cycles according to current parameters
      * that it takes to reach sync.
@@ -141,6 +222,11 @@ private:
      */
     void voiceSync(bool sync);
 
+    /**
+     * Save or restore the emulation state.
+     */
+    void serialize(StateStream& s);
+
 public:
     SID();
     ~SID();
@@ -210,6 +296,61 @@ public:
      */
     void mute(int channel, bool enable) { muted[channel] = enable; }
 
+    /**
+     * Render each voice separately along with the output.
+     * <p>
+     * Every voice goes through its own copy of the filters and of
+     * the resampler, so each stem costs about as much as the filter
+     * and the resampling of a whole chip, but the voices are only
+     * emulated once. With STEMS_FILTERED a voice goes through the
+     * filter as set up by the registers, with STEMS_UNFILTERED the
+     * filter is bypassed as if filter emulation was turned off.
+     * As with the output, the stems need a short time to settle
+     * after being enabled.
+     *
+     * @param mode how to render the voices, STEMS_OFF to stop
+     */
+    void setStems(StemMode mode);
+
+    /**
+     * Get how the voices are rendered separately.
+     */
+    StemMode getStems() const { return stemMode; }
+
+    /**
+     * Get the number of cycles clocked with all the voices silent
+     * since the last reset.
+     */
+    uint64_t getSilentCycles() const { return silentCycles; }
+
+    /**
+     * Get the number of silent cycles for which the filters had
+     * already settled and their emulation was skipped.
+     */
+    uint64_t getSkippedCycles() const { return skippedCycles; }
+
+    /**
+     * Save the state of the chip, including the filters
+     * and the resampler, at the end of the given buffer.
+     * The data can only be restored by the same build.
+     *
+     * @param state where to store the state
+     */
+    void saveState(std::vector<unsigned char>& state);
+
+    /**
+     * Restore a state saved by #saveState.
+     * The chip must be set up with the same model, sampling
+     * parameters and stem mode, the filter settings and the muted
+     * channels are kept.
+     * On failure the chip is left in an undefined state and should be reset.
+     *
+     * @param data the saved state
+     * @param size the size of the state
+     * @return false if the state doesn't match the chip setup
+     */
+    bool loadState(const unsigned char* data, size_t size);
+
     /**
      * Setting of SID sampling parameters.
      * <p>
@@ -228,6 +369,12 @@ public:
      * E.g. for a 44.1kHz sampling rate the end of passband frequency
      * is limited to slightly below 20kHz.
      * This constraint ensures that the FIR table is not overfilled.
+     * <p>
+     * RESAMPLE_POLYPHASE has the same passband as RESAMPLE in a single stage,
+     * with one long filter evaluated only once per output sample.
+     * The stopband rejection is lower though, as the coefficients of the
+     * long filter only use a few bits: at 44.1 and 48 kHz it is around
+     * -55 dB against -70 dB. resample/quality prints the figures.
      *
      * @param clockFrequency System clock frequency at Hz
      * @param method sampling method to use
@@ -236,22 +383,38 @@ public:
      */
     void setSamplingParameters(double clockFrequency, SamplingMethod method, double samplingFrequency, double highestAccurateFrequency);
 
+    /**
+     * Compute the FIR tables used by the RESAMPLE method
+     * for the given parameters ahead of time.
+     * The tables are kept in the shared store, so a later call to
+     * setSamplingParameters with the same parameters finds them ready.
+     *
+     * @param clockFrequency System clock frequency at Hz
+     * @param samplingFrequency Desired output sampling rate
+     * @param highestAccurateFrequency
+     */
+    static void precomputeResampler(double clockFrequency, double samplingFrequency, double highestAccurateFrequency);
+
     /**
      * Clock SID forward using chosen output sampling algorithm.
+     * <p>
+     * When stems are enabled the voices are resampled into
+     * the stem buffers, at the same positions as the output.
      *
      * @param cycles c64 clocks to clock
-     * @param buf audio output buffer
+     * @param buf audio output buffer, the samples are not clipped to 16 bits
+     * @param stemBuf the stem buffers, one for each voice,
+     *        or 0 when the stems are off
      * @return number of samples produced
      */
-    int clock(int cycles, short* buf);
+    int clock(int cycles, int* buf, int* const* stemBuf = 0);
 
     /**
      * Clock SID forward with no audio production.
      * <p>
-     * _Warning_:
-     * You can't mix this method of clocking with the audio-producing
-     * clock() because components that don't affect OSC3/ENV3 are not
-     * emulated.
+     * The voices are fully emulated but the filters and the resampler
+     * are not clocked, so after switching back to the audio-producing
+     * clock() the output needs a short time to settle.
      *
      * @param cycles c64 clocks to clock.
      */
@@ -318,13 +481,72 @@ int SID::output() const
     return externalFilter->clock(filter->clock(v1, v2, v3));
 }
 
+RESID_INLINE
+bool SID::voicesSilent() const
+{
+    return voice[0]->envelope()->isSilent()
+        && voice[1]->envelope()->isSilent()
+        && voice[2]->envelope()->isSilent();
+}
+
+RESID_INLINE
+void SID::clockSilentVoices(int* block, int n)
+{
+    silentCycles += n;
+
+    for (int j = 0; j < n; j++)
+    {
+        /* clock waveform generators */
+        voice[0]->wave()->clock();
+        voice[1]->wave()->clock();
+        voice[2]->wave()->clock();
+
+        /* clock envelope generators */
+        voice[0]->envelope()->clock();
+        voice[1]->envelope()->clock();
+        voice[2]->envelope()->clock();
+
+        // The voice outputs are zero, but the waveform output is still
+        // needed for OSC3 and for combined waveforms writing to the
+        // noise register.
+        voice[0]->wave()->output(voice[2]->wave());
+        voice[1]->wave()->output(voice[0]->wave());
+        voice[2]->wave()->output(voice[1]->wave());
+
+        if (likely(settled))
+        {
+            block[j] = settledOutput;
+            skippedCycles++;
+            continue;
+        }
+
+        // Once a cycle leaves the filters state unchanged
+        // the output stays the same as long as the input does.
+        int filterOutput;
+        const bool filterSettled = filter->clockSettled(filterOutput);
+
+        int externalOutput;
+        const bool externalSettled = externalFilter->clockSettled(filterOutput, externalOutput);
+
+        block[j] = externalOutput;
+
+        if (filterSettled && externalSettled)
+        {
+            settled = true;
+            settledOutput = externalOutput;
+        }
+    }
+}
+
 
 RESID_INLINE
-int SID::clock(int cycles, short* buf)
+int SID::clock(int cycles, int* buf, int* const* stemBuf)
 {
     ageBusValue(cycles);
     int s = 0;
 
+    const bool stems = stemBuf != 0 && stemMode != STEMS_OFF;
+
     while (cycles != 0)
     {
         int delta_t = std::min(nextVoiceSync, cycles);
@@ -336,22 +558,43 @@ int SID::clock(int cycles, short* buf)
                 delta_t = 1;
             }
 
-            for (int i = 0; i < delta_t; i++)
-            {
-                /* clock waveform generators */
-                voice[0]->wave()->clock();
-                voice[1]->wave()->clock();
-                voice[2]->wave()->clock();
+            // Render the raw output in blocks and resample each block
+            // in a single pass, the result is the same as feeding
+            // the resampler one cycle at a time.
+            int block[BLOCK_SIZE];
 
-                /* clock envelope generators */
-                voice[0]->envelope()->clock();
-                voice[1]->envelope()->clock();
-                voice[2]->envelope()->clock();
+            for (int i = 0; i < delta_t; )
+            {
+                const int n = (delta_t - i < BLOCK_SIZE) ? delta_t - i : BLOCK_SIZE;
 
-                if (unlikely(resampler->input(output())))
+                if (unlikely(stems))
                 {
-                    buf[s++] = resampler->getOutput();
+                    clockStems(block, n, stemBuf, s);
                 }
+                else if (voicesSilent())
+                {
+                    clockSilentVoices(block, n);
+                }
+                else
+                {
+                    for (int j = 0; j < n; j++)
+                    {
+                        /* clock waveform generators */
+                        voice[0]->wave()->clock();
+                        voice[1]->wave()->clock();
+                        voice[2]->wave()->clock();
+
+                        /* clock envelope generators */
+                        voice[0]->envelope()->clock();
+                        voice[1]->envelope()->clock();
+                        voice[2]->envelope()->clock();
+
+                        block[j] = output();
+                    }
+                }
+
+                s += resampler->inputBlock(block, n, buf + s);
+                i += n;
             }
 
             if (unlikely(delayedOffset != -1))
@@ -0,0 +1,144 @@
+/*
+ * This file is part of libsidplayfp, a SID player engine.
+ *
+ * Copyright 2014 Leandro Nini <drfiemost@users.sourceforge.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef STATESTREAM_H
+#define STATESTREAM_H
+
+#include <cstring>
+#include <vector>
+
+namespace reSIDfp
+{
+
+/**
+ * Binary stream for the chip state.
+ *
+ * Each component saves and restores its state in the same
+ * serialize() method, so the two can't get out of step.
+ * Values are stored as they are laid out in memory,
+ * the state can only be restored by the same build.
+ */
+class StateStream
+{
+private:
+    std::vector<unsigned char>* out;
+
+    const unsigned char* in;
+    size_t size;
+    size_t pos;
+
+    bool failed;
+
+private:
+    void raw(void* data, size_t length)
+    {
+        if (out)
+        {
+            const unsigned char* p = static_cast<const unsigned char*>(data);
+            out->insert(out->end(), p, p + length);
+        }
+        else if (!failed && length <= size - pos)
+        {
+            memcpy(data, in + pos, length);
+            pos += length;
+        }
+        else
+        {
+            failed = true;
+        }
+    }
+
+public:
+    /**
+     * Create a stream saving the state at the end of data.
+     */
+    explicit StateStream(std::vector<unsigned char>& data) :
+        out(&data),
+        in(0),
+        size(0),
+        pos(0),
+        failed(false) {}
+
+    /**
+     * Create a stream restoring the state from data.
+     */
+    StateStream(const unsigned char* data, size_t length) :
+        out(0),
+        in(data),
+        size(length),
+        pos(0),
+        failed(false) {}
+
+    /**
+     * Check whether the state is being saved or restored.
+     */
+    bool saving() const { return out != 0; }
+
+    /**
+     * Save or restore a value.
+     */
+    template<typename T>
+    void io(T& value) { raw(&value, sizeof(T)); }
+
+    /**
+     * Save or restore a flag.
+     * Anything but 0 or 1 fails, as it is not a valid bool.
+     */
+    void io(bool& value)
+    {
+        unsigned char flag = value ? 1 : 0;
+        io(flag);
+        if (flag > 1)
+            failed = true;
+        else
+            value = flag != 0;
+    }
+
+    /**
+     * Save or restore an array of values.
+     */
+    template<typename T>
+    void io(T* values, size_t count) { raw(values, sizeof(T) * count); }
+
+    /**
+     * Check a value which must be the same when restoring.
+     */
+    void tag(int id)
+    {
+        int value = id;
+        io(value);
+        if (value != id)
+            failed = true;
+    }
+
+    /**
+     * Mark the data as invalid.
+     */
+    void fail() { failed = true; }
+
+    /**
+     * Check whether all the data has been restored successfully.
+     */
+    bool done() const { return !failed && (out || pos == size); }
+};
+
+} // namespace reSIDfp
+
+#endif
@@ -97,6 +97,15 @@ public:
         waveformGenerator->reset();
         envelopeGenerator->reset();
     }
+
+    /**
+     * Save or restore the voice state.
+     */
+    void serialize(StateStream& s)
+    {
+        waveformGenerator->serialize(s);
+        envelopeGenerator->serialize(s);
+    }
 };
 
 } // namespace reSIDfp
@@ -21,11 +21,18 @@
 
 #include "WaveformCalculator.h"
 
+#include "Mutex.h"
+
 namespace reSIDfp
 {
 
+/// Serializes creation of the instance and access to the table cache.
+static Mutex cacheMutex;
+
 WaveformCalculator* WaveformCalculator::getInstance()
 {
+    MutexLock lock(cacheMutex);
+
     static WaveformCalculator instance;
     return &instance;
 }
@@ -55,6 +62,8 @@ matrix_t* WaveformCalculator::buildTable(ChipModel model)
 {
     const CombinedWaveformConfig* cfgArray = config[model == MOS6581 ? 0 : 1];
 
+    MutexLock lock(cacheMutex);
+
     cw_cache_t::iterator lb = CACHE.lower_bound(cfgArray);
 
     if (lb != CACHE.end() && !(CACHE.key_comp()(cfgArray, lb->first)))
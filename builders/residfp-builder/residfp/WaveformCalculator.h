@@ -117,6 +117,8 @@ public:
 
     /**
      * Build waveform tables for use by WaveformGenerator.
+     * Tables are cached and shared, this is safe to call
+     * from multiple threads.
      *
      * @param model Chip model to use
      * @return Waveform table
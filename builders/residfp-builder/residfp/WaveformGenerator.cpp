@@ -25,6 +25,7 @@
 #include "WaveformGenerator.h"
 
 #include "Dac.h"
+#include "StateStream.h"
 
 namespace reSIDfp
 {
@@ -192,6 +193,44 @@ void WaveformGenerator::writeCONTROL_REG(unsigned char control)
     }
 }
 
+void WaveformGenerator::serialize(StateStream& s)
+{
+    s.io(pw);
+    s.io(shift_register);
+    s.io(shift_register_reset);
+    s.io(shift_pipeline);
+    s.io(ring_msb_mask);
+    s.io(no_noise);
+    s.io(noise_output);
+    s.io(no_noise_or_noise_output);
+    s.io(no_pulse);
+    s.io(pulse_output);
+    s.io(waveform);
+    s.io(floating_output_ttl);
+    s.io(waveform_output);
+    s.io(accumulator);
+    s.io(freq);
+    s.io(test);
+    s.io(sync);
+    s.io(msb_rising);
+
+    if (!s.saving())
+    {
+        // The accumulator and the output index the 12 bit tables
+        if ((accumulator & ~0xffffff) != 0
+            || (waveform_output & ~0xfff) != 0
+            || (waveform & ~0xf) != 0
+            || shift_register_reset < 0 || shift_register_reset > 0x8000
+            || shift_pipeline < 0 || shift_pipeline > 2
+            || floating_output_ttl < 0 || floating_output_ttl > 0xF4240)
+        {
+            s.fail();
+        }
+
+        wave = (*model_wave)[waveform & 0x7];
+    }
+}
+
 void WaveformGenerator::reset()
 {
     accumulator = 0;
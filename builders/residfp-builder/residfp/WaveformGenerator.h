@@ -29,6 +29,8 @@
 namespace reSIDfp
 {
 
+class StateStream;
+
 /**
  * A 24 bit accumulator is the basis for waveform generation.
  * FREQ is added to the lower 16 bits of the accumulator each cycle.
@@ -236,6 +238,11 @@ public:
      */
     void reset();
 
+    /**
+     * Save or restore the oscillator state.
+     */
+    void serialize(StateStream& s);
+
     /**
      * 12-bit waveform output.
      * The output from SID 8580 is delayed one cycle compared to SID 6581;
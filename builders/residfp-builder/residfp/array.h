@@ -21,6 +21,8 @@
 #ifndef ARRAY_H
 #define ARRAY_H
 
+#include <cstddef>
+
 /**
  */
 class counter
@@ -36,35 +38,72 @@ public:
 
 /**
  * Reference counted pointer to array wrapper, for use with standard containers.
+ *
+ * Each row starts on a ROW_ALIGNMENT byte boundary so that SIMD code
+ * can load it efficiently, rows are padded with zeroes to keep the alignment.
  */
 template<typename T>
 class array
 {
+public:
+    /// Alignment of the rows in bytes, enough for 256 bit vectors.
+    static const unsigned int ROW_ALIGNMENT = 32;
+
 private:
     counter* count;
     const unsigned int x, y;
+    const unsigned int stride;
+    unsigned char* buffer;
     T* data;
 
+private:
+    static unsigned int padded(unsigned int y)
+    {
+        const unsigned int n = ROW_ALIGNMENT / sizeof(T);
+        return (y + n - 1) / n * n;
+    }
+
+    static T* align(unsigned char* p)
+    {
+        const size_t mask = ROW_ALIGNMENT - 1;
+        return reinterpret_cast<T*>((reinterpret_cast<size_t>(p) + mask) & ~mask);
+    }
+
 public:
     array(unsigned int x, unsigned int y) :
         count(new counter()),
         x(x),
         y(y),
-        data(new T[x * y]) {}
+        stride(padded(y)),
+        buffer(new unsigned char[x * stride * sizeof(T) + ROW_ALIGNMENT]),
+        data(align(buffer))
+    {
+        for (unsigned int i = 0; i < x * stride; i++)
+        {
+            data[i] = T();
+        }
+    }
 
     array(const array& p) :
         count(p.count),
         x(p.x),
         y(p.y),
+        stride(p.stride),
+        buffer(p.buffer),
         data(p.data) { count->increase(); }
 
-    ~array() { if (count->decrease() == 0) { delete count; delete [] data; } }
+    ~array() { if (count->decrease() == 0) { delete count; delete [] buffer; } }
 
+    /// Number of elements, excluding the padding.
     unsigned int length() const { return x * y; }
 
-    T* operator[](unsigned int a) { return a < x ? &data[a * y] : 0; }
+    unsigned int rows() const { return x; }
+
+    unsigned int columns() const { return y; }
+
+    T* operator[](unsigned int a) { return a < x ? &data[a * stride] : 0; }
 
-    T const* operator[](unsigned int a) const { return a < x ? &data[a * y] : 0; }
+    T const* operator[](unsigned int a) const { return a < x ? &data[a * stride] : 0; }
 };
 
 typedef array<short> matrix_t;
@@ -0,0 +1,269 @@
+/*
+ * This file is part of libsidplayfp, a SID player engine.
+ *
+ * Copyright 2011-2014 Leandro Nini <drfiemost@users.sourceforge.net>
+ * Copyright 2007-2010 Antti Lankila
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "Convolve.h"
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+// The x86 kernels are compiled for their own instruction set
+// regardless of the global compiler flags and only called
+// after checking that the CPU supports them.
+#if defined(HAVE_X86_SIMD_DISPATCH)
+#  define CONVOLVE_X86
+#  define TARGET_SSE2 __attribute__((target("sse2")))
+#  define TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#  define CONVOLVE_X86
+#  define TARGET_SSE2
+#  define TARGET_AVX2
+#endif
+
+#ifdef CONVOLVE_X86
+#  include <immintrin.h>
+#  ifdef _MSC_VER
+#    include <intrin.h>
+#  endif
+#elif defined(HAVE_MMINTRIN_H)
+#  include <mmintrin.h>
+#endif
+
+namespace reSIDfp
+{
+
+namespace Convolve
+{
+
+int portable(const short* a, const short* b, int bLength)
+{
+    int out = 0;
+
+    for (int i = 0; i < bLength; i++)
+    {
+        out += *a++ * *b++;
+    }
+
+    return (out + (1 << 14)) >> 15;
+}
+
+#ifdef CONVOLVE_X86
+
+TARGET_SSE2
+static int sse2(const short* a, const short* b, int bLength)
+{
+    __m128i acc = _mm_setzero_si128();
+
+    const int n = bLength / 8;
+
+    for (int i = 0; i < n; i++)
+    {
+        const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a));
+        const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(va, vb));
+        a += 8;
+        b += 8;
+    }
+
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+    int out = _mm_cvtsi128_si32(acc);
+
+    bLength &= 7;
+
+    for (int i = 0; i < bLength; i++)
+    {
+        out += *a++ * *b++;
+    }
+
+    return (out + (1 << 14)) >> 15;
+}
+
+TARGET_AVX2
+static int avx2(const short* a, const short* b, int bLength)
+{
+    // Two accumulators to hide the latency of the multiply-add
+    __m256i acc0 = _mm256_setzero_si256();
+    __m256i acc1 = _mm256_setzero_si256();
+
+    const int n = bLength / 32;
+
+    for (int i = 0; i < n; i++)
+    {
+        const __m256i va0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a));
+        const __m256i vb0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+        const __m256i va1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + 16));
+        const __m256i vb1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + 16));
+        acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(va0, vb0));
+        acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(va1, vb1));
+        a += 32;
+        b += 32;
+    }
+
+    if (bLength & 16)
+    {
+        const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a));
+        const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+        acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(va, vb));
+        a += 16;
+        b += 16;
+    }
+
+    acc0 = _mm256_add_epi32(acc0, acc1);
+
+    __m128i acc = _mm_add_epi32(_mm256_castsi256_si128(acc0), _mm256_extracti128_si256(acc0, 1));
+
+    if (bLength & 8)
+    {
+        const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a));
+        const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(va, vb));
+        a += 8;
+        b += 8;
+    }
+
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+    int out = _mm_cvtsi128_si32(acc);
+
+    bLength &= 7;
+
+    for (int i = 0; i < bLength; i++)
+    {
+        out += *a++ * *b++;
+    }
+
+    return (out + (1 << 14)) >> 15;
+}
+
+#ifdef _MSC_VER
+static bool cpuHasSSE2()
+{
+#  ifdef _M_X64
+    return true;
+#  else
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+#  endif
+}
+
+static bool cpuHasAVX2()
+{
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+
+    // The OS must save the YMM registers
+    __cpuid(info, 1);
+    if ((info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 6) != 6)
+        return false;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+}
+#else
+static bool cpuHasSSE2()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+}
+
+static bool cpuHasAVX2()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+#endif
+
+#elif defined(HAVE_MMINTRIN_H)
+
+static int mmx(const short* a, const short* b, int bLength)
+{
+    __m64 acc = _mm_setzero_si64();
+
+    const int n = bLength / 4;
+
+    for (int i = 0; i < n; i++)
+    {
+        const __m64 tmp = _mm_madd_pi16(*(__m64*)a, *(__m64*)b);
+        acc = _mm_add_pi32(acc, tmp);
+        a += 4;
+        b += 4;
+    }
+
+    int out = _mm_cvtsi64_si32(acc) + _mm_cvtsi64_si32(_mm_srli_si64(acc, 32));
+    _mm_empty();
+
+    bLength &= 3;
+
+    for (int i = 0; i < bLength; i++)
+    {
+        out += *a++ * *b++;
+    }
+
+    return (out + (1 << 14)) >> 15;
+}
+
+#endif
+
+std::vector<Kernel> available()
+{
+    std::vector<Kernel> kernels;
+
+    Kernel k;
+
+    k.name = "portable";
+    k.run = portable;
+    kernels.push_back(k);
+
+#ifdef CONVOLVE_X86
+    if (cpuHasSSE2())
+    {
+        k.name = "sse2";
+        k.run = sse2;
+        kernels.push_back(k);
+    }
+
+    if (cpuHasAVX2())
+    {
+        k.name = "avx2";
+        k.run = avx2;
+        kernels.push_back(k);
+    }
+#elif defined(HAVE_MMINTRIN_H)
+    k.name = "mmx";
+    k.run = mmx;
+    kernels.push_back(k);
+#endif
+
+    return kernels;
+}
+
+kernel_t best()
+{
+    return available().back().run;
+}
+
+} // namespace Convolve
+
+} // namespace reSIDfp
@@ -0,0 +1,73 @@
+/*
+ * This file is part of libsidplayfp, a SID player engine.
+ *
+ * Copyright 2011-2014 Leandro Nini <drfiemost@users.sourceforge.net>
+ * Copyright 2007-2010 Antti Lankila
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef CONVOLVE_H
+#define CONVOLVE_H
+
+#include <vector>
+
+namespace reSIDfp
+{
+
+/**
+ * Convolution of samples with a FIR table, the resampler inner loop.
+ *
+ * All kernels return the same result, the dot product of the two
+ * buffers rounded to 15 bits of fraction, so they can be used
+ * interchangeably. The vector kernels are selected at runtime
+ * according to the features of the running CPU.
+ */
+namespace Convolve
+{
+    /**
+     * @param a sample buffer input
+     * @param b sinc, rows of a matrix_t are aligned for vector loads
+     * @param bLength length of the sinc buffer
+     * @return convolved result
+     */
+    typedef int (*kernel_t)(const short* a, const short* b, int bLength);
+
+    struct Kernel
+    {
+        const char* name;
+        kernel_t run;
+    };
+
+    /**
+     * Plain C++ version, vectorized by the compiler if at all.
+     */
+    int portable(const short* a, const short* b, int bLength);
+
+    /**
+     * Get the kernels usable on the running CPU,
+     * from the slowest to the fastest.
+     */
+    std::vector<Kernel> available();
+
+    /**
+     * Get the fastest kernel for the running CPU.
+     */
+    kernel_t best();
+}
+
+} // namespace reSIDfp
+
+#endif
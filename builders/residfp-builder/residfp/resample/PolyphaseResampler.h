@@ -0,0 +1,60 @@
+/*
+ * This file is part of libsidplayfp, a SID player engine.
+ *
+ * Copyright 2011-2014 Leandro Nini <drfiemost@users.sourceforge.net>
+ * Copyright 2007-2010 Antti Lankila
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef POLYPHASERESAMPLER_H
+#define POLYPHASERESAMPLER_H
+
+#include "SincResampler.h"
+
+namespace reSIDfp
+{
+
+/**
+ * Single stage polyphase sinc resampler.
+ *
+ * Converts directly from the clock frequency to the sampling frequency
+ * with one set of FIR tables, instead of going through the intermediate
+ * frequency of the TwoPassSincResampler.
+ * The filter is longer but it is only evaluated once per output sample;
+ * the input cycles in between are just stored in the ring buffer,
+ * which is where the block interface pays off.
+ * <p>
+ * This is a SincResampler run over the whole ratio at once.
+ * As the filter is long, its 16 bit coefficients only use a few
+ * significant bits and the quantization limits the stopband rejection
+ * to about -55 dB at 44.1 and 48 kHz, some 15 dB less than the two
+ * pass resampler; the passband is the same.
+ */
+class PolyphaseResampler : public SincResampler
+{
+public:
+    /**
+     * @param clockFrequency System clock frequency at Hz
+     * @param samplingFrequency Desired output sampling rate
+     * @param highestAccurateFrequency
+     */
+    PolyphaseResampler(double clockFrequency, double samplingFrequency, double highestAccurateFrequency) :
+        SincResampler(clockFrequency, samplingFrequency, highestAccurateFrequency) {}
+};
+
+} // namespace reSIDfp
+
+#endif
@@ -22,9 +22,13 @@
 #ifndef RESAMPLER_H
 #define RESAMPLER_H
 
+#include <stdint.h>
+
 namespace reSIDfp
 {
 
+class StateStream;
+
 /**
  * Abstraction of a resampling process. Given enough input, produces output.
  * Constructors take additional arguments that configure these objects.
@@ -36,6 +40,42 @@ protected:
 
     Resampler() {}
 
+    /**
+     * Clip signed integer value into the -32768,32767 range.
+     */
+    static short clip(int value)
+    {
+        if (value < -32768) value = -32768;
+        if (value > 32767) value = 32767;
+
+        return value;
+    }
+
+    /**
+     * Move the output phase forward as if cycles samples had been input.
+     * The resamplers keep the distance to the next output in 1/1024 of
+     * an input sample, which stays between 0 and cyclesPerSample.
+     *
+     * @param sampleOffset the distance to the next output
+     * @param cyclesPerSample input samples per output sample, times 1024
+     * @param cycles number of input samples to skip
+     * @return the number of output samples skipped
+     */
+    static int skipOffset(int& sampleOffset, int cyclesPerSample, int cycles)
+    {
+        const int64_t due = (int64_t)cycles * 1024 - sampleOffset;
+
+        if (due <= 0)
+        {
+            sampleOffset = (int)-due;
+            return 0;
+        }
+
+        const int64_t outputs = (due + cyclesPerSample - 1) / cyclesPerSample;
+        sampleOffset = (int)(outputs * cyclesPerSample - due);
+        return (int)outputs;
+    }
+
 public:
     virtual ~Resampler() {}
 
@@ -47,6 +87,33 @@ public:
      */
     virtual bool input(int sample) = 0;
 
+    /**
+     * Input a block of samples into resampler,
+     * collecting the produced output samples.
+     * The output is not clipped to 16 bits.
+     * Resamplers that can do better than one sample
+     * at a time override this.
+     *
+     * @param samples input samples
+     * @param length number of input samples
+     * @param buf where to store the output samples
+     * @return the number of output samples
+     */
+    virtual int inputBlock(const int* samples, int length, int* buf)
+    {
+        int s = 0;
+
+        for (int i = 0; i < length; i++)
+        {
+            if (input(samples[i]))
+            {
+                buf[s++] = output();
+            }
+        }
+
+        return s;
+    }
+
     /**
      * Output a sample from resampler.
      *
@@ -54,14 +121,24 @@ public:
      */
     short getOutput() const
     {
-        int value = output();
+        return clip(output());
+    }
 
-        // Clip signed integer value into the -32768,32767 range.
-        if (value < -32768) value = -32768;
-        if (value > 32767) value = 32767;
+    /**
+     * Skip input samples without computing any output.
+     * The output phase is kept but not the history,
+     * so the output needs some input to settle afterwards.
+     *
+     * @param cycles number of input samples to skip
+     * @return the number of output samples skipped
+     */
+    virtual int skip(int cycles) = 0;
 
-        return value;
-    }
+    /**
+     * Save or restore the phase and the history.
+     * Restoring needs a resampler built with the same parameters.
+     */
+    virtual void serialize(StateStream& s) = 0;
 
     virtual void reset() = 0;
 };
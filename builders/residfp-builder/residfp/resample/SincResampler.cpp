@@ -22,22 +22,25 @@
 
 #include "SincResampler.h"
 
-#include <cassert>
+#include <stdint.h>
+
+#include <algorithm>
+#include <cstdio>
 #include <cstring>
 #include <cmath>
+#include <fstream>
 #include <iostream>
 #include <sstream>
 
 #include "siddefs-fp.h"
+#include "Convolve.h"
+#include "../Mutex.h"
+#include "../StateStream.h"
 
 #ifdef HAVE_CONFIG_H
 #  include "config.h"
 #endif
 
-#ifdef HAVE_MMINTRIN_H
-#  include <mmintrin.h>
-#endif
-
 namespace reSIDfp
 {
 
@@ -46,6 +49,65 @@ typedef std::map<std::string, matrix_t> fir_cache_t;
 /// Cache for the expensive FIR table computation results.
 fir_cache_t FIR_CACHE;
 
+/// Serializes access to the FIR cache.
+Mutex FIR_CACHE_MUTEX;
+
+/**
+ * FIR cache file layout, all values in native byte order:
+ *
+ *     magic[8] version count
+ *     { keyLength key[keyLength] firRES firN checksum table[firRES * firN] } * count
+ *
+ * Bump the version when the table computation changes.
+ */
+const char FIR_FILE_MAGIC[8] = { 'R', 'S', 'F', 'P', 'F', 'I', 'R', 0 };
+const uint32_t FIR_FILE_VERSION = 1;
+
+/// Longest key accepted when loading, keys are much shorter.
+const uint32_t FIR_KEY_MAX = 256;
+
+/// Longest filter accepted when loading, even at 8 kHz filters are shorter.
+const uint32_t FIR_N_MAX = 1 << 16;
+
+/// FNV-1a hash of a FIR table.
+uint32_t firChecksum(const matrix_t& table)
+{
+    uint32_t hash = 2166136261u;
+
+    for (unsigned int row = 0; row < table.rows(); row++)
+    {
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(table[row]);
+
+        for (size_t i = 0; i < table.columns() * sizeof(short); i++)
+        {
+            hash = (hash ^ p[i]) * 16777619u;
+        }
+    }
+
+    return hash;
+}
+
+bool readU32(std::istream& in, uint32_t& value)
+{
+    return in.read(reinterpret_cast<char*>(&value), sizeof(value)).good();
+}
+
+void writeU32(std::ostream& out, uint32_t value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+/**
+ * Start of the cache key of a table, the dimensions.
+ * The cycles per sample follow in the full key.
+ */
+std::string firKeyPrefix(int firN, int firRES)
+{
+    std::ostringstream o;
+    o << firN << "," << firRES << ",";
+    return o.str();
+}
+
 /// Maximum error acceptable in I0 is 1e-6, or ~96 dB.
 const double I0E = 1e-6;
 
@@ -76,44 +138,8 @@ double I0(double x)
     return sum;
 }
 
-/**
- * Calculate convolution with sample and sinc.
- *
- * @param a sample buffer input
- * @param b sinc
- * @param bLength length of the sinc buffer
- * @return convolved result
- */
-int convolve(const short* a, const short* b, int bLength)
-{
-#ifdef HAVE_MMINTRIN_H
-    __m64 acc = _mm_setzero_si64();
-
-    const int n = bLength / 4;
-
-    for (int i = 0; i < n; i++)
-    {
-        const __m64 tmp = _mm_madd_pi16(*(__m64*)a, *(__m64*)b);
-        acc = _mm_add_pi16(acc, tmp);
-        a += 4;
-        b += 4;
-    }
-
-    int out = _mm_cvtsi64_si32(acc) + _mm_cvtsi64_si32(_mm_srli_si64(acc, 32));
-    _mm_empty();
-
-    bLength &= 3;
-#else
-    int out = 0;
-#endif
-
-    for (int i = 0; i < bLength; i++)
-    {
-        out += *a++ * *b++;
-    }
-
-    return (out + (1 << 14)) >> 15;
-}
+/// Fastest convolution kernel for the running CPU.
+const Convolve::kernel_t convolve = Convolve::best();
 
 int SincResampler::fir(int subcycle)
 {
@@ -122,9 +148,9 @@ int SincResampler::fir(int subcycle)
     const int firTableOffset = (subcycle * firRES) & 0x3ff;
 
     // find firN most recent samples, plus one extra in case the FIR wraps.
-    int sampleStart = sampleIndex - firN + RINGSIZE - 1;
+    int sampleStart = sampleIndex - firN + ringSize - 1;
 
-    const int v1 = convolve(sample + sampleStart, (*firTable)[firTableFirst], firN);
+    const int v1 = convolve(&sample[sampleStart], (*firTable)[firTableFirst], firN);
 
     // Use next FIR table, wrap around to first FIR table using
     // previous sample.
@@ -134,7 +160,7 @@ int SincResampler::fir(int subcycle)
         ++sampleStart;
     }
 
-    const int v2 = convolve(sample + sampleStart, (*firTable)[firTableFirst], firN);
+    const int v2 = convolve(&sample[sampleStart], (*firTable)[firTableFirst], firN);
 
     // Linear interpolation between the sinc tables yields good
     // approximation for the exact value.
@@ -146,6 +172,20 @@ SincResampler::SincResampler(double clockFrequency, double samplingFrequency, do
     cyclesPerSample((int)(clockFrequency / samplingFrequency * 1024.)),
     sampleOffset(0),
     outputValue(0)
+{
+    firTable = getFirTable(clockFrequency, samplingFrequency, highestAccurateFrequency, firN, firRES);
+
+    // The window reaches one sample past firN when the phase wraps
+    ringSize = 1;
+    while (ringSize <= firN)
+    {
+        ringSize <<= 1;
+    }
+
+    sample.resize(ringSize * 2, 0);
+}
+
+matrix_t* SincResampler::getFirTable(double clockFrequency, double samplingFrequency, double highestAccurateFrequency, int& firN, int& firRES)
 {
     // 16 bits -> -96dB stopband attenuation.
     const double A = -20. * log10(1.0 / (1 << BITS));
@@ -174,9 +214,6 @@ SincResampler::SincResampler(double clockFrequency, double samplingFrequency, do
         firN = (int)(N * cyclesPerSampleD) + 1;
         firN |= 1;
 
-        // Check whether the sample ring buffer would overflow.
-        assert(firN < RINGSIZE);
-
         // Error is bounded by err < 1.234 / L^2, so L = sqrt(1.234 / (2^-16)) = sqrt(1.234 * 2^16).
         firRES = (int) ceil(sqrt(1.234 * (1 << BITS)) / cyclesPerSampleD);
 
@@ -185,9 +222,17 @@ SincResampler::SincResampler(double clockFrequency, double samplingFrequency, do
         // The filter test program indicates that the filter performs well, though. */
     }
 
+    // Full precision, so that close clock frequencies don't share a table
     std::ostringstream o;
-    o << firN << "," << firRES << "," << cyclesPerSampleD;
-    const std::string firKey = o.str();
+    o.precision(17);
+    o << cyclesPerSampleD;
+    const std::string firKey = firKeyPrefix(firN, firRES) + o.str();
+
+    matrix_t* firTable;
+
+    // Tables are filled after insertion so hold the lock until done.
+    MutexLock lock(FIR_CACHE_MUTEX);
+
     fir_cache_t::iterator lb = FIR_CACHE.lower_bound(firKey);
 
     // The FIR computation is expensive and we set sampling parameters often, but
@@ -226,14 +271,130 @@ SincResampler::SincResampler(double clockFrequency, double samplingFrequency, do
             }
         }
     }
+
+    return firTable;
+}
+
+bool SincResampler::loadCache(const char* path)
+{
+    std::ifstream in(path, std::ios::in | std::ios::binary);
+
+    char magic[8];
+    uint32_t version, count;
+    if (!in.read(magic, sizeof(magic))
+        || memcmp(magic, FIR_FILE_MAGIC, sizeof(magic)) != 0
+        || !readU32(in, version) || version != FIR_FILE_VERSION
+        || !readU32(in, count))
+    {
+        return false;
+    }
+
+    // Read everything before touching the store
+    // so a corrupted file adds nothing.
+    fir_cache_t tables;
+
+    for (uint32_t n = 0; n < count; n++)
+    {
+        uint32_t keyLength;
+        if (!readU32(in, keyLength) || keyLength == 0 || keyLength > FIR_KEY_MAX)
+            return false;
+
+        std::string key(keyLength, '\0');
+        uint32_t firRES, firN, checksum;
+        if (!in.read(&key[0], keyLength)
+            || !readU32(in, firRES) || !readU32(in, firN) || !readU32(in, checksum)
+            || firN == 0 || firN > FIR_N_MAX || firRES == 0 || firRES > (1 << BITS))
+        {
+            return false;
+        }
+
+        // Rows are stored without the alignment padding
+        matrix_t table(firRES, firN);
+        for (uint32_t row = 0; row < firRES; row++)
+        {
+            if (!in.read(reinterpret_cast<char*>(table[row]), firN * sizeof(short)))
+                return false;
+        }
+
+        if (firChecksum(table) != checksum)
+            return false;
+
+        // Tables are looked up by key alone, the key
+        // must tell the dimensions of the stored matrix.
+        const std::string prefix = firKeyPrefix(firN, firRES);
+        if (key.size() <= prefix.size() || key.compare(0, prefix.size(), prefix) != 0)
+            return false;
+
+        tables.insert(fir_cache_t::value_type(key, table));
+    }
+
+    MutexLock lock(FIR_CACHE_MUTEX);
+
+    // Existing entries win, resamplers may be pointing to them
+    FIR_CACHE.insert(tables.begin(), tables.end());
+
+    return true;
+}
+
+bool SincResampler::saveCache(const char* path)
+{
+    MutexLock lock(FIR_CACHE_MUTEX);
+
+    // Write to a temporary file and rename it so that
+    // other processes never see a partial cache.
+    const std::string tmpPath = std::string(path) + ".tmp";
+
+    {
+        std::ofstream out(tmpPath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+        out.write(FIR_FILE_MAGIC, sizeof(FIR_FILE_MAGIC));
+        writeU32(out, FIR_FILE_VERSION);
+        writeU32(out, (uint32_t)FIR_CACHE.size());
+
+        for (fir_cache_t::const_iterator it = FIR_CACHE.begin(); it != FIR_CACHE.end(); ++it)
+        {
+            const std::string& key = it->first;
+            const matrix_t& table = it->second;
+
+            writeU32(out, (uint32_t)key.size());
+            out.write(key.data(), key.size());
+            writeU32(out, table.rows());
+            writeU32(out, table.columns());
+            writeU32(out, firChecksum(table));
+
+            for (unsigned int row = 0; row < table.rows(); row++)
+            {
+                out.write(reinterpret_cast<const char*>(table[row]), table.columns() * sizeof(short));
+            }
+        }
+
+        if (!out.good())
+        {
+            out.close();
+            std::remove(tmpPath.c_str());
+            return false;
+        }
+    }
+
+    if (std::rename(tmpPath.c_str(), path) != 0)
+    {
+        // Rename doesn't replace existing files everywhere
+        std::remove(path);
+        if (std::rename(tmpPath.c_str(), path) != 0)
+        {
+            std::remove(tmpPath.c_str());
+            return false;
+        }
+    }
+
+    return true;
 }
 
 bool SincResampler::input(int input)
 {
     bool ready = false;
 
-    sample[sampleIndex] = sample[sampleIndex + RINGSIZE] = input;
-    sampleIndex = (sampleIndex + 1) & (RINGSIZE - 1);
+    store(input);
 
     if (sampleOffset < 1024)
     {
@@ -247,9 +408,66 @@ bool SincResampler::input(int input)
     return ready;
 }
 
+int SincResampler::inputBlock(const int* samples, int length, int* out)
+{
+    int s = 0;
+    int i = 0;
+
+    for (;;)
+    {
+        // Samples that only need to be stored before the next output,
+        // the offset is never negative as we are downsampling.
+        int skip = sampleOffset >> 10;
+        if (skip > length - i)
+            skip = length - i;
+
+        for (int j = 0; j < skip; j++)
+        {
+            store(samples[i + j]);
+        }
+
+        i += skip;
+        sampleOffset -= skip << 10;
+
+        if (i == length)
+            break;
+
+        store(samples[i++]);
+
+        outputValue = fir(sampleOffset);
+        out[s++] = outputValue;
+
+        sampleOffset += cyclesPerSample - 1024;
+    }
+
+    return s;
+}
+
+void SincResampler::serialize(StateStream& s)
+{
+    s.tag(cyclesPerSample);
+    s.tag(ringSize);
+    s.io(sampleIndex);
+    s.io(sampleOffset);
+    s.io(outputValue);
+
+    // The second half of the ring is a copy of the first one
+    s.io(&sample[0], ringSize);
+
+    if (!s.saving())
+    {
+        // The offset picks the FIR table and the samples to skip
+        if (sampleOffset < 0 || sampleOffset >= cyclesPerSample + 1024)
+            s.fail();
+
+        sampleIndex &= ringSize - 1;
+        std::copy(sample.begin(), sample.begin() + ringSize, sample.begin() + ringSize);
+    }
+}
+
 void SincResampler::reset()
 {
-    memset(sample, 0, RINGSIZE * 2 * sizeof(sample[0]));
+    std::fill(sample.begin(), sample.end(), 0);
     sampleOffset = 0;
 }
 
@@ -27,6 +27,7 @@
 
 #include <string>
 #include <map>
+#include <vector>
 
 #include "../array.h"
 
@@ -50,9 +51,6 @@ namespace reSIDfp
  */
 class SincResampler : public Resampler
 {
-private:
-    static const int RINGSIZE = 2048;
-
 private:
     matrix_t* firTable;
 
@@ -60,28 +58,39 @@ private:
 
     int firRES, firN;
 
+    /// Size of the ring buffer, a power of two.
+    int ringSize;
+
     const int cyclesPerSample;
 
     int sampleOffset;
 
     int outputValue;
 
-    short sample[RINGSIZE * 2];
+    /**
+     * The ring buffer, stored twice so that the FIR window is contiguous.
+     * The input saturates at 16 bits, the output of the filter does not.
+     */
+    std::vector<short> sample;
 
 private:
     int fir(int subcycle);
 
+    void store(int input)
+    {
+        sample[sampleIndex] = sample[sampleIndex + ringSize] = clip(input);
+        sampleIndex = (sampleIndex + 1) & (ringSize - 1);
+    }
+
 public:
     /**
      * Use a clock freqency of 985248Hz for PAL C64, 1022730Hz for NTSC C64.
      * The default end of passband frequency is pass_freq = 0.9*sample_freq/2
      * for sample frequencies up to ~ 44.1kHz, and 20kHz for higher sample frequencies.
      * <p>
-     * For resampling, the ratio between the clock frequency and the sample frequency
-     * is limited as follows: 125*clock_freq/sample_freq < 16384
-     * E.g. provided a clock frequency of ~ 1MHz, the sample frequency
-     * can not be set lower than ~ 8kHz.
-     * A lower sample frequency would make the resampling code overfill its 16k sample ring buffer.
+     * The sample ring buffer is sized after the filter length,
+     * which grows with the ratio between the clock frequency and
+     * the sample frequency.
      * <p>
      * The end of passband frequency is also limited: pass_freq <= 0.9*sample_freq/2
      * <p>
@@ -94,10 +103,60 @@ public:
      */
     SincResampler(double clockFrequency, double samplingFrequency, double highestAccurateFrequency);
 
+    /**
+     * Get the FIR tables for the given parameters from the shared store,
+     * computing them if needed.
+     * There are firRES tables of firN taps, each one shifted
+     * by 1/firRES of a sample from the previous.
+     *
+     * @param clockFrequency System clock frequency at Hz
+     * @param samplingFrequency Desired output sampling rate
+     * @param highestAccurateFrequency
+     * @param firN returns the length of each table
+     * @param firRES returns the number of tables
+     * @return the FIR tables
+     */
+    static matrix_t* getFirTable(double clockFrequency, double samplingFrequency, double highestAccurateFrequency, int& firN, int& firRES);
+
+    /**
+     * Add the FIR tables stored in a file to the shared table store.
+     * Tables already in the store are kept.
+     * Safe to call from multiple threads.
+     *
+     * @param path the file written by #saveCache
+     * @return false if the file can't be read or is corrupted
+     */
+    static bool loadCache(const char* path);
+
+    /**
+     * Write all the FIR tables in the shared table store to a file.
+     * Safe to call from multiple threads.
+     *
+     * @param path the destination file
+     * @return false on write errors
+     */
+    static bool saveCache(const char* path);
+
     bool input(int input);
 
+    /**
+     * Input a block of samples into resampler,
+     * collecting the unclipped output values.
+     * The output may overwrite the input as it never gets ahead of it.
+     *
+     * @param samples input samples
+     * @param length number of input samples
+     * @param out where to store the output values
+     * @return the number of output values
+     */
+    int inputBlock(const int* samples, int length, int* out);
+
     int output() const { return outputValue; }
 
+    int skip(int cycles) { return skipOffset(sampleOffset, cyclesPerSample, cycles); }
+
+    void serialize(StateStream& s);
+
     void reset();
 };
 
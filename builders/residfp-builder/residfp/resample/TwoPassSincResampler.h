@@ -35,10 +35,17 @@ namespace reSIDfp
  */
 class TwoPassSincResampler : public Resampler
 {
+private:
+    /// Input samples handled by each pass at once.
+    static const int BLOCK_SIZE = 1024;
+
 private:
     SincResampler* s1;
     SincResampler* s2;
 
+    /// Output of the first pass.
+    int block[BLOCK_SIZE];
+
 public:
     TwoPassSincResampler(double clockFrequency, double samplingFrequency,
                          double highestAccurateFrequency)
@@ -63,11 +70,40 @@ public:
         return s1->input(sample) && s2->input(s1->output());
     }
 
+    int inputBlock(const int* samples, int length, int* buf)
+    {
+        int s = 0;
+
+        while (length != 0)
+        {
+            const int n = (length < BLOCK_SIZE) ? length : BLOCK_SIZE;
+
+            const int m = s1->inputBlock(samples, n, block);
+            s += s2->inputBlock(block, m, buf + s);
+
+            samples += n;
+            length -= n;
+        }
+
+        return s;
+    }
+
     int output() const
     {
         return s2->output();
     }
 
+    int skip(int cycles)
+    {
+        return s2->skip(s1->skip(cycles));
+    }
+
+    void serialize(StateStream& s)
+    {
+        s1->serialize(s);
+        s2->serialize(s);
+    }
+
     void reset()
     {
         s1->reset();
@@ -23,6 +23,7 @@
 #define ZEROORDER_RESAMPLER_H
 
 #include "Resampler.h"
+#include "../StateStream.h"
 
 namespace reSIDfp
 {
@@ -69,6 +70,16 @@ public:
 
     int output() const { return outputValue; }
 
+    int skip(int cycles) { return skipOffset(sampleOffset, cyclesPerSample, cycles); }
+
+    void serialize(StateStream& s)
+    {
+        s.tag(cyclesPerSample);
+        s.io(cachedSample);
+        s.io(sampleOffset);
+        s.io(outputValue);
+    }
+
     void reset()
     {
         sampleOffset = 0;
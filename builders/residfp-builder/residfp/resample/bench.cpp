@@ -0,0 +1,109 @@
+/*
+ * This file is part of libsidplayfp, a SID player engine.
+ *
+ * Copyright 2011-2014 Leandro Nini <drfiemost@users.sourceforge.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+#include "Convolve.h"
+#include "../array.h"
+
+/**
+ * Compare the convolution kernels available on this CPU.
+ * Checks that all of them match the portable one and
+ * reports the time per call for some typical FIR lengths.
+ */
+int main()
+{
+    // Lengths used by the two pass resampler at 44.1, 48 and 96 kHz
+    // plus a few odd ones to exercise the tails
+    const int lengths[] = { 83, 97, 99, 151, 7, 33, 1001 };
+    const int RINGSIZE = 2048;
+    const long CALLS = 2000000;
+
+    const std::vector<reSIDfp::Convolve::Kernel> kernels = reSIDfp::Convolve::available();
+
+    std::srand(1);
+
+    short samples[RINGSIZE * 2];
+    for (int i = 0; i < RINGSIZE * 2; i++)
+    {
+        samples[i] = (short)(std::rand() - RAND_MAX / 2);
+    }
+
+    std::cout << std::setw(8) << "length";
+    for (size_t k = 0; k < kernels.size(); k++)
+    {
+        std::cout << std::setw(12) << kernels[k].name;
+    }
+    std::cout << "   (ns per call)" << std::endl;
+
+    int status = EXIT_SUCCESS;
+
+    for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++)
+    {
+        const int firN = lengths[l];
+
+        matrix_t fir(1, firN);
+        for (int i = 0; i < firN; i++)
+        {
+            fir[0][i] = (short)(std::rand() % 65536 - 32768);
+        }
+
+        std::cout << std::setw(8) << firN;
+
+        for (size_t k = 0; k < kernels.size(); k++)
+        {
+            // Check against the portable version on all sample offsets
+            for (int offset = 0; offset < RINGSIZE; offset++)
+            {
+                const int expected = reSIDfp::Convolve::portable(samples + offset, fir[0], firN);
+                if (kernels[k].run(samples + offset, fir[0], firN) != expected)
+                {
+                    std::cerr << kernels[k].name << " mismatch, length " << firN << " offset " << offset << std::endl;
+                    status = EXIT_FAILURE;
+                    break;
+                }
+            }
+
+            int sum = 0;
+            const clock_t start = clock();
+
+            for (long i = 0; i < CALLS; i++)
+            {
+                sum += kernels[k].run(samples + (i & (RINGSIZE - 1)), fir[0], firN);
+            }
+
+            const clock_t end = clock();
+
+            // Print the sum so the loop is not optimized away
+            const double ns = (double)(end - start) / CLOCKS_PER_SEC * 1e9 / CALLS;
+            std::cout << std::setw(12) << std::fixed << std::setprecision(1) << ns;
+            if (sum == 0x7fffffff)
+                std::cout << '!';
+        }
+
+        std::cout << std::endl;
+    }
+
+    return status;
+}
@@ -0,0 +1,184 @@
+/*
+ * This file is part of libsidplayfp, a SID player engine.
+ *
+ * Copyright 2012-2013 Leandro Nini <drfiemost@users.sourceforge.net>
+ * Copyright 2007-2010 Antti Lankila
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <cstdlib>
+#include <memory>
+#include <ctime>
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <vector>
+
+#include "siddefs-fp.h"
+
+#include "Resampler.h"
+#include "PolyphaseResampler.h"
+#include "TwoPassSincResampler.h"
+
+/**
+ * Run the same sine sweep as test.cpp through the two pass and
+ * the polyphase resamplers and print the output power side by side,
+ * followed by the time spent filtering by each one.
+ * The two pass resampler is fed a cycle at a time, the polyphase one
+ * in blocks, as the emulation does.
+ * A summary gives the passband ripple and the stopband rejection
+ * of each, relative to the level at the first frequency. The stopband
+ * starts where the input aliases back into the passband.
+ * The level is 6 dB lower than in test.cpp so that the 16 bit
+ * outputs of both are compared without clipping.
+ */
+
+/// Prefill, longer than the longest FIR
+static const int PREFILL = 16384;
+
+/// Measurement length, 100 ms of input
+static const int LENGTH = 100000;
+
+/// Block size for the block interface
+static const int BLOCK = 1024;
+
+static double measureSingle(reSIDfp::Resampler &r, const std::vector<int> &signal, clock_t &time)
+{
+    const clock_t start = clock();
+
+    for (int j = 0; j < PREFILL; j++)
+    {
+        r.input(signal[j]);
+    }
+
+    int n = 0;
+    float pwr = 0;
+
+    for (size_t j = PREFILL; j < signal.size(); j++)
+    {
+        if (r.input(signal[j]))
+        {
+            const float out = r.getOutput();
+            pwr += out * out;
+            n += 1;
+        }
+    }
+
+    time += clock() - start;
+
+    return 10 * log10(pwr / n);
+}
+
+static double measureBlock(reSIDfp::Resampler &r, const std::vector<int> &signal, clock_t &time)
+{
+    // Large enough for the prefill as we are downsampling
+    std::vector<int> buf(PREFILL);
+
+    const clock_t start = clock();
+
+    r.inputBlock(&signal[0], PREFILL, &buf[0]);
+
+    int n = 0;
+    float pwr = 0;
+
+    for (size_t j = PREFILL; j < signal.size(); j += BLOCK)
+    {
+        const int length = std::min<int>(BLOCK, signal.size() - j);
+        const int count = r.inputBlock(&signal[j], length, &buf[0]);
+
+        for (int i = 0; i < count; i++)
+        {
+            const float out = buf[i];
+            pwr += out * out;
+            n += 1;
+        }
+    }
+
+    time += clock() - start;
+
+    return 10 * log10(pwr / n);
+}
+
+int main(int argc, const char* argv[])
+{
+    const double RATE = 985248.4;
+    const double SAMPLING = argc > 1 ? atof(argv[1]) : 48000.0;
+    const double PASSBAND = std::min(20000.0, 0.9 * SAMPLING / 2.);
+
+    std::auto_ptr<reSIDfp::TwoPassSincResampler> twoPass(new reSIDfp::TwoPassSincResampler(RATE, SAMPLING, PASSBAND));
+    std::auto_ptr<reSIDfp::PolyphaseResampler> polyphase(new reSIDfp::PolyphaseResampler(RATE, SAMPLING, PASSBAND));
+
+    clock_t twoPassTime = 0;
+    clock_t polyphaseTime = 0;
+
+    std::vector<int> signal(PREFILL + LENGTH);
+
+    std::cout << std::setw(6) << "Hz" << std::setw(10) << "2-pass" << std::setw(10) << "poly" << std::setw(10) << "diff" << std::endl;
+
+    const double STOPBAND = SAMPLING - PASSBAND;
+
+    // Reference level, passband ripple and worst stopband level of each
+    double ref[2] = { 0., 0. };
+    double rippleMin[2] = { 1e9, 1e9 };
+    double rippleMax[2] = { -1e9, -1e9 };
+    double stopMax[2] = { -1e9, -1e9 };
+    bool first = true;
+
+    for (double freq = 1000.; freq < RATE / 2.; freq *= 1.01)
+    {
+        const double omega = 2 * M_PI * freq / RATE;
+
+        for (size_t k = 0; k < signal.size(); k++)
+        {
+            signal[k] = (int)(16384.0 * sin(k * omega) * sqrt(2));
+        }
+
+        const double a = measureSingle(*twoPass, signal, twoPassTime);
+        const double b = measureBlock(*polyphase, signal, polyphaseTime);
+
+        const double level[2] = { a, b };
+        for (int r = 0; r < 2; r++)
+        {
+            if (first)
+                ref[r] = level[r];
+
+            if (freq <= PASSBAND)
+            {
+                rippleMin[r] = std::min(rippleMin[r], level[r] - ref[r]);
+                rippleMax[r] = std::max(rippleMax[r], level[r] - ref[r]);
+            }
+            else if (freq >= STOPBAND)
+            {
+                stopMax[r] = std::max(stopMax[r], level[r] - ref[r]);
+            }
+        }
+        first = false;
+
+        std::cout << std::fixed << std::setprecision(0) << std::setw(6) << freq
+            << std::setprecision(2) << std::setw(10) << a << std::setw(10) << b << std::setw(10) << b - a << std::endl;
+    }
+
+    const char* names[2] = { "two pass", "polyphase" };
+    for (int r = 0; r < 2; r++)
+    {
+        std::cout << std::setprecision(2) << names[r] << ": passband ripple " << rippleMin[r] << " to " << rippleMax[r]
+            << " dB up to " << std::setprecision(0) << PASSBAND << " Hz, stopband " << std::setprecision(2) << stopMax[r]
+            << " dB from " << std::setprecision(0) << STOPBAND << " Hz" << std::endl;
+    }
+
+    std::cout << std::setprecision(2) << "Filtering time two pass " << twoPassTime * 1000. / CLOCKS_PER_SEC << " ms, polyphase "
+        << polyphaseTime * 1000. / CLOCKS_PER_SEC << " ms" << std::endl;
+}
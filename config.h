@@ -3,6 +3,9 @@
 /* Define if building universal (internal helper macro) */
 #undef AC_APPLE_UNIVERSAL_BUILD
 
+/* Define to 1 if you have the <dirent.h> header file. */
+#undef HAVE_DIRENT_H
+
 /* Define to 1 if you have the <dlfcn.h> header file. */
 #undef HAVE_DLFCN_H
 
@@ -15,6 +18,9 @@
 /* Define to 1 if you have the <mmintrin.h> header file. */
 #undef HAVE_MMINTRIN_H
 
+/* Define to 1 if you have the <pthread.h> header file. */
+#undef HAVE_PTHREAD_H
+
 /* Define to 1 if you have the <stdint.h> header file. */
 #undef HAVE_STDINT_H
 
@@ -39,6 +45,9 @@
 /* Define to 1 if you have the `strnicmp' function. */
 #undef HAVE_STRNICMP
 
+/* Define to 1 if you have the <sys/mman.h> header file. */
+#undef HAVE_SYS_MMAN_H
+
 /* Define to 1 if you have the <sys/stat.h> header file. */
 #undef HAVE_SYS_STAT_H
 
@@ -52,6 +61,12 @@
    */
 #undef LT_OBJDIR
 
+/* Define to 1 if the compiler supports x86 SIMD function targets. */
+#undef HAVE_X86_SIMD_DISPATCH
+
+/* Define to 1 to dispatch CPU cycles through a switch. */
+#undef MOS6510_SWITCH_DISPATCH
+
 /* Name of package */
 #undef PACKAGE
 
@@ -76,6 +91,9 @@
 /* Path to Lorenz' testsuite. */
 #undef PC64_TESTSUITE
 
+/* Define to 1 to collect emulation statistics. */
+#undef SIDPLAYFP_PROFILING
+
 /* The size of `int', as computed by sizeof. */
 #undef SIZEOF_INT
 
@@ -149,9 +149,17 @@ bool WavFile::open(AudioConfig &cfg)
 
 bool WavFile::write()
 {
+    return write(_settings.bufSize);
+}
+
+bool WavFile::write(uint_least32_t samples)
+{
+    if (samples > _settings.bufSize)
+        samples = _settings.bufSize;
+
     if (file && !file->fail())
     {
-        unsigned long int bytes = _settings.bufSize;
+        unsigned long int bytes = samples;
         if (!headerWritten)
         {
             file->write((char*)&wavHdr,sizeof(wavHeader));
@@ -166,9 +174,9 @@ bool WavFile::write()
         }
         else
         {
-            std::vector<float> buffer(_settings.bufSize);
+            std::vector<float> buffer(samples);
             bytes *= 4;
-            for (unsigned long i=0;i<_settings.bufSize;i++)
+            for (unsigned long i=0;i<samples;i++)
             {
                 buffer[i] = ((float)_sampleBuffer[i])/32768.f;
             }
@@ -180,6 +188,27 @@ bool WavFile::write()
     return true;
 }
 
+bool WavFile::write(const float *samples, uint_least32_t count)
+{
+    if (precision != 32)
+        return false;
+
+    if (file && !file->fail())
+    {
+        if (!headerWritten)
+        {
+            file->write((char*)&wavHdr,sizeof(wavHeader));
+            headerWritten = true;
+        }
+
+        /* XXX endianness... */
+        const unsigned long int bytes = count * sizeof(float);
+        file->write((const char*)samples, bytes);
+        byteCount += bytes;
+    }
+    return true;
+}
+
 void WavFile::close()
 {
     if (file && !file->fail())
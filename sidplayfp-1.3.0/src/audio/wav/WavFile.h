@@ -86,6 +86,12 @@ public:
     // After write call old buffer is invalid and you should
     // use the new buffer provided instead.
     bool write();
+
+    // Write only the first samples of the buffer.
+    bool write(uint_least32_t samples);
+
+    // Write float samples from another buffer, 32 bit precision only.
+    bool write(const float *samples, uint_least32_t count);
     void close();
     void pause() {}
     void reset() {}
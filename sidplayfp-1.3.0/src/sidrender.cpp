@@ -0,0 +1,694 @@
+/*
+ * This file is part of sidplayfp, a SID player.
+ *
+ * Copyright 2014 Leandro Nini <drfiemost@users.sourceforge.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+//
+// sidrender - render tunes to files without user interaction
+//
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "audio/AudioConfig.h"
+#include "audio/wav/WavFile.h"
+
+#include "../../sidplayfp/SidTune.h"
+#include "../../sidplayfp/sidplayfp.h"
+#include "../../sidplayfp/SidConfig.h"
+#include "../../sidplayfp/SidTuneInfo.h"
+#include "../../sidplayfp/SidInfo.h"
+#include "../../utils/SidDatabase.h"
+
+#include <sidplayfp/sidbuilder.h>
+
+#ifdef HAVE_SIDPLAYFP_BUILDERS_RESIDFP_H
+#  include <sidplayfp/builders/residfp.h>
+#endif
+
+#ifdef HAVE_SIDPLAYFP_BUILDERS_RESID_H
+#  include <sidplayfp/builders/resid.h>
+#endif
+
+using std::cout;
+using std::cerr;
+using std::endl;
+
+/// Length used when neither given nor found in the songlength database.
+static const uint_least32_t DEFAULT_LENGTH = 180;
+
+/**
+ * A tune to render, with the options in effect
+ * where it appears on the command line.
+ */
+struct job_t
+{
+    const char *file;
+    unsigned int song;
+    bool allSongs;
+    uint_least32_t length;  // seconds, 0 for the default
+};
+
+struct options_t
+{
+    bool resid;
+    bool resample;
+    bool stereo;
+    bool raw;
+    bool quiet;
+    int precision;
+    uint_least32_t frequency;
+    uint_least16_t powerOnDelay;
+    const char *output;
+    const char *outputDir;
+    const char *database;
+    double minSpeed;
+    SidConfig::stem_mode_t stems;
+};
+
+static void displayArgs()
+{
+    cerr << "Syntax: sidrender [options] <tune> [[options] <tune> ...]" << endl
+         << "Options -o and -t apply to the tunes after them." << endl
+         << " -o<num>         song to render, default is the tune's start song" << endl
+         << " -a              render all the songs" << endl
+         << " -t<num>         length [mm:]ss, default from the songlength database or "
+         << DEFAULT_LENGTH / 60 << ':' << std::setw(2) << std::setfill('0') << DEFAULT_LENGTH % 60 << endl
+         << " -l<file>        songlength database" << endl
+         << " -f<num>         sampling frequency, default " << SidConfig::DEFAULT_SAMPLING_FREQ << endl
+         << " -p<16|32>       16 bit integer or 32 bit float samples, default 16" << endl
+         << " -s              stereo playback" << endl
+         << " -w<file>        output file, - for stdout, only with a single song" << endl
+         << " -d<dir>         directory for the files named after the tunes" << endl
+         << " --raw           raw samples instead of wav" << endl
+         << " --stems[=unfiltered] also write each voice to its own mono file," << endl
+         << "                 named after the output with -v<num> appended" << endl
+         << " --null          render without writing anything" << endl
+#ifdef HAVE_SIDPLAYFP_BUILDERS_RESIDFP_H
+         << " --residfp       use reSIDfp emulation (default)" << endl
+#endif
+#ifdef HAVE_SIDPLAYFP_BUILDERS_RESID_H
+         << " --resid         use reSID emulation" << endl
+#endif
+         << " --resample      resample instead of interpolating" << endl
+         << " --delay=<num>   power on delay, default is random" << endl
+         << " --min-speed=<x> fail if a tune renders slower than x times realtime" << endl
+         << " -q              only report errors" << endl;
+}
+
+static bool parseTime(const char *str, uint_least32_t &time)
+{
+    if (*str == '\0')
+        return false;
+
+    const char *sep = strchr(str, ':');
+    if (!sep)
+    {
+        time = atoi(str);
+        return true;
+    }
+
+    const int minutes = atoi(str);
+    const int seconds = atoi(sep + 1);
+    if (minutes < 0 || seconds < 0 || seconds > 59)
+        return false;
+
+    time = minutes * 60 + seconds;
+    return true;
+}
+
+/**
+ * Build the output name from the tune file name and song.
+ */
+static std::string outputName(const options_t &opt, const char *file, unsigned int song)
+{
+    std::string name(file);
+
+    const size_t slash = name.find_last_of("/\\");
+    if (slash != std::string::npos)
+        name.erase(0, slash + 1);
+
+    const size_t dot = name.find_last_of('.');
+    if (dot != std::string::npos)
+        name.erase(dot);
+
+    std::ostringstream out;
+    if (opt.outputDir)
+        out << opt.outputDir << '/';
+    out << name << '-' << song << (opt.raw ? ".raw" : WavFile::extension());
+    return out.str();
+}
+
+/**
+ * Raw output, same sample formats as the wav files.
+ */
+class RawFile
+{
+private:
+    std::ostream *m_file;
+
+public:
+    RawFile(const std::string &name) :
+        m_file((name == "-") ? &cout : new std::ofstream(name.c_str(), std::ios::out|std::ios::binary|std::ios::trunc)) {}
+
+    ~RawFile()
+    {
+        if (m_file != &cout)
+            delete m_file;
+    }
+
+    bool fail() const { return m_file->fail(); }
+
+    void write(const short *buffer, uint_least32_t samples)
+    {
+        m_file->write((const char*)buffer, samples * sizeof(short));
+    }
+
+    void write(const float *buffer, uint_least32_t samples)
+    {
+        m_file->write((const char*)buffer, samples * sizeof(float));
+    }
+};
+
+/**
+ * The stems of a song, a mono file for each voice.
+ */
+class StemFiles
+{
+private:
+    std::vector<WavFile*> m_wav;
+    std::vector<RawFile*> m_raw;
+    std::vector<std::vector<short> > m_buffers;
+    std::vector<std::vector<float> > m_floatBuffers;
+    std::vector<short*> m_samples;
+    std::vector<float*> m_floatSamples;
+
+private:
+    // prevent copying
+    StemFiles(const StemFiles&);
+    StemFiles& operator=(StemFiles&);
+
+public:
+    StemFiles() {}
+
+    ~StemFiles()
+    {
+        close();
+
+        for (size_t i = 0; i < m_wav.size(); i++)
+            delete m_wav[i];
+        for (size_t i = 0; i < m_raw.size(); i++)
+            delete m_raw[i];
+    }
+
+    /**
+     * Open the files, output.wav gives output-v1.wav, output-v2.wav and so on.
+     *
+     * @param frames the most frames written at once
+     */
+    bool open(const options_t &opt, const std::string &output, unsigned int voices, uint_least32_t frames)
+    {
+        std::string base(output);
+        std::string extension;
+        const size_t dot = base.find_last_of('.');
+        if (dot != std::string::npos && base.find_first_of("/\\", dot) == std::string::npos)
+        {
+            extension = base.substr(dot);
+            base.erase(dot);
+        }
+
+        // Float samples are always rendered to our own buffers
+        if (opt.precision == 32)
+            m_floatBuffers.assign(voices, std::vector<float>(frames));
+        else if (opt.raw)
+            m_buffers.assign(voices, std::vector<short>(frames));
+
+        for (unsigned int v = 0; v < voices; v++)
+        {
+            std::ostringstream name;
+            name << base << "-v" << v + 1 << extension;
+
+            if (opt.raw)
+            {
+                m_raw.push_back(new RawFile(name.str()));
+                if (opt.precision == 32)
+                    m_floatSamples.push_back(&m_floatBuffers[v][0]);
+                else
+                    m_samples.push_back(&m_buffers[v][0]);
+                if (m_raw.back()->fail())
+                {
+                    cerr << "Can't open " << name.str() << endl;
+                    return false;
+                }
+            }
+            else
+            {
+                AudioConfig cfg;
+                cfg.frequency = opt.frequency;
+                cfg.precision = opt.precision;
+                cfg.channels = 1;
+
+                m_wav.push_back(new WavFile(name.str().c_str()));
+                if (!m_wav.back()->open(cfg) || m_wav.back()->fail() || cfg.bufSize < frames)
+                {
+                    cerr << "Can't open " << name.str() << endl;
+                    return false;
+                }
+                if (opt.precision == 32)
+                    m_floatSamples.push_back(&m_floatBuffers[v][0]);
+                else
+                    m_samples.push_back(m_wav.back()->buffer());
+            }
+        }
+
+        return true;
+    }
+
+    short **buffers() { return m_samples.empty() ? 0 : &m_samples[0]; }
+
+    float **floatBuffers() { return m_floatSamples.empty() ? 0 : &m_floatSamples[0]; }
+
+    void write(uint_least32_t frames)
+    {
+        const bool wide = !m_floatSamples.empty();
+
+        for (size_t i = 0; i < m_wav.size(); i++)
+        {
+            if (wide)
+                m_wav[i]->write(m_floatSamples[i], frames);
+            else
+                m_wav[i]->write(frames);
+        }
+        for (size_t i = 0; i < m_raw.size(); i++)
+        {
+            if (wide)
+                m_raw[i]->write(m_floatSamples[i], frames);
+            else
+                m_raw[i]->write(m_samples[i], frames);
+        }
+    }
+
+    void close()
+    {
+        for (size_t i = 0; i < m_wav.size(); i++)
+            m_wav[i]->close();
+    }
+};
+
+/**
+ * Render a song.
+ * Float samples come straight from the engine's float output,
+ * not from the 16 bit one.
+ *
+ * @return the CPU time taken in seconds, negative on errors
+ */
+static double render(const options_t &opt, sidplayfp &engine, SidTune &tune,
+                     uint_least32_t length, const std::string &output)
+{
+    if (!engine.load(&tune))
+    {
+        cerr << engine.error() << endl;
+        return -1.;
+    }
+
+    if (opt.stems != SidConfig::STEMS_OFF && output == "-")
+    {
+        cerr << "Stems can't be written to stdout" << endl;
+        return -1.;
+    }
+
+    AudioConfig cfg;
+    cfg.frequency = opt.frequency;
+    cfg.precision = opt.precision;
+    cfg.channels = opt.stereo ? 2 : 1;
+
+    std::auto_ptr<WavFile> wav;
+    std::auto_ptr<RawFile> raw;
+    std::vector<short> buffer;
+    std::vector<float> floatBuffer;
+
+    if (!output.empty() && opt.raw)
+    {
+        raw.reset(new RawFile(output));
+        if (raw->fail())
+        {
+            cerr << "Can't open " << output << endl;
+            return -1.;
+        }
+    }
+    else if (!output.empty())
+    {
+        wav.reset(new WavFile(output.c_str()));
+        if (!wav->open(cfg) || wav->fail())
+        {
+            cerr << "Can't open " << output << endl;
+            return -1.;
+        }
+    }
+
+    const bool wide = opt.precision == 32;
+    short *samples = 0;
+    uint_least32_t size;
+
+    if (wide)
+    {
+        floatBuffer.resize(cfg.frequency * cfg.channels);
+        size = floatBuffer.size();
+    }
+    else if (wav.get())
+    {
+        samples = wav->buffer();
+        size = cfg.bufSize;
+    }
+    else
+    {
+        buffer.resize(cfg.frequency * cfg.channels);
+        samples = &buffer[0];
+        size = buffer.size();
+    }
+
+    // Three voices for each SID
+    StemFiles stems;
+    if (opt.stems != SidConfig::STEMS_OFF && !output.empty()
+        && !stems.open(opt, output, 3 * engine.info().channels(), size / cfg.channels))
+        return -1.;
+
+    uint_least32_t left = length * cfg.frequency * cfg.channels;
+
+    const clock_t start = clock();
+
+    while (left)
+    {
+        const uint_least32_t count = (left < size) ? left : size;
+        uint_least32_t played;
+
+        if (wide)
+        {
+            played = stems.floatBuffers() ?
+                engine.playFloat(&floatBuffer[0], count, stems.floatBuffers())
+                : engine.playFloat(&floatBuffer[0], count);
+
+            if (wav.get())
+                wav->write(&floatBuffer[0], played);
+            else if (raw.get())
+                raw->write(&floatBuffer[0], played);
+        }
+        else
+        {
+            played = stems.buffers() ?
+                engine.play(samples, count, stems.buffers()) : engine.play(samples, count);
+
+            if (wav.get())
+                wav->write(played);
+            else if (raw.get())
+                raw->write(samples, played);
+        }
+
+        stems.write(played / cfg.channels);
+
+        if (played < count)
+        {
+            cerr << engine.error() << endl;
+            return -1.;
+        }
+
+        left -= count;
+    }
+
+    const clock_t end = clock();
+
+    if (wav.get())
+        wav->close();
+
+    stems.close();
+
+    return (double)(end - start) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, const char *argv[])
+{
+    options_t opt;
+    opt.resid = false;
+    opt.resample = false;
+    opt.stereo = false;
+    opt.raw = false;
+    opt.quiet = false;
+    opt.precision = 16;
+    opt.frequency = SidConfig::DEFAULT_SAMPLING_FREQ;
+    opt.powerOnDelay = SidConfig::DEFAULT_POWER_ON_DELAY;
+    opt.output = 0;
+    opt.outputDir = 0;
+    opt.database = 0;
+    opt.minSpeed = 0.;
+    opt.stems = SidConfig::STEMS_OFF;
+
+#ifndef HAVE_SIDPLAYFP_BUILDERS_RESIDFP_H
+    opt.resid = true;
+#endif
+
+    bool writeNothing = false;
+
+    std::vector<job_t> jobs;
+    job_t current;
+    current.song = 0;
+    current.allSongs = false;
+    current.length = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        bool err = false;
+
+        if (arg[0] != '-' || arg[1] == '\0')
+        {
+            current.file = arg;
+            jobs.push_back(current);
+        }
+        else if (arg[1] == 'o')
+        {
+            current.song = atoi(arg + 2);
+            current.allSongs = false;
+        }
+        else if (arg[1] == 'a')
+            current.allSongs = true;
+        else if (arg[1] == 't')
+            err = !parseTime(arg + 2, current.length);
+        else if (arg[1] == 'l')
+            opt.database = arg + 2;
+        else if (arg[1] == 'f')
+            opt.frequency = atoi(arg + 2);
+        else if (arg[1] == 'p')
+        {
+            opt.precision = atoi(arg + 2);
+            err = opt.precision != 16 && opt.precision != 32;
+        }
+        else if (arg[1] == 's')
+            opt.stereo = true;
+        else if (arg[1] == 'w')
+            opt.output = arg + 2;
+        else if (arg[1] == 'd')
+            opt.outputDir = arg + 2;
+        else if (arg[1] == 'q')
+            opt.quiet = true;
+        else if (strcmp(arg + 1, "-raw") == 0)
+            opt.raw = true;
+        else if (strcmp(arg + 1, "-null") == 0)
+            writeNothing = true;
+        else if (strcmp(arg + 1, "-stems") == 0)
+            opt.stems = SidConfig::STEMS_FILTERED;
+        else if (strcmp(arg + 1, "-stems=unfiltered") == 0)
+            opt.stems = SidConfig::STEMS_UNFILTERED;
+#ifdef HAVE_SIDPLAYFP_BUILDERS_RESIDFP_H
+        else if (strcmp(arg + 1, "-residfp") == 0)
+            opt.resid = false;
+#endif
+#ifdef HAVE_SIDPLAYFP_BUILDERS_RESID_H
+        else if (strcmp(arg + 1, "-resid") == 0)
+            opt.resid = true;
+#endif
+        else if (strcmp(arg + 1, "-resample") == 0)
+            opt.resample = true;
+        else if (strncmp(arg + 1, "-delay=", 7) == 0)
+            opt.powerOnDelay = atoi(arg + 8);
+        else if (strncmp(arg + 1, "-min-speed=", 11) == 0)
+            opt.minSpeed = atof(arg + 12);
+        else
+            err = true;
+
+        if (err)
+        {
+            cerr << "Bad option " << arg << endl;
+            displayArgs();
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (jobs.empty())
+    {
+        displayArgs();
+        return EXIT_FAILURE;
+    }
+
+    std::auto_ptr<sidbuilder> builder;
+#ifdef HAVE_SIDPLAYFP_BUILDERS_RESID_H
+    if (opt.resid)
+    {
+        ReSIDBuilder *rs = new ReSIDBuilder("sidrender");
+        builder.reset(rs);
+        rs->create(2);
+    }
+#endif
+#ifdef HAVE_SIDPLAYFP_BUILDERS_RESIDFP_H
+    if (!opt.resid)
+    {
+        ReSIDfpBuilder *rs = new ReSIDfpBuilder("sidrender");
+        builder.reset(rs);
+        rs->create(2);
+    }
+#endif
+
+    if (!builder.get() || !builder->getStatus())
+    {
+        cerr << (builder.get() ? builder->error() : "No SID emulation available") << endl;
+        return EXIT_FAILURE;
+    }
+
+    sidplayfp engine;
+
+    SidConfig cfg;
+    cfg.frequency = opt.frequency;
+    cfg.powerOnDelay = opt.powerOnDelay;
+    cfg.playback = opt.stereo ? SidConfig::STEREO : SidConfig::MONO;
+    cfg.samplingMethod = opt.resample ? SidConfig::RESAMPLE_INTERPOLATE : SidConfig::INTERPOLATE;
+    cfg.sidEmulation = builder.get();
+    cfg.stemMode = opt.stems;
+    if (!engine.config(cfg))
+    {
+        cerr << engine.error() << endl;
+        return EXIT_FAILURE;
+    }
+
+    SidDatabase database;
+    if (opt.database && !database.open(opt.database))
+    {
+        cerr << database.error() << endl;
+        return EXIT_FAILURE;
+    }
+
+    int status = EXIT_SUCCESS;
+    uint_least32_t totalLength = 0;
+    double totalTime = 0.;
+    unsigned int songs = 0;
+
+    for (std::vector<job_t>::const_iterator job = jobs.begin(); job != jobs.end(); ++job)
+    {
+        SidTune tune(job->file);
+        if (!tune.getStatus())
+        {
+            cerr << job->file << ": " << tune.statusString() << endl;
+            status = EXIT_FAILURE;
+            continue;
+        }
+
+        unsigned int first = job->song;
+        unsigned int last = job->song;
+        if (job->allSongs)
+        {
+            first = 1;
+            last = tune.getInfo()->songs();
+        }
+
+        for (unsigned int song = first; song <= last; song++)
+        {
+            const unsigned int selected = tune.selectSong(song);
+
+            uint_least32_t length = job->length;
+            if (!length && opt.database)
+            {
+                const int_least32_t dbLength = database.length(tune);
+                if (dbLength > 0)
+                    length = dbLength;
+            }
+            if (!length)
+                length = DEFAULT_LENGTH;
+
+            std::string output;
+            if (!writeNothing)
+            {
+                if (opt.output && (jobs.size() > 1 || first != last))
+                {
+                    cerr << "Use -d instead of -w for more than one song" << endl;
+                    return EXIT_FAILURE;
+                }
+
+                output = opt.output ? opt.output : outputName(opt, job->file, selected);
+            }
+
+            const double elapsed = render(opt, engine, tune, length, output);
+            if (elapsed < 0.)
+            {
+                cerr << job->file << ": rendering song " << selected << " failed" << endl;
+                status = EXIT_FAILURE;
+                continue;
+            }
+
+            songs++;
+            totalLength += length;
+            totalTime += elapsed;
+
+            // Too fast for the clock() resolution counts as fast enough
+            const double speed = (elapsed > 0.) ? length / elapsed : 0.;
+
+            if (!opt.quiet)
+            {
+                cerr << job->file << " song " << selected << ": " << length << " s";
+                if (elapsed > 0.)
+                    cerr << " at " << std::fixed << std::setprecision(1) << speed << "x realtime";
+                cerr << endl;
+            }
+
+            if (elapsed > 0. && speed < opt.minSpeed)
+            {
+                cerr << job->file << " song " << selected << ": slower than "
+                     << opt.minSpeed << "x realtime" << endl;
+                status = EXIT_FAILURE;
+            }
+        }
+    }
+
+    if (!opt.quiet && songs > 1)
+    {
+        cerr << songs << " songs, " << totalLength << " s in " << std::fixed << std::setprecision(2) << totalTime
+             << " s CPU time, " << std::setprecision(1) << ((totalTime > 0.) ? totalLength / totalTime : 0.)
+             << "x realtime" << endl;
+    }
+
+    return status;
+}
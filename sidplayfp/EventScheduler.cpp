@@ -22,15 +22,56 @@
 
 #include "EventScheduler.h"
 
+#include <algorithm>
+
+#include "sidstate.h"
+
 
 void EventScheduler::reset()
 {
     currentTime = 0;
     firstEvent = 0;
+    occupied = 0;
+    for (unsigned int i = 0; i < BUCKETS; i++)
+    {
+        bucketHead[i] = 0;
+        bucketTail[i] = 0;
+    }
 }
 
 void EventScheduler::cancel(Event &event)
 {
+    if (queue == CALENDAR && inCalendar(event.triggerTime))
+    {
+        const unsigned int idx = static_cast<unsigned int>(event.triggerTime) & (BUCKETS - 1);
+        const uint64_t bit = uint64_t(1) << idx;
+        if (!(occupied & bit))
+            return;
+
+        Event *prev = 0;
+        Event *scan = bucketHead[idx];
+        while (scan)
+        {
+            if (&event == scan)
+            {
+                if (prev)
+                    prev->next = scan->next;
+                else
+                    bucketHead[idx] = scan->next;
+
+                if (bucketTail[idx] == scan)
+                    bucketTail[idx] = prev;
+
+                if (bucketHead[idx] == 0)
+                    occupied &= ~bit;
+                break;
+            }
+            prev = scan;
+            scan = scan->next;
+        }
+        return;
+    }
+
     Event **scan = &firstEvent;
 
     while (*scan)
@@ -47,6 +88,13 @@ void EventScheduler::cancel(Event &event)
 bool EventScheduler::isPending(Event &event) const
 {
     Event *scan = firstEvent;
+
+    if (queue == CALENDAR && inCalendar(event.triggerTime))
+    {
+        const unsigned int idx = static_cast<unsigned int>(event.triggerTime) & (BUCKETS - 1);
+        scan = (occupied & (uint64_t(1) << idx)) ? bucketHead[idx] : 0;
+    }
+
     while (scan)
     {
         if (&event == scan)
@@ -57,3 +105,70 @@ bool EventScheduler::isPending(Event &event) const
     }
     return false;
 }
+
+bool EventScheduler::serialize(sidstate &s, const std::vector<Event*> &events)
+{
+    if (s.saving())
+    {
+        // Collect the pending events in firing order
+        std::vector<Event*> pending;
+
+        if (queue == CALENDAR)
+        {
+            for (unsigned int i = 0; i < BUCKETS; i++)
+            {
+                const unsigned int idx = static_cast<unsigned int>(currentTime + i) & (BUCKETS - 1);
+                if (occupied & (uint64_t(1) << idx))
+                {
+                    for (Event *scan = bucketHead[idx]; scan; scan = scan->next)
+                        pending.push_back(scan);
+                }
+            }
+        }
+
+        for (Event *scan = firstEvent; scan; scan = scan->next)
+            pending.push_back(scan);
+
+        uint32_t count = (uint32_t)pending.size();
+        s.io(currentTime);
+        s.io(count);
+
+        for (std::vector<Event*>::const_iterator it = pending.begin(); it != pending.end(); ++it)
+        {
+            const std::vector<Event*>::const_iterator pos = std::find(events.begin(), events.end(), *it);
+            if (pos == events.end())
+                return false;
+
+            uint32_t index = (uint32_t)(pos - events.begin());
+            s.io(index);
+            s.io((*it)->triggerTime);
+        }
+        return true;
+    }
+
+    event_clock_t time = 0;
+    uint32_t count = 0;
+    s.io(time);
+    s.io(count);
+    if (s.failed())
+        return false;
+
+    reset();
+    currentTime = time;
+
+    // Scheduling in firing order keeps the order of simultaneous events
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t index = 0;
+        event_clock_t triggerTime = 0;
+        s.io(index);
+        s.io(triggerTime);
+        if (s.failed() || index >= events.size() || triggerTime < currentTime)
+            return false;
+
+        Event &event = *events[index];
+        event.triggerTime = triggerTime;
+        schedule(event);
+    }
+    return true;
+}
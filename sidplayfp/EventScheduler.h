@@ -23,7 +23,12 @@
 #ifndef EVENTSCHEDULER_H
 #define EVENTSCHEDULER_H
 
+#include <vector>
+
 #include "event.h"
+#include "sidprofile.h"
+
+class sidstate;
 
 
 template< class This >
@@ -50,10 +55,36 @@ public:
 /**
  * Fast EventScheduler implementation
  *
+ * Two queue backends are available, selected at construction:
+ * - LINKED_LIST keeps all events in a single chain sorted by trigger time,
+ *   inserts scan the chain from the head.
+ * - CALENDAR keeps events due within the next #BUCKETS clock ticks
+ *   in a ring of per-tick FIFO buckets indexed by trigger time,
+ *   making the common "next cycle" insert and the pop O(1).
+ *   Events further in the future are kept in a sorted chain and are
+ *   moved into the ring when they get close enough.
+ *
+ * Both backends fire events in the same order: by trigger time,
+ * and in scheduling order for events with the same trigger time.
+ *
  * @author Antti S. Lankila
  */
 class EventScheduler: public EventContext
 {
+public:
+    typedef enum
+    {
+        LINKED_LIST = 0,   ///< single sorted chain
+        CALENDAR           ///< bucketed calendar queue
+    } queue_t;
+
+private:
+    /**
+     * Number of clock ticks (half cycles) covered by the calendar ring.
+     * Must match the width of #occupied.
+     */
+    static const unsigned int BUCKETS = 64;
+
 private:
     /**
      * EventScheduler's current clock.
@@ -62,10 +93,114 @@ private:
 
     /**
      * The first event of the chain.
+     * With the calendar queue this holds only the far events.
      */
     Event *firstEvent;
 
+    /**
+     * The queue backend in use.
+     */
+    const queue_t queue;
+
+    /**
+     * Calendar ring buckets, each one holds the events
+     * for a single trigger time in scheduling order.
+     */
+    //@{
+    Event *bucketHead[BUCKETS];
+    Event *bucketTail[BUCKETS];
+    //@}
+
+    /**
+     * Bitmask of non empty buckets.
+     */
+    uint64_t occupied;
+
 private:
+    /**
+     * Index of the lowest set bit of a non zero value.
+     */
+    static unsigned int lowestBit(uint64_t value)
+    {
+#if defined(__GNUC__)
+        return __builtin_ctzll(value);
+#else
+        unsigned int bit = 0;
+        while (!(value & 1))
+        {
+            value >>= 1;
+            bit++;
+        }
+        return bit;
+#endif
+    }
+
+    /**
+     * Check if trigger time falls into the calendar ring.
+     */
+    bool inCalendar(event_clock_t triggerTime) const
+    {
+        return static_cast<uint_fast64_t>(triggerTime - currentTime) < BUCKETS;
+    }
+
+    /**
+     * Bitmask of non empty buckets, rotated so that
+     * bit 0 corresponds to the current time.
+     */
+    uint64_t occupiedFromNow() const
+    {
+        const unsigned int shift = static_cast<unsigned int>(currentTime) & (BUCKETS - 1);
+        return shift ? (occupied >> shift) | (occupied << (BUCKETS - shift)) : occupied;
+    }
+
+    /**
+     * Check if any event is due up to trigger time.
+     */
+    bool dueInCalendar(event_clock_t triggerTime) const
+    {
+        if (!inCalendar(triggerTime))
+            return true;
+
+        const unsigned int span = static_cast<unsigned int>(triggerTime - currentTime) + 1;
+        const uint64_t window = (span < BUCKETS) ? (uint64_t(1) << span) - 1 : ~uint64_t(0);
+        return (occupiedFromNow() & window) != 0;
+    }
+
+    /**
+     * Append event to the tail of its calendar bucket.
+     */
+    void pushBucket(Event &event)
+    {
+        const unsigned int idx = static_cast<unsigned int>(event.triggerTime) & (BUCKETS - 1);
+        const uint64_t bit = uint64_t(1) << idx;
+        event.next = 0;
+        if (!(occupied & bit))
+        {
+            bucketHead[idx] = &event;
+            occupied |= bit;
+        }
+        else
+        {
+            bucketTail[idx]->next = &event;
+        }
+        bucketTail[idx] = &event;
+    }
+
+    /**
+     * Move far events which entered the calendar window into the ring.
+     * Must run every time the clock advances, before any event
+     * is scheduled at the new time, to preserve FIFO ordering.
+     */
+    void migrate()
+    {
+        while (firstEvent != 0 && inCalendar(firstEvent->triggerTime))
+        {
+            Event &event = *firstEvent;
+            firstEvent = event.next;
+            pushBucket(event);
+        }
+    }
+
     /**
      * Scan the event queue and schedule event for execution.
      *
@@ -73,6 +208,12 @@ private:
      */
     void schedule(Event &event)
     {
+        if (queue == CALENDAR && inCalendar(event.triggerTime))
+        {
+            pushBucket(event);
+            return;
+        }
+
         // find the right spot where to tuck this new event
         Event **scan = &firstEvent;
         for (;;)
@@ -87,6 +228,31 @@ private:
          }
     }
 
+    /**
+     * Remove and return the next event from the calendar queue.
+     */
+    Event &popCalendar()
+    {
+        if (occupied == 0)
+        {
+            Event &event = *firstEvent;
+            firstEvent = event.next;
+            return event;
+        }
+
+        // buckets are searched starting from the current time
+        const unsigned int idx = (static_cast<unsigned int>(currentTime)
+            + lowestBit(occupiedFromNow())) & (BUCKETS - 1);
+
+        Event &event = *bucketHead[idx];
+        bucketHead[idx] = event.next;
+        if (bucketHead[idx] == 0)
+        {
+            occupied &= ~(uint64_t(1) << idx);
+        }
+        return event;
+    }
+
 protected:
     void schedule(Event &event, event_clock_t cycles,
                    event_phase_t phase)
@@ -104,10 +270,39 @@ protected:
 
     void cancel(Event &event);
 
+    bool advance(Event &event, event_clock_t cycles)
+    {
+        const event_clock_t triggerTime = (cycles << 1) + currentTime;
+
+        const bool due = (queue == CALENDAR) ?
+            dueInCalendar(triggerTime) :
+            (firstEvent != 0 && firstEvent->triggerTime <= triggerTime);
+
+        if (due)
+        {
+            event.triggerTime = triggerTime;
+            schedule(event);
+            return false;
+        }
+
+        currentTime = triggerTime;
+        if (queue == CALENDAR)
+            migrate();
+        // Running inline counts as firing
+        if (sidprofile::enabled)
+            event.m_fired++;
+        return true;
+    }
+
 public:
-    EventScheduler () :
+    EventScheduler(queue_t queueType = CALENDAR) :
           currentTime(0),
-          firstEvent(0) {}
+          firstEvent(0),
+          queue(queueType),
+          occupied(0)
+    {
+        reset();
+    }
 
     /**
      * Cancel all pending events and reset time.
@@ -119,17 +314,54 @@ public:
      */
     void clock()
     {
+        if (queue == CALENDAR)
+        {
+            Event &event = popCalendar();
+            currentTime = event.triggerTime;
+            migrate();
+            if (sidprofile::enabled)
+                event.m_fired++;
+            event.event();
+            return;
+        }
+
         Event &event = *firstEvent;
         firstEvent = firstEvent->next;
         currentTime = event.triggerTime;
+        if (sidprofile::enabled)
+            event.m_fired++;
         event.event();
     }
 
+    /**
+     * Clear the number of times an event fired.
+     *
+     * @param event the event
+     */
+    static void resetFired(Event &event) { event.m_fired = 0; }
+
+    /**
+     * Save or restore the time and the pending events.
+     * Events are identified by their position in the list,
+     * which must be the same when restoring.
+     * Restoring drops all the pending events first.
+     *
+     * @param s the state stream
+     * @param events all the events that can be pending
+     * @return false if a pending event is not in the list
+     */
+    bool serialize(sidstate &s, const std::vector<Event*> &events);
+
     /**
      * Check if an event is in the queue.
      */
     bool isPending(Event &event) const;
 
+    /**
+     * Get the queue backend in use.
+     */
+    queue_t queueType() const { return queue; }
+
     event_clock_t getTime(event_phase_t phase) const
     {
         return (currentTime + (phase ^ 1)) >> 1;
@@ -37,5 +37,6 @@ SidConfig::SidConfig() :
     rightVolume(Mixer::VOLUME_MAX),
     powerOnDelay(DEFAULT_POWER_ON_DELAY),
     samplingMethod(RESAMPLE_INTERPOLATE),
-    fastSampling(false)
+    fastSampling(false),
+    stemMode(STEMS_OFF)
 {}
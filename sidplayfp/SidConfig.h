@@ -43,6 +43,7 @@ public:
     typedef enum {MOS6581, MOS8580} sid_model_t;
     typedef enum {PAL, NTSC, OLD_NTSC, DREAN} c64_model_t;
     typedef enum {INTERPOLATE, RESAMPLE_INTERPOLATE} sampling_method_t;
+    typedef enum {STEMS_OFF, STEMS_UNFILTERED, STEMS_FILTERED} stem_mode_t;
 
 public:
     /**
@@ -133,6 +134,15 @@ public:
      */
     bool fastSampling;
 
+    /**
+     * Render each voice to its own buffer along with the mix,
+     * see sidplayfp::play, available only for reSIDfp.
+     * - STEMS_OFF
+     * - STEMS_UNFILTERED: the voices bypass the filter
+     * - STEMS_FILTERED: the voices go through the filter
+     */
+    stem_mode_t stemMode;
+
 public:
     SidConfig();
 };
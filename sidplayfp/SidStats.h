@@ -0,0 +1,77 @@
+/*
+ * This file is part of libsidplayfp, a SID player engine.
+ *
+ *  Copyright 2014 Leandro Nini <drfiemost@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef SIDSTATS_H
+#define SIDSTATS_H
+
+#include <stdint.h>
+
+/**
+ * This interface is used to get the emulation statistics,
+ * showing where the time goes while playing.
+ *
+ * The statistics are only collected when the library is built
+ * with --enable-profiling, otherwise all the counters stay at zero.
+ * Times are wall clock times in nanoseconds.
+ */
+class SidStats
+{
+public:
+    /// Whether the library collects the statistics
+    virtual bool enabled() const =0;
+
+    /// Events fired, summed by event name
+    //@{
+    virtual unsigned int numberOfEvents() const =0;
+    virtual const char *eventName(unsigned int i) const =0;
+    virtual uint_least64_t eventCount(unsigned int i) const =0;
+    //@}
+
+    /// Per SID figures
+    //@{
+    virtual unsigned int numberOfSids() const =0;
+
+    /// Cycles clocked, including the catch up on register access
+    virtual uint_least64_t sidCycles(unsigned int i) const =0;
+
+    /// Samples produced by the resampler
+    virtual uint_least64_t sidSamples(unsigned int i) const =0;
+
+    /// Time spent clocking the SID for the mixer
+    virtual uint_least64_t sidTime(unsigned int i) const =0;
+    //@}
+
+    /// Frames mixed into the output
+    virtual uint_least64_t mixerFrames() const =0;
+
+    /// Time spent mixing
+    virtual uint_least64_t mixerTime() const =0;
+
+    /// Time spent running the C64, SID catch up on register access included
+    virtual uint_least64_t emulationTime() const =0;
+
+    /// Total time spent in play
+    virtual uint_least64_t playTime() const =0;
+
+protected:
+    ~SidStats() {}
+};
+
+#endif  /* SIDSTATS_H */
@@ -0,0 +1,96 @@
+/*
+ * This file is part of libsidplayfp, a SID player engine.
+ *
+ *  Copyright 2014 Leandro Nini <drfiemost@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef SIDSTATSIMPL_H
+#define SIDSTATSIMPL_H
+
+#include <stdint.h>
+#include <vector>
+#include <string>
+
+#include "sidplayfp/SidStats.h"
+
+#include "mixer.h"
+#include "sidprofile.h"
+
+/**
+ * The implementation of the SidStats interface.
+ */
+class SidStatsImpl : public SidStats
+{
+public:
+    std::vector<std::string> m_eventNames;
+    std::vector<uint_least64_t> m_eventCounts;
+
+    std::vector<Mixer::sidstats_t> m_sids;
+
+    uint_least64_t m_mixerFrames;
+    uint_least64_t m_mixerTime;
+    uint_least64_t m_emulationTime;
+    uint_least64_t m_playTime;
+
+private:
+    // prevent copying
+    SidStatsImpl(const SidStatsImpl&);
+    SidStatsImpl& operator=(SidStatsImpl&);
+
+public:
+    SidStatsImpl() :
+        m_mixerFrames(0),
+        m_mixerTime(0),
+        m_emulationTime(0),
+        m_playTime(0) {}
+
+    /**
+     * Add the firings of an event to the count for its name.
+     */
+    void addEvent(const char *name, uint_least64_t count)
+    {
+        for (unsigned int i = 0; i < m_eventNames.size(); i++)
+        {
+            if (m_eventNames[i] == name)
+            {
+                m_eventCounts[i] += count;
+                return;
+            }
+        }
+
+        m_eventNames.push_back(name);
+        m_eventCounts.push_back(count);
+    }
+
+    bool enabled() const { return sidprofile::enabled; }
+
+    unsigned int numberOfEvents() const { return m_eventNames.size(); }
+    const char *eventName(unsigned int i) const { return i<m_eventNames.size()?m_eventNames[i].c_str():""; }
+    uint_least64_t eventCount(unsigned int i) const { return i<m_eventCounts.size()?m_eventCounts[i]:0; }
+
+    unsigned int numberOfSids() const { return m_sids.size(); }
+    uint_least64_t sidCycles(unsigned int i) const { return i<m_sids.size()?m_sids[i].cycles:0; }
+    uint_least64_t sidSamples(unsigned int i) const { return i<m_sids.size()?m_sids[i].samples:0; }
+    uint_least64_t sidTime(unsigned int i) const { return i<m_sids.size()?m_sids[i].time:0; }
+
+    uint_least64_t mixerFrames() const { return m_mixerFrames; }
+    uint_least64_t mixerTime() const { return m_mixerTime; }
+    uint_least64_t emulationTime() const { return m_emulationTime; }
+    uint_least64_t playTime() const { return m_playTime; }
+};
+
+#endif  /* SIDSTATSIMPL_H */
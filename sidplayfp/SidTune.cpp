@@ -96,6 +96,21 @@ void SidTune::read(const uint_least8_t* sourceBuffer, uint_least32_t bufferLen)
     }
 }
 
+void SidTune::attach(const uint_least8_t* sourceBuffer, uint_least32_t bufferLen)
+{
+    try
+    {
+        tune.reset(SidTuneBase::attach(sourceBuffer, bufferLen));
+        m_status = true;
+        m_statusString = MSG_NO_ERRORS;
+    }
+    catch (loadError const &e)
+    {
+        m_status = false;
+        m_statusString = e.message();
+    }
+}
+
 unsigned int SidTune::selectSong(unsigned int songNum)
 {
     return tune.get() ? tune->selectSong(songNum) : 0;
@@ -109,6 +109,18 @@ public:  // ----------------------------------------------------------------
      */
     void read(const uint_least8_t* sourceBuffer, uint_least32_t bufferLen);
 
+    /**
+     * Load a sidtune into an existing object from a buffer
+     * without copying it, e.g. a memory mapped file.
+     * PSID and RSID files are used in place until they are copied
+     * into C64 memory, other formats are copied as with #read.
+     *
+     * @param sourceBuffer the buffer that contains song data,
+     *        it must stay valid and unchanged as long as the tune is loaded
+     * @param bufferLen length of the buffer
+     */
+    void attach(const uint_least8_t* sourceBuffer, uint_least32_t bufferLen);
+
     /**
      * Select sub-song.
      *
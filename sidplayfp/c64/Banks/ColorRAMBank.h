@@ -26,6 +26,7 @@
 #include <string.h>
 
 #include "Bank.h"
+#include "sidplayfp/sidstate.h"
 
 /**
  * Color RAM.
@@ -45,6 +46,11 @@ public:
          memset(ram, 0, 0x400);
     }
 
+    /**
+     * Save or restore the RAM content.
+     */
+    void serialize(sidstate &s) { s.io(ram, 0x400); }
+
     void poke(uint_least16_t address, uint8_t value)
     {
         ram[address & 0x3ff] = value & 0xf;
@@ -27,6 +27,7 @@
 #include <memory.h>
 
 #include "Bank.h"
+#include "sidplayfp/sidstate.h"
 
 /**
  * Area backed by RAM
@@ -54,6 +55,11 @@ public:
         }
     }
 
+    /**
+     * Save or restore the RAM content.
+     */
+    void serialize(sidstate &s) { s.io(ram, 0x10000); }
+
     uint8_t peek(uint_least16_t address)
     {
         return ram[address];
@@ -26,6 +26,7 @@
 #include <cstring>
 
 #include "Bank.h"
+#include "sidplayfp/sidstate.h"
 #include "../CPU/opcodes.h"
 
 /**
@@ -179,6 +180,11 @@ public:
         setVal(0xfffc, endian_16lo8(addr));
         setVal(0xfffd, endian_16hi8(addr));
     }
+
+    /**
+     * Save or restore the RESET vector as patched by the driver.
+     */
+    void serialize(sidstate &s) { s.io(&rom[0x1ffc], 2); }
 };
 
 /**
@@ -237,6 +243,16 @@ public:
         setVal(0xbf5c, 0xb1);
         setVal(0xbf5d, 0xa7);
     }
+
+    /**
+     * Save or restore the BASIC Warm Start and subtune code
+     * as patched by the driver.
+     */
+    void serialize(sidstate &s)
+    {
+        s.io(&rom[0x07ae], 3);
+        s.io(&rom[0x1f53], 11);
+    }
 };
 
 /**
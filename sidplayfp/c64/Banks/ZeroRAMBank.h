@@ -27,6 +27,7 @@
 #include "Bank.h"
 
 #include "sidplayfp/event.h"
+#include "sidplayfp/sidstate.h"
 
 /**
  * Interface to PLA functions.
@@ -160,6 +161,24 @@ public:
         updateCpuPort();
     }
 
+    /**
+     * Save or restore the processor port state.
+     * The RAM behind it is saved by its own bank.
+     */
+    void serialize(sidstate &s)
+    {
+        s.io(dataSetClkBit6);
+        s.io(dataSetClkBit7);
+        s.io(dataFalloffBit6);
+        s.io(dataFalloffBit7);
+        s.io(dataSetBit6);
+        s.io(dataSetBit7);
+        s.io(dir);
+        s.io(data);
+        s.io(dataRead);
+        s.io(procPortPins);
+    }
+
 /*
     $00/$01 unused bits emulation, as investigated by groepaz:
 
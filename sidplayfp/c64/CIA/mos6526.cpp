@@ -27,6 +27,7 @@
 #include <memory.h>
 
 #include "../../sidendian.h"
+#include "../../sidstate.h"
 
 enum
 {
@@ -152,6 +153,31 @@ void MOS6526::reset()
     event_context.cancel(triggerEvent);
 }
 
+void MOS6526::serialize(sidstate &s)
+{
+    s.io(regs, 0x10);
+    s.io(sdr_out);
+    s.io(sdr_buffered);
+    s.io(sdr_count);
+    s.io(icr);
+    s.io(idr);
+    s.io(triggerScheduled);
+
+    timerA.serialize(s);
+    timerB.serialize(s);
+    tod.serialize(s);
+}
+
+void MOS6526::getEvents(std::vector<Event*> &events)
+{
+    events.push_back(&bTickEvent);
+    events.push_back(&triggerEvent);
+
+    timerA.getEvents(events);
+    timerB.getEvents(events);
+    tod.getEvents(events);
+}
+
 uint8_t MOS6526::read(uint_least8_t addr)
 {
     addr &= 0x0f;
@@ -25,6 +25,8 @@
 
 #include <stdint.h>
 
+#include <vector>
+
 #include "timer.h"
 #include "tod.h"
 #include "../../EventScheduler.h"
@@ -32,6 +34,7 @@
 
 class EventContext;
 class MOS6526;
+class sidstate;
 
 /**
  * This is the timer A of this CIA.
@@ -243,6 +246,16 @@ public:
      */
     virtual void reset();
 
+    /**
+     * Save or restore the CIA state.
+     */
+    void serialize(sidstate &s);
+
+    /**
+     * Get the events of the CIA, for saving the event queue.
+     */
+    void getEvents(std::vector<Event*> &events);
+
     /**
      * Get the credits.
      *
@@ -23,6 +23,7 @@
 #include "timer.h"
 
 #include "sidplayfp/sidendian.h"
+#include "sidplayfp/sidstate.h"
 
 void Timer::setControlRegister(uint8_t cr)
 {
@@ -149,3 +150,13 @@ void Timer::latchHi(uint8_t data)
     if ((state & CIAT_LOAD) || !(state & CIAT_CR_START)) // Reload timer if stopped
         timer = latch;
 }
+
+void Timer::serialize(sidstate &s)
+{
+    s.io(ciaEventPauseTime);
+    s.io(timer);
+    s.io(latch);
+    s.io(pbToggle);
+    s.io(lastControlValue);
+    s.io(state);
+}
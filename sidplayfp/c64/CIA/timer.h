@@ -25,10 +25,13 @@
 
 #include <stdint.h>
 
+#include <vector>
+
 #include "sidplayfp/event.h"
 #include "sidplayfp/EventScheduler.h"
 
 class MOS6526;
+class sidstate;
 
 /**
  * This is the base class for the MOS6526 timers.
@@ -169,6 +172,20 @@ public:
      */
     void reset();
 
+    /**
+     * Save or restore the timer state.
+     */
+    void serialize(sidstate &s);
+
+    /**
+     * Get the events of the timer, for saving the event queue.
+     */
+    void getEvents(std::vector<Event*> &events)
+    {
+        events.push_back(this);
+        events.push_back(&m_cycleSkippingEvent);
+    }
+
     /**
      * Set low byte of Timer start value (Latch).
      *
@@ -27,6 +27,7 @@
 #include <memory.h>
 
 #include "mos6526.h"
+#include "../../sidstate.h"
 
 void Tod::reset()
 {
@@ -43,6 +44,16 @@ void Tod::reset()
     event_context.schedule(*this, 0, EVENT_CLOCK_PHI1);
 }
 
+void Tod::serialize(sidstate &s)
+{
+    s.io(cycles);
+    s.io(clock, 4);
+    s.io(latch, 4);
+    s.io(alarm, 4);
+    s.io(isLatched);
+    s.io(isStopped);
+}
+
 uint8_t Tod::read(uint_least8_t reg)
 {
     // TOD clock is latched by reading Hours, and released
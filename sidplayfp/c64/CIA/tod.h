@@ -26,9 +26,12 @@
 
 #include <stdint.h>
 
+#include <vector>
+
 #include "sidplayfp/event.h"
 
 class MOS6526;
+class sidstate;
 
 /**
  * TOD implementation taken from Vice.
@@ -83,6 +86,16 @@ public:
      */
     void reset();
 
+    /**
+     * Save or restore the TOD state.
+     */
+    void serialize(sidstate &s);
+
+    /**
+     * Get the events of the TOD, for saving the event queue.
+     */
+    void getEvents(std::vector<Event*> &events) { events.push_back(this); }
+
     /**
      * Read TOD register.
      *
@@ -24,9 +24,14 @@
 
 #include "sidplayfp/event.h"
 #include "../../sidendian.h"
+#include "../../sidstate.h"
 
 #include "opcodes.h"
 
+#ifdef MOS6510_SWITCH_DISPATCH
+#  include <cstdlib>
+#endif
+
 #ifdef DEBUG
 #  include <cstdio>
 #  include "mos6510debug.h"
@@ -78,12 +83,109 @@ const uint8_t magic =
 ;
 //-------------------------------------------------------------------------//
 
-/** When AEC signal is high, no stealing is possible */
-void MOS6510::eventWithoutSteals()
+#ifdef MOS6510_SWITCH_DISPATCH
+/**
+* All the cycle handlers that can appear in the instruction table.
+* Used to build the switch based dispatcher.
+*/
+#define MOS6510_CYCLES(X) \
+    X(throwAwayFetch) X(FetchDataByte) X(FetchLowAddr) X(FetchLowAddrX) \
+    X(WasteCycle) X(FetchLowAddrY) X(FetchHighAddr) X(FetchHighAddrX2) \
+    X(throwAwayRead) X(FetchHighAddrX) X(FetchHighAddrY2) \
+    X(FetchHighAddrY) X(FetchLowPointer) X(FetchHighPointer) \
+    X(FetchLowEffAddr) X(FetchHighEffAddr) X(FetchLowPointerX) \
+    X(FetchHighEffAddrY2) X(FetchHighEffAddrY) X(FetchEffAddrDataByte) \
+    X(adc_instr) X(anc_instr) X(and_instr) X(ane_instr) X(arr_instr) \
+    X(asla_instr) X(asl_instr) X(PutEffAddrDataByte) X(alr_instr) \
+    X(bcc_instr) X(bcs_instr) X(beq_instr) X(bit_instr) X(bmi_instr) \
+    X(bne_instr) X(bpl_instr) X(PushHighPC) X(brkPushLowPC) X(brk_instr) \
+    X(IRQLoRequest) X(IRQHiRequest) X(fetchNextOpcode) X(bvc_instr) \
+    X(bvs_instr) X(clc_instr) X(cld_instr) X(cli_instr) X(clv_instr) \
+    X(cmp_instr) X(cpx_instr) X(cpy_instr) X(dcm_instr) X(dec_instr) \
+    X(dex_instr) X(dey_instr) X(eor_instr) X(inc_instr) X(inx_instr) \
+    X(iny_instr) X(ins_instr) X(PushLowPC) X(jmp_instr) X(las_instr) \
+    X(lax_instr) X(lda_instr) X(ldx_instr) X(ldy_instr) X(lsra_instr) \
+    X(lsr_instr) X(oal_instr) X(ora_instr) X(pha_instr) X(PushSR) \
+    X(pla_instr) X(PopSR) X(plp_instr) X(rla_instr) X(rola_instr) \
+    X(rol_instr) X(rora_instr) X(ror_instr) X(rra_instr) X(PopLowPC) \
+    X(PopHighPC) X(rti_instr) X(rts_instr) X(axs_instr) X(sbc_instr) \
+    X(sbx_instr) X(sec_instr) X(sed_instr) X(sei_instr) X(axa_instr) \
+    X(shs_instr) X(xas_instr) X(say_instr) X(aso_instr) X(lse_instr) \
+    X(sta_instr) X(stx_instr) X(sty_instr) X(tax_instr) X(tay_instr) \
+    X(tsx_instr) X(txa_instr) X(txs_instr) X(tya_instr) X(illegal_instr) \
+    X(interruptsAndNextOpcode)
+
+#define MOS6510_CYCLE_ID(func) CYCLE_##func,
+
+enum
+{
+    MOS6510_CYCLES(MOS6510_CYCLE_ID)
+    CYCLE_NONE
+};
+
+/**
+* Execute a cycle through a switch over the handler index.
+* The handlers get inlined in a single function, avoiding
+* the indirect call through a member function pointer.
+* Only the unused table entries have no handler,
+* the constructor makes sure of it.
+*/
+void MOS6510::execute(const ProcessorCycle &instr)
+{
+#define MOS6510_CYCLE_CASE(func) case CYCLE_##func: func(); break;
+
+    switch (instr.id)
+    {
+    MOS6510_CYCLES(MOS6510_CYCLE_CASE)
+    }
+}
+
+/**
+* Find the handler index of a cycle function.
+*/
+uint8_t MOS6510::cycleId(void (MOS6510::*func)())
+{
+    typedef void (MOS6510::*cycle_t)();
+
+#define MOS6510_CYCLE_PTR(func) &MOS6510::func,
+
+    static const cycle_t cycles[] =
+    {
+        MOS6510_CYCLES(MOS6510_CYCLE_PTR)
+    };
+
+    for (uint8_t i = 0; i < CYCLE_NONE; i++)
+    {
+        if (cycles[i] == func)
+            return i;
+    }
+    return CYCLE_NONE;
+}
+#else
+void MOS6510::execute(const ProcessorCycle &instr)
 {
-    const ProcessorCycle &instr = instrTable[cycleCount++];
     (this->*(instr.func)) ();
-    eventContext.schedule(m_nosteal, 1);
+}
+#endif // MOS6510_SWITCH_DISPATCH
+
+/**
+* When AEC signal is high, no stealing is possible.
+* In batch mode keep running cycles inline for as long as
+* no other event is due before the next CPU cycle.
+*/
+void MOS6510::eventWithoutSteals()
+{
+    if (!batchMode)
+    {
+        execute(instrTable[cycleCount++]);
+        eventContext.schedule(m_nosteal, 1);
+        return;
+    }
+
+    do
+    {
+        execute(instrTable[cycleCount++]);
+    } while (eventContext.advance(m_nosteal, 1));
 }
 
 /** When AEC signal is low, steals permitted */
@@ -91,8 +193,7 @@ void MOS6510::eventWithSteals()
 {
     if (instrTable[cycleCount].nosteal)
     {
-        const ProcessorCycle &instr = instrTable[cycleCount++];
-        (this->*(instr.func)) ();
+        execute(instrTable[cycleCount++]);
         eventContext.schedule(m_steal, 1);
     }
     else
@@ -1478,7 +1579,8 @@ MOS6510::MOS6510 (EventContext *context) :
     m_fdbg(stdout),
 #endif
     m_nosteal("CPU-nosteal", *this, &MOS6510::eventWithoutSteals),
-    m_steal("CPU-steal", *this, &MOS6510::eventWithSteals)
+    m_steal("CPU-steal", *this, &MOS6510::eventWithSteals),
+    batchMode(true)
 {
     //----------------------------------------------------------------------
     // Build up the processor instruction table
@@ -2119,6 +2221,17 @@ MOS6510::MOS6510 (EventContext *context) :
 #endif
     }
 
+#ifdef MOS6510_SWITCH_DISPATCH
+    for (int i = 0; i < (0x101 << 3); i++)
+    {
+        instrTable[i].id = cycleId(instrTable[i].func);
+
+        // A handler missing from MOS6510_CYCLES would never run
+        if (instrTable[i].func && instrTable[i].id == CYCLE_NONE)
+            abort();
+    }
+#endif
+
     // Intialise Processor Registers
     Register_Accumulator   = 0;
     Register_X             = 0;
@@ -2179,6 +2292,38 @@ void MOS6510::reset()
     Register_ProgramCounter = Cycle_EffectiveAddress;
 }
 
+void MOS6510::serialize(sidstate &s)
+{
+    s.io(cycleCount);
+    s.io(interruptCycle);
+    s.io(irqAssertedOnPin);
+    s.io(nmiFlag);
+    s.io(rstFlag);
+    s.io(rdy);
+
+    s.io(flags.C);
+    s.io(flags.Z);
+    s.io(flags.I);
+    s.io(flags.D);
+    s.io(flags.B);
+    s.io(flags.V);
+    s.io(flags.N);
+
+    s.io(Register_ProgramCounter);
+    s.io(Cycle_EffectiveAddress);
+    s.io(Cycle_HighByteWrongEffectiveAddress);
+    s.io(Cycle_Pointer);
+
+    s.io(Cycle_Data);
+    s.io(Register_StackPointer);
+    s.io(Register_Accumulator);
+    s.io(Register_X);
+    s.io(Register_Y);
+
+    if (cycleCount < 0 || cycleCount >= (0x101 << 3))
+        s.fail();
+}
+
 //-------------------------------------------------------------------------//
 // Module Credits                                                          //
 const char *MOS6510::credit =
@@ -26,6 +26,8 @@
 #include <stdint.h>
 #include <stdio.h>
 
+#include <vector>
+
 #include "flags.h"
 #include "..\..\EventScheduler.h"
 
@@ -34,6 +36,7 @@
 #endif
 
 class EventContext;
+class sidstate;
 
 /**
  * Cycle-exact 6502/6510 emulation core.
@@ -71,6 +74,10 @@ private:
     {
         void (MOS6510::*func)();
         bool nosteal;
+#ifdef MOS6510_SWITCH_DISPATCH
+        /// Index of func for the switch dispatcher
+        uint8_t id;
+#endif
         ProcessorCycle () :
             func(0),
             nosteal(false) {}
@@ -133,9 +140,19 @@ private:
     /// Represents an instruction subcycle that reads
     EventCallback<MOS6510> m_steal;
 
+    /// Run CPU cycles inline until another event is due
+    bool batchMode;
+
     void eventWithoutSteals();
     void eventWithSteals();
 
+    /// Execute a single instruction subcycle
+    inline void execute(const ProcessorCycle &instr);
+
+#ifdef MOS6510_SWITCH_DISPATCH
+    static uint8_t cycleId(void (MOS6510::*func)());
+#endif
+
     void Initialise();
 
     // Declare Interrupt Routines
@@ -294,6 +311,31 @@ public:
     void debug(bool enable, FILE *out);
     void setRDY(bool newRDY);
 
+    /**
+     * Save or restore the registers and the state
+     * of the instruction being executed.
+     */
+    void serialize(sidstate &s);
+
+    /**
+     * Get the events of the CPU, for saving the event queue.
+     */
+    void getEvents(std::vector<Event*> &events)
+    {
+        events.push_back(&m_nosteal);
+        events.push_back(&m_steal);
+    }
+
+    /**
+     * Enable or disable batch mode.
+     * When enabled the CPU runs consecutive cycles without going
+     * through the event queue until another event is due.
+     * Emulation results are the same in both modes.
+     *
+     * @param enable true to run cycles in batches
+     */
+    void setBatchMode(bool enable) { batchMode = enable; }
+
     // Non-standard functions
     void triggerRST();
     void triggerNMI();
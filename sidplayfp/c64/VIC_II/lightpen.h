@@ -24,6 +24,8 @@
 #ifndef LIGHTPEN_H
 #define LIGHTPEN_H
 
+#include "../../sidstate.h"
+
 /**
  * Lightpen
  */
@@ -68,6 +70,16 @@ public:
         isTriggered = false;
     }
 
+    /**
+     * Save or restore the lightpen state.
+     */
+    void serialize(sidstate &s)
+    {
+        s.io(lpx);
+        s.io(lpy);
+        s.io(isTriggered);
+    }
+
     /**
      * Return the low byte of x coordinate.
      */
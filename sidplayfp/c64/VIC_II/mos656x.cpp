@@ -88,6 +88,29 @@ void MOS656X::reset()
     event_context.schedule(*this, 0, EVENT_CLOCK_PHI1);
 }
 
+void MOS656X::serialize(sidstate &s)
+{
+    // The state only makes sense for the same chip model
+    s.tag(maxRasters);
+    s.tag(cyclesPerLine);
+
+    s.io(rasterClk);
+    s.io(lineCycle);
+    s.io(rasterY);
+    s.io(yscroll);
+    s.io(areBadLinesEnabled);
+    s.io(isBadLine);
+    s.io(rasterYIRQCondition);
+    s.io(vblanking);
+    s.io(lpAsserted);
+    s.io(irqFlags);
+    s.io(irqMask);
+    s.io(regs, 0x40);
+
+    lp.serialize(s);
+    sprites.serialize(s);
+}
+
 void MOS656X::chip(model_t model)
 {
     maxRasters    = modelData[model].rasterLines;
@@ -26,6 +26,8 @@
 
 #include <stdint.h>
 
+#include <vector>
+
 #include "lightpen.h"
 #include "sprites.h"
 #include "sidplayfp/event.h"
@@ -327,6 +329,21 @@ public:
     // Component Standard Calls
     void reset();
 
+    /**
+     * Save or restore the raster state and the registers.
+     */
+    void serialize(sidstate &s);
+
+    /**
+     * Get the events of the VIC, for saving the event queue.
+     */
+    void getEvents(std::vector<Event*> &events)
+    {
+        events.push_back(this);
+        events.push_back(&badLineStateChangeEvent);
+        events.push_back(&rasterYIRQEdgeDetectorEvent);
+    }
+
     static const char *credits() { return credit; }
 };
 
@@ -29,6 +29,8 @@
 #include <cstring>
 #include <memory.h>
 
+#include "../../sidstate.h"
+
 #define SPRITES 8
 
 class Sprites
@@ -55,6 +57,17 @@ public:
         memset(mc, 0, sizeof(mc));
     }
 
+    /**
+     * Save or restore the sprite counters.
+     */
+    void serialize(sidstate &s)
+    {
+        s.io(exp_flop);
+        s.io(dma);
+        s.io(mc_base, SPRITES);
+        s.io(mc, SPRITES);
+    }
+
     /**
      * Update mc values in one pass
      * after the dma has been processed
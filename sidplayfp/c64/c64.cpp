@@ -25,6 +25,7 @@
 #include <algorithm>
 
 #include "VIC_II/mos656x.h"
+#include "../sidstate.h"
 
 typedef struct
 {
@@ -117,6 +118,35 @@ void c64::reset()
     oldBAState = true;
 }
 
+void c64::getEvents(std::vector<Event*> &events)
+{
+    cpu.getEvents(events);
+    cia1.getEvents(events);
+    cia2.getEvents(events);
+    vic.getEvents(events);
+}
+
+bool c64::serialize(sidstate &s)
+{
+    std::vector<Event*> events;
+    getEvents(events);
+
+    if (!m_scheduler.serialize(s, events))
+        return false;
+
+    s.io(irqCount);
+    s.io(oldBAState);
+
+    cpu.serialize(s);
+    cia1.serialize(s);
+    cia2.serialize(s);
+    vic.serialize(s);
+    colorRAMBank.serialize(s);
+    mmu.serialize(s);
+
+    return !s.failed();
+}
+
 void c64::setModel(model_t model)
 {
     m_cpuFreq = getCpuFreq(model);
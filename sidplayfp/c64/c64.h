@@ -27,6 +27,7 @@
 #include <cstdio>
 
 #include <map>
+#include <vector>
 
 #include "Banks/IOBank.h"
 #include "Banks/ColorRAMBank.h"
@@ -48,6 +49,7 @@
 
 class c64sid;
 class sidmemory;
+class sidstate;
 
 
 #ifdef PC64_TESTSUITE
@@ -226,6 +228,30 @@ public:
     void reset();
     void resetCpu() { cpu.reset(); }
 
+    /**
+     * Save or restore the state of the machine, including
+     * the pending events but not the SIDs.
+     * Restoring needs the same C64 model,
+     * it must be done outside of the event loop.
+     *
+     * @param s the state stream
+     * @return false if the state can't be saved or restored
+     */
+    bool serialize(sidstate &s);
+
+    /**
+     * Get the events of the machine, for saving the event queue
+     * and for the statistics.
+     */
+    void getEvents(std::vector<Event*> &events);
+
+    /**
+     * Let the CPU run cycles in batches between other events.
+     *
+     * @param enable true to enable batch mode
+     */
+    void setCpuBatchMode(bool enable) { cpu.setBatchMode(enable); }
+
     /**
      * Set the c64 model.
      */
@@ -30,6 +30,7 @@
 #include "c64env.h"
 #include "../sidendian.h"
 #include "CIA/mos6526.h"
+#include "../sidstate.h"
 
 /**
  * CIA 1
@@ -83,6 +84,15 @@ public:
         MOS6526::reset ();
     }
 
+    /**
+     * Save or restore the CIA state.
+     */
+    void serialize(sidstate &s)
+    {
+        MOS6526::serialize(s);
+        s.io(last_ta);
+    }
+
     uint_least16_t getTimerA() const { return last_ta; }
 };
 
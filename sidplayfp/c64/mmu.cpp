@@ -22,6 +22,8 @@
 
 #include "mmu.h"
 
+#include "sidplayfp/sidstate.h"
+
 class Bank;
 
 MMU::MMU(EventContext *context, Bank* ioBank) :
@@ -77,3 +79,18 @@ void MMU::reset()
 
     updateMappingPHI2();
 }
+
+void MMU::serialize(sidstate &s)
+{
+    s.io(loram);
+    s.io(hiram);
+    s.io(charen);
+
+    ramBank.serialize(s);
+    zeroRAMBank.serialize(s);
+    kernalRomBank.serialize(s);
+    basicRomBank.serialize(s);
+
+    if (!s.saving())
+        updateMappingPHI2();
+}
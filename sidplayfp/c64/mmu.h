@@ -39,6 +39,8 @@
 /**
  * The C64 MMU chip.
  */
+class sidstate;
+
 class MMU : public PLA, public sidmemory
 {
 private:
@@ -83,6 +85,12 @@ public:
 
     void reset();
 
+    /**
+     * Save or restore the RAM, the processor port and the memory mapping,
+     * along with the ROM locations patched by the driver.
+     */
+    void serialize(sidstate &s);
+
     void setRoms(const uint8_t* kernal, const uint8_t* basic, const uint8_t* character)
     {
         kernalRomBank.set(kernal);
@@ -40,6 +40,7 @@ const char TXT_NTSC_UNKNOWN[]   = "UNKNOWN (NTSC)";
 // Error Strings
 const char ERR_UNSUPPORTED_FREQ[]     = "SIDPLAYER ERROR: Unsupported sampling frequency.";
 const char ERR_UNSUPPORTED_SID_ADDR[] = "SIDPLAYER ERROR: Unsupported SID address.";
+const char ERR_UNSUPPORTED_STEMS[]    = "SIDPLAYER ERROR: Voice stems not supported by the SID emulation.";
 
 bool Player::config(const SidConfig &cfg)
 {
@@ -73,7 +74,7 @@ bool Player::config(const SidConfig &cfg)
 
             m_c64.setModel(model);
 
-            sidParams(m_c64.getMainCpuSpeed(), cfg.frequency, cfg.samplingMethod, cfg.fastSampling);
+            sidParams(m_c64.getMainCpuSpeed(), cfg.frequency, cfg.samplingMethod, cfg.fastSampling, cfg.stemMode);
 
             // Configure, setup and install C64 environment/events
             initialise();
@@ -263,7 +264,8 @@ void Player::sidCreate(sidbuilder *builder, SidConfig::sid_model_t defaultModel,
 }
 
 void Player::sidParams(double cpuFreq, int frequency,
-                        SidConfig::sampling_method_t sampling, bool fastSampling)
+                        SidConfig::sampling_method_t sampling, bool fastSampling,
+                        SidConfig::stem_mode_t stemMode)
 {
     for (unsigned int i = 0; ; i++)
     {
@@ -272,6 +274,9 @@ void Player::sidParams(double cpuFreq, int frequency,
             break;
 
         s->sampling((float)cpuFreq, frequency, sampling, fastSampling);
+
+        if (!s->stems(stemMode))
+            throw configError(ERR_UNSUPPORTED_STEMS);
     }
 }
 
@@ -67,6 +67,11 @@ private:
      */
     Event *next;
 
+    /**
+     * Times this event fired, only counted in profiling builds.
+     */
+    uint_least64_t m_fired;
+
 public:
     /**
      * Events are used for delayed execution. Name is
@@ -75,7 +80,19 @@ public:
      * @param name Descriptive string of the event.
      */
     Event(const char * const name) :
-        m_name(name) {}
+        m_name(name),
+        m_fired(0) {}
+
+    /**
+     * Get the description of the event.
+     */
+    const char *name() const { return m_name; }
+
+    /**
+     * Get the number of times the event fired
+     * since the last reset of the statistics.
+     */
+    uint_least64_t fired() const { return m_fired; }
 
     /**
      * Event code to be executed. Events are allowed to safely
@@ -142,6 +159,20 @@ public:
      */
     virtual bool isPending(Event &event) const = 0;
 
+    /**
+     * Advance time in place of rescheduling the running event,
+     * if no other event is due until then.
+     * Lets the running event continue inline instead of
+     * going through the queue.
+     * If other events are due first the event is scheduled as usual.
+     *
+     * @param event the running event
+     * @param cycles how many cycles from now it would fire
+     * @return true when time was advanced and the event must run again now,
+     *         false when the event has been scheduled
+     */
+    virtual bool advance(Event &event, event_clock_t cycles) = 0;
+
     /**
      * Get time with respect to a specific clock phase.
      *
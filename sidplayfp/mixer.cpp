@@ -25,6 +25,15 @@
 #include <algorithm>
 
 #include "sidemu.h"
+#include "sidstate.h"
+#include "sidprofile.h"
+
+/**
+ * When the SIDs have written past this point the samples
+ * not yet mixed are moved back to the start of the buffers.
+ * Leaves room for chunks of up to half the buffer.
+ */
+const int COMPACT_POS = sidemu::OUTPUTBUFFERSIZE / 2;
 
 void clockChip(sidemu *s) { s->clock(); }
 
@@ -42,13 +51,9 @@ class bufferMove
 {
 public:
     bufferMove(int p, int s) : pos(p), samples(s) {}
-    void operator()(short *dest)
+    void operator()(int *dest)
     {
-        const short* src = dest + pos;
-        for (int j = 0; j < samples; j++)
-        {
-            dest[j] = src[j];
-        }
+        std::copy(dest + pos, dest + pos + samples, dest);
     }
 
 private:
@@ -56,91 +61,520 @@ private:
     int samples;
 };
 
+class silentMode
+{
+public:
+    silentMode(bool e) : enable(e) {}
+    void operator()(sidemu *s) { s->silent(enable); }
+
+private:
+    bool enable;
+};
+
+static inline short clip(int_least32_t value)
+{
+    if (value < -32768) value = -32768;
+    if (value > 32767) value = 32767;
+    return static_cast<short>(value);
+}
+
+/**
+ * Scale to 32 bit full scale.
+ * A float only holds 24 bits, so the truncation
+ * of the fraction is well below the resolution.
+ */
+static inline int_least32_t toInt32(float value)
+{
+    const float scaled = value * 2147483648.f;
+    if (scaled >= 2147483648.f) return 2147483647;
+    if (scaled <= -2147483648.f) return -2147483647 - 1;
+    return static_cast<int_least32_t>(scaled);
+}
+
 void Mixer::clockChips()
 {
-    std::for_each(m_chips.begin(), m_chips.end(), clockChip);
+    if (!sidprofile::enabled)
+    {
+        std::for_each(m_chips.begin(), m_chips.end(), clockChip);
+        return;
+    }
+
+    for (size_t k = 0; k < m_chips.size(); k++)
+    {
+        const uint_least64_t start = sidprofile::now();
+        m_chips[k]->clock();
+        m_stats[k].time += sidprofile::now() - start;
+
+        // Count the cycles since the last look, these include
+        // the ones clocked on register access.
+        // The clock goes back on reset and restore.
+        sidstats_t &stats = m_stats[k];
+        const event_clock_t clk = m_chips[k]->accessClk();
+        if (clk >= stats.lastClk)
+            stats.cycles += clk - stats.lastClk;
+        stats.lastClk = clk;
+    }
+}
+
+void Mixer::resetStats()
+{
+    for (size_t k = 0; k < m_stats.size(); k++)
+    {
+        m_stats[k] = sidstats_t();
+        m_stats[k].lastClk = m_chips[k]->accessClk();
+    }
+    m_frames = 0;
+    m_mixTime = 0;
+}
+
+void Mixer::silent(bool enable)
+{
+    std::for_each(m_chips.begin(), m_chips.end(), silentMode(enable));
 }
 
 void Mixer::resetBufs()
 {
+    m_readPos = 0;
+    m_lastWritePos = 0;
     std::for_each(m_chips.begin(), m_chips.end(), bufferPos(0));
 }
 
-void Mixer::doMix()
+bool Mixer::serialize(sidstate &s)
 {
-    short *buf = m_sampleBuffer + m_sampleIndex;
+    s.tag((uint32_t)m_chips.size());
+    s.io(m_rand);
+    s.io(oldRandomValue);
+    s.io(m_readPos);
 
-    /* extract buffer info now that the SID is updated.
-        * clock() may update bufferpos.
-        * NB: if chip2 exists, its bufferpos is identical to chip1's. */
-    const int sampleCount = m_chips[0]->bufferpos();
+    for (std::vector<sidemu*>::const_iterator it = m_chips.begin(); it != m_chips.end(); ++it)
+    {
+        if (!(*it)->serialize(s))
+            return false;
+    }
+
+    if (!m_chips.empty() && (m_readPos < 0 || m_readPos > m_chips[0]->bufferpos()))
+        s.fail();
+
+    if (!m_chips.empty())
+        m_lastWritePos = m_chips[0]->bufferpos();
+
+    return !s.failed();
+}
+
+void Mixer::mixBlock(int frames, unsigned int channels)
+{
+    // Work on local copies as the compiler can't tell
+    // that the sample buffers don't alias the members
+    const int ff = m_fastForwardFactor;
 
-    int i = 0;
-    while (i < sampleCount)
+    /* Triangular dither, shared by all the SIDs. */
     {
-        /* Handle whatever output the sid has generated so far */
-        if (m_sampleIndex >= m_sampleCount)
+        sidrandom rand = m_rand;
+        int prevValue = oldRandomValue;
+
+        for (int f = 0; f < frames; f++)
+        {
+            const int value = (rand.next() >> 16) & (VOLUME_MAX-1);
+            m_dither[f] = value - prevValue;
+            prevValue = value;
+        }
+
+        m_rand = rand;
+        oldRandomValue = prevValue;
+    }
+
+    /* Scale the samples of each SID, clipped to 16 bits.
+     * During fast forward a crude boxcar low-pass filter
+     * reduces aliasing. */
+    for (size_t k = 0; k < m_buffers.size(); k++)
+    {
+        const int *buffer = m_buffers[k] + m_readPos;
+        const int_least32_t *dither = m_dither;
+        int_least32_t *samples = &m_samples[k * BLOCK_SIZE];
+        const int_least32_t gain = m_gain[k];
+
+        if (ff == 1)
+        {
+            for (int f = 0; f < frames; f++)
+            {
+                samples[f] = (clip(buffer[f]) * gain + dither[f]) / VOLUME_MAX;
+            }
+        }
+        else
+        {
+            for (int f = 0; f < frames; f++)
+            {
+                int_least32_t sample = 0;
+                for (int j = 0; j < ff; j++)
+                {
+                    sample += clip(buffer[j]);
+                }
+                buffer += ff;
+
+                samples[f] = (sample * gain + dither[f]) / VOLUME_MAX / ff;
+            }
+        }
+    }
+
+    /* Mix the SIDs into each channel. */
+    for (unsigned int c = 0; c < channels; c++)
+    {
+        const std::vector<int_least32_t> &pan = (c == 0) ? m_panLeft : m_panRight;
+        short *buf = m_sampleBuffer + m_sampleIndex + c;
+
+        // Find the SIDs contributing to this channel
+        const int_least32_t *single = 0;
+        int contributors = 0;
+        for (size_t k = 0; k < m_buffers.size(); k++)
+        {
+            if (pan[k] != 0)
+            {
+                single = &m_samples[k * BLOCK_SIZE];
+                contributors++;
+            }
+        }
+
+        // A single SID at full share goes through as it is
+        if (contributors == 1)
+        {
+            for (size_t k = 0; k < m_buffers.size(); k++)
+            {
+                if (pan[k] == VOLUME_MAX)
+                {
+                    for (int f = 0; f < frames; f++)
+                    {
+                        buf[f * channels] = clip(single[f]);
+                    }
+                    contributors = 0;
+                }
+            }
+
+            if (contributors == 0)
+                continue;
+        }
+
+        int_least32_t *mix = m_mix;
+        std::fill(mix, mix + frames, 0);
+
+        for (size_t k = 0; k < m_buffers.size(); k++)
+        {
+            const int_least32_t share = pan[k];
+            if (share == 0)
+                continue;
+
+            const int_least32_t *samples = &m_samples[k * BLOCK_SIZE];
+            for (int f = 0; f < frames; f++)
+            {
+                mix[f] += samples[f] * share;
+            }
+        }
+
+        for (int f = 0; f < frames; f++)
+        {
+            buf[f * channels] = clip(mix[f] / VOLUME_MAX);
+        }
+    }
+
+    if (m_stemSampleBuffers != 0)
+        mixStems(frames, channels);
+
+    m_sampleIndex += frames * channels;
+    m_readPos += frames * ff;
+}
+
+void Mixer::mixBlockWide(int frames, unsigned int channels)
+{
+    const int ff = m_fastForwardFactor;
+
+    /* Scale the samples of each SID to the nominal -1 to 1 range,
+     * averaging them during fast forward. The samples are not clipped. */
+    const float scale = 1.f / (32768.f * VOLUME_MAX * ff);
+
+    for (size_t k = 0; k < m_buffers.size(); k++)
+    {
+        const int *buffer = m_buffers[k] + m_readPos;
+        float *samples = &m_wideSamples[k * BLOCK_SIZE];
+        const float gain = m_gain[k] * scale;
+
+        if (ff == 1)
         {
-            break;
+            for (int f = 0; f < frames; f++)
+            {
+                samples[f] = buffer[f] * gain;
+            }
         }
-        /* Are there enough samples to generate the next one? */
-        if (i + m_fastForwardFactor >= sampleCount)
+        else
         {
-            break;
+            for (int f = 0; f < frames; f++)
+            {
+                int_least32_t sample = 0;
+                for (int j = 0; j < ff; j++)
+                {
+                    sample += buffer[j];
+                }
+                buffer += ff;
+
+                samples[f] = sample * gain;
+            }
         }
+    }
 
-        const int dither = triangularDithering();
+    /* Mix the SIDs into each channel. */
+    for (unsigned int c = 0; c < channels; c++)
+    {
+        const std::vector<int_least32_t> &pan = (c == 0) ? m_panLeft : m_panRight;
+
+        float *mix = m_wideMix;
+        std::fill(mix, mix + frames, 0.f);
 
-        /* This is a crude boxcar low-pass filter to
-            * reduce aliasing during fast forward. */
         for (size_t k = 0; k < m_buffers.size(); k++)
         {
-            int_least32_t sample = 0;
-            const short *buffer = m_buffers[k] + i;
-            for (int j = 0; j < m_fastForwardFactor; j++)
+            if (pan[k] == 0)
+                continue;
+
+            const float share = pan[k] * (1.f / VOLUME_MAX);
+            const float *samples = &m_wideSamples[k * BLOCK_SIZE];
+            for (int f = 0; f < frames; f++)
             {
-                sample += buffer[j];
+                mix[f] += samples[f] * share;
             }
+        }
 
-            m_iSamples[k] = (sample * m_volume[k] + dither) / VOLUME_MAX;
-            m_iSamples[k] /= m_fastForwardFactor;
+        if (m_format == SAMPLE_FLOAT)
+        {
+            float *buf = m_floatBuffer + m_sampleIndex + c;
+            for (int f = 0; f < frames; f++)
+            {
+                buf[f * channels] = mix[f];
+            }
         }
+        else
+        {
+            int_least32_t *buf = m_intBuffer + m_sampleIndex + c;
+            for (int f = 0; f < frames; f++)
+            {
+                buf[f * channels] = toInt32(mix[f]);
+            }
+        }
+    }
+
+    if (m_stemIntBuffers != 0 || m_stemFloatBuffers != 0)
+        mixStems(frames, channels);
 
-        /* increment i to mark we ate some samples, finish the boxcar thing. */
-        i += m_fastForwardFactor;
+    m_sampleIndex += frames * channels;
+    m_readPos += frames * ff;
+}
+
+void Mixer::mixStems(int frames, unsigned int channels)
+{
+    const int ff = m_fastForwardFactor;
+    const uint_least32_t frame = m_sampleIndex / channels;
+    const bool narrow = m_format == SAMPLE_S16;
 
-        const unsigned int channels = m_stereo ? 2 : 1;
-        for (unsigned int k = 0; k < channels; k++)
+    /* Same scaling as the SIDs, without the panning. */
+    for (size_t k = 0; k < m_chips.size(); k++)
+    {
+        const int_least32_t gain = m_gain[k];
+        const float wideGain = gain * (1.f / (32768.f * VOLUME_MAX * ff));
+
+        for (unsigned int v = 0; v < 3; v++)
         {
-            *buf++ = (this->*(m_mix[k]))();
-            m_sampleIndex++;
+            const int *buffer = m_chips[k]->stemBuffer(v);
+            if (buffer == 0)
+                continue;
+
+            buffer += m_readPos;
+            const size_t stem = k * 3 + v;
+
+            // The channels are done, reuse the accumulator
+            int_least32_t *samples = m_mix;
+            for (int f = 0; f < frames; f++)
+            {
+                int_least32_t sample = 0;
+                for (int j = 0; j < ff; j++)
+                {
+                    // Like the mix, only the 16 bit output clips the voices
+                    sample += narrow ? clip(buffer[j]) : buffer[j];
+                }
+                buffer += ff;
+
+                samples[f] = sample;
+            }
+
+            if (m_format == SAMPLE_S16)
+            {
+                short *buf = m_stemSampleBuffers[stem] + frame;
+                for (int f = 0; f < frames; f++)
+                {
+                    buf[f] = clip((samples[f] * gain + m_dither[f]) / VOLUME_MAX / ff);
+                }
+            }
+            else if (m_format == SAMPLE_S32)
+            {
+                int_least32_t *buf = m_stemIntBuffers[stem] + frame;
+                for (int f = 0; f < frames; f++)
+                {
+                    buf[f] = toInt32(samples[f] * wideGain);
+                }
+            }
+            else
+            {
+                float *buf = m_stemFloatBuffers[stem] + frame;
+                for (int f = 0; f < frames; f++)
+                {
+                    buf[f] = samples[f] * wideGain;
+                }
+            }
         }
     }
+}
 
-    /* move the unhandled data to start of buffer, if any. */
-    const int samplesLeft = sampleCount - i;
-    std::for_each(m_buffers.begin(), m_buffers.end(), bufferMove(i, samplesLeft));
-    std::for_each(m_chips.begin(), m_chips.end(), bufferPos(samplesLeft - 1));
+void Mixer::doMix()
+{
+    /* extract buffer info now that the SID is updated.
+        * clock() may update bufferpos.
+        * NB: if chip2 exists, its bufferpos is identical to chip1's. */
+    const int sampleCount = m_chips[0]->bufferpos();
+
+    const unsigned int channels = m_stereo ? 2 : 1;
+
+    const uint_least64_t start = sidprofile::now();
+
+    /* Frames that can be generated from the samples available,
+     * the last sample is always left for the next round. */
+    int frames = (sampleCount - m_readPos - 1) / m_fastForwardFactor;
+    if (frames < 0)
+        frames = 0;
+
+    /* and that fit in the output buffer. */
+    const int room = (m_sampleCount - m_sampleIndex) / channels;
+    if (frames > room)
+        frames = room;
+
+    if (sidprofile::enabled)
+    {
+        m_frames += frames;
+        for (size_t k = 0; k < m_stats.size(); k++)
+            m_stats[k].samples += sampleCount - m_lastWritePos;
+    }
+
+    while (frames > 0)
+    {
+        const int n = (frames < BLOCK_SIZE) ? frames : BLOCK_SIZE;
+        if (m_format == SAMPLE_S16)
+            mixBlock(n, channels);
+        else
+            mixBlockWide(n, channels);
+        frames -= n;
+    }
+
+    /* The SIDs go on writing over the last sample, the data not yet
+     * mixed is moved to the start of the buffers only when they are
+     * running out of space. */
+    int writePos = std::max(sampleCount - 1, m_readPos);
+
+    if (writePos > COMPACT_POS)
+    {
+        std::for_each(m_buffers.begin(), m_buffers.end(), bufferMove(m_readPos, writePos - m_readPos));
+
+        for (size_t k = 0; k < m_chips.size(); k++)
+        {
+            for (unsigned int v = 0; v < 3; v++)
+            {
+                int *stem = m_chips[k]->stemBuffer(v);
+                if (stem != 0)
+                    bufferMove(m_readPos, writePos - m_readPos)(stem);
+            }
+        }
+        writePos -= m_readPos;
+        m_readPos = 0;
+    }
+
+    std::for_each(m_chips.begin(), m_chips.end(), bufferPos(writePos));
+    m_lastWritePos = writePos;
+
+    if (sidprofile::enabled)
+        m_mixTime += sidprofile::now() - start;
 }
 
-void Mixer::begin(short *buffer, uint_least32_t count)
+void Mixer::begin(short *buffer, uint_least32_t count, short **stems)
 {
     m_sampleIndex  = 0;
     m_sampleCount  = count;
+    m_format       = SAMPLE_S16;
     m_sampleBuffer = buffer;
+
+    m_stemSampleBuffers = stems;
+    m_stemIntBuffers    = 0;
+    m_stemFloatBuffers  = 0;
+}
+
+void Mixer::begin(int_least32_t *buffer, uint_least32_t count, int_least32_t **stems)
+{
+    m_sampleIndex = 0;
+    m_sampleCount = count;
+    m_format      = SAMPLE_S32;
+    m_intBuffer   = buffer;
+
+    m_stemSampleBuffers = 0;
+    m_stemIntBuffers    = stems;
+    m_stemFloatBuffers  = 0;
+}
+
+void Mixer::begin(float *buffer, uint_least32_t count, float **stems)
+{
+    m_sampleIndex = 0;
+    m_sampleCount = count;
+    m_format      = SAMPLE_FLOAT;
+    m_floatBuffer = buffer;
+
+    m_stemSampleBuffers = 0;
+    m_stemIntBuffers    = 0;
+    m_stemFloatBuffers  = stems;
 }
 
 void Mixer::updateParams()
 {
-    m_mix[0] = (!m_stereo && m_buffers.size() > 1) ? &Mixer::channel1MonoMix : &Mixer::channel1StereoMix;
-    if (m_stereo)
-        m_mix[1] = (m_buffers.size() > 1) ? &Mixer::channel2FromStereoMix : &Mixer::channel2FromMonoMix;
+    const size_t chips = m_chips.size();
+
+    for (size_t k = 0; k < chips; k++)
+    {
+        m_gain[k] = m_volume[(k == 0) ? 0 : 1];
+
+        if (m_panSet[k])
+            continue;
+
+        if (!m_stereo)
+        {
+            m_panLeft[k] = m_panRight[k] = VOLUME_MAX / chips;
+        }
+        else if (chips == 1)
+        {
+            m_panLeft[k] = m_panRight[k] = VOLUME_MAX;
+        }
+        else if (k < 2)
+        {
+            m_panLeft[k] = (k == 0) ? VOLUME_MAX : 0;
+            m_panRight[k] = (k == 1) ? VOLUME_MAX : 0;
+        }
+        else
+        {
+            m_panLeft[k] = m_panRight[k] = VOLUME_MAX / 2;
+        }
+    }
 }
 
 void Mixer::clearSids()
 {
     m_chips.clear();
     m_buffers.clear();
+    m_gain.clear();
+    m_panLeft.clear();
+    m_panRight.clear();
+    m_panSet.clear();
+    m_stats.clear();
+    m_readPos = 0;
+    m_lastWritePos = 0;
 }
 
 void Mixer::addSid(sidemu *chip)
@@ -150,21 +584,41 @@ void Mixer::addSid(sidemu *chip)
         m_chips.push_back(chip);
         m_buffers.push_back(chip->buffer());
 
-        m_iSamples.resize(m_buffers.size());
+        m_gain.push_back(0);
+        m_panLeft.push_back(0);
+        m_panRight.push_back(0);
+        m_panSet.push_back(false);
+
+        sidstats_t stats;
+        stats.lastClk = chip->accessClk();
+        m_stats.push_back(stats);
+
+        m_samples.resize(m_chips.size() * BLOCK_SIZE);
+        m_wideSamples.resize(m_chips.size() * BLOCK_SIZE);
 
-        if (m_mix.size() > 0)
-            updateParams();
+        updateParams();
     }
 }
 
+bool Mixer::setPan(unsigned int i, int_least32_t left, int_least32_t right)
+{
+    if (i >= m_chips.size()
+        || left < 0 || left > VOLUME_MAX
+        || right < 0 || right > VOLUME_MAX)
+        return false;
+
+    m_panLeft[i] = left;
+    m_panRight[i] = right;
+    m_panSet[i] = true;
+    return true;
+}
+
 void Mixer::setStereo(bool stereo)
 {
     if (m_stereo != stereo)
     {
         m_stereo = stereo;
 
-        m_mix.resize(m_stereo ? 2 : 1);
-
         updateParams();
     }
 }
@@ -180,7 +634,8 @@ bool Mixer::setFastForward(int ff)
 
 void Mixer::setVolume(int_least32_t left, int_least32_t right)
 {
-    m_volume.clear();
-    m_volume.push_back(left);
-    m_volume.push_back(right);
+    m_volume[0] = left;
+    m_volume[1] = right;
+
+    updateParams();
 }
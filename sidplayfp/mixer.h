@@ -25,78 +25,166 @@
 #define MIXER_H
 
 #include <stdint.h>
-#include <stdlib.h>
 
 #include <vector>
 
+#include "sidrandom.h"
+#include "event.h"
+
 class sidemu;
+class sidstate;
 
 /**
  * This class implements the mixer.
+ *
+ * The samples produced by the SIDs are mixed a block at a time.
+ * Each SID has a volume and a share of each output channel,
+ * so any number of SIDs can be panned across the stereo field.
+ * The voices of the SIDs rendering stems go to their own mono
+ * buffers at the volume of the SID.
  */
 class Mixer
 {
 public:
-    /// Maximum number of supported SIDs (mono and stereo)
+    /**
+     * Maximum number of SIDs set up by the engine (mono and stereo),
+     * the mixer itself takes any number.
+     */
     static const unsigned int MAX_SIDS = 2;
 
-private:
-    typedef short (Mixer::*mixer_func_t)() const;
-
-public:
     /**
      * Maximum allowed volume, must be a power of 2.
      */
     static const int_least32_t VOLUME_MAX = 1024;
 
+    /**
+     * Statistics of a SID, see SidStats.
+     */
+    struct sidstats_t
+    {
+        uint_least64_t cycles;
+        uint_least64_t samples;
+        uint_least64_t time;
+        event_clock_t lastClk;
+
+        sidstats_t() : cycles(0), samples(0), time(0), lastClk(0) {}
+    };
+
+    /**
+     * Format of the output samples.
+     */
+    typedef enum
+    {
+        SAMPLE_S16,     ///< 16 bit integer, dithered
+        SAMPLE_S32,     ///< 32 bit integer, full scale
+        SAMPLE_FLOAT    ///< float, nominal range -1 to 1, the mix is not clipped
+    } sample_format_t;
+
+private:
+    /// Frames mixed at once.
+    static const int BLOCK_SIZE = 256;
+
 private:
     std::vector<sidemu*> m_chips;
-    std::vector<short*> m_buffers;
+    std::vector<int*> m_buffers;
+
+    /// Volume of each SID.
+    std::vector<int_least32_t> m_gain;
+
+    /// Share of each SID in the left (or mono) and right channel.
+    //@{
+    std::vector<int_least32_t> m_panLeft;
+    std::vector<int_least32_t> m_panRight;
+    //@}
+
+    /// Whether the pan of each SID has been set explicitly.
+    std::vector<bool> m_panSet;
+
+    /// Left and right volumes.
+    int_least32_t m_volume[2];
+
+    /// Scaled samples of each SID for the current block.
+    std::vector<int_least32_t> m_samples;
+
+    /// Dither for the current block.
+    int_least32_t m_dither[BLOCK_SIZE];
 
-    std::vector<int_least32_t> m_iSamples;
-    std::vector<int_least32_t> m_volume;
+    /// Channel accumulator for the current block.
+    int_least32_t m_mix[BLOCK_SIZE];
 
-    std::vector<mixer_func_t> m_mix;
+    /// Scaled samples and accumulator for the wide formats.
+    //@{
+    std::vector<float> m_wideSamples;
+    float m_wideMix[BLOCK_SIZE];
+    //@}
+
+    /// Per instance generator so that engines running in parallel don't interfere
+    sidrandom m_rand;
 
     int oldRandomValue;
     int m_fastForwardFactor;
 
     // Mixer settings
+    sample_format_t m_format;
     short         *m_sampleBuffer;
+    int_least32_t *m_intBuffer;
+    float         *m_floatBuffer;
+
+    /// Stem buffers in the output format, three for each SID, or 0.
+    //@{
+    short         **m_stemSampleBuffers;
+    int_least32_t **m_stemIntBuffers;
+    float         **m_stemFloatBuffers;
+    //@}
     uint_least32_t m_sampleCount;
     uint_least32_t m_sampleIndex;
 
+    /// Position of the first sample not yet mixed in the SID buffers.
+    int m_readPos;
+
     bool m_stereo;
 
-private:
-    void updateParams();
+    /// Statistics, only updated when profiling.
+    //@{
+    std::vector<sidstats_t> m_stats;
+    uint_least64_t m_frames;
+    uint_least64_t m_mixTime;
 
-    int triangularDithering()
-    {
-        const int prevValue = oldRandomValue;
-        oldRandomValue = rand() & (VOLUME_MAX-1);
-        return oldRandomValue - prevValue;
-    }
+    /// Position the SIDs were left at by the last mixing.
+    int m_lastWritePos;
+    //@}
 
-    short channel1MonoMix() const { return static_cast<short>((m_iSamples[0] + m_iSamples[1]) / 2); }
-    short channel1StereoMix() const { return static_cast<short>(m_iSamples[0]); }
+private:
+    void updateParams();
 
-    short channel2FromMonoMix() const { return static_cast<short>(m_iSamples[0]); }
-    short channel2FromStereoMix() const { return static_cast<short>(m_iSamples[1]); }
+    void mixBlock(int frames, unsigned int channels);
+    void mixBlockWide(int frames, unsigned int channels);
+    void mixStems(int frames, unsigned int channels);
 
 public:
     /**
      * Create a new mixer.
-     *
-     * @param context event context
      */
     Mixer() :
+        m_rand(0),
         oldRandomValue(0),
         m_fastForwardFactor(1),
+        m_format(SAMPLE_S16),
+        m_sampleBuffer(0),
+        m_intBuffer(0),
+        m_floatBuffer(0),
+        m_stemSampleBuffers(0),
+        m_stemIntBuffers(0),
+        m_stemFloatBuffers(0),
         m_sampleCount(0),
-        m_stereo(false)
+        m_sampleIndex(0),
+        m_readPos(0),
+        m_stereo(false),
+        m_frames(0),
+        m_mixTime(0),
+        m_lastWritePos(0)
     {
-        m_mix.push_back(&Mixer::channel1MonoMix);
+        m_volume[0] = m_volume[1] = VOLUME_MAX;
     }
 
     /**
@@ -114,13 +202,48 @@ public:
      */
     void resetBufs();
 
+    /**
+     * Switch the SIDs to silent clocking and back.
+     *
+     * @param enable true to clock the SIDs without producing samples
+     */
+    void silent(bool enable);
+
+    /**
+     * Save or restore the state of the SIDs and
+     * of the mixing, including the dither.
+     * Restoring needs the same SIDs set up.
+     *
+     * @param s the state stream
+     * @return false if a SID doesn't support it
+     */
+    bool serialize(sidstate &s);
+
     /**
      * Prepare for mixing cycle.
      *
      * @param buffer output buffer
      * @param count size of the buffer in samples
+     * @param stems buffers for the voices of the SIDs rendering stems,
+     *        three for each SID, each taking a sample per frame, or 0
+     */
+    void begin(short *buffer, uint_least32_t count, short **stems = 0);
+
+    /**
+     * Prepare for mixing cycle with wide samples.
+     * The mix is neither dithered nor quantized to 16 bits,
+     * and neither are the samples of the SIDs emulated by reSIDfp.
+     * reSID clips its output to 16 bits by itself.
+     *
+     * @param buffer output buffer
+     * @param count size of the buffer in samples
+     * @param stems buffers for the voices of the SIDs rendering stems,
+     *        three for each SID, each taking a sample per frame, or 0
      */
-    void begin(short *buffer, uint_least32_t count);
+    //@{
+    void begin(int_least32_t *buffer, uint_least32_t count, int_least32_t **stems = 0);
+    void begin(float *buffer, uint_least32_t count, float **stems = 0);
+    //@}
 
     /**
      * Remove all SIDs from the mixer.
@@ -152,12 +275,26 @@ public:
 
     /**
      * Set mixing volumes, from 0 to #VOLUME_MAX.
+     * The first SID gets the left volume, the other ones the right volume.
      *
      * @param left volume for left or mono channel
      * @param right volume for right channel in stereo mode
      */
     void setVolume(int_least32_t left, int_least32_t right);
 
+    /**
+     * Set how much of a SID goes to each channel, from 0 to #VOLUME_MAX.
+     * By default in mono the SIDs are averaged and in stereo
+     * the first goes left, the second right and any other to the center.
+     * The setting is lost when the SIDs are removed.
+     *
+     * @param i the number of the SID
+     * @param left share of the left channel, or of the mono one
+     * @param right share of the right channel, unused in mono
+     * @return false if the SID doesn't exist or the values are out of range
+     */
+    bool setPan(unsigned int i, int_least32_t left, int_least32_t right);
+
     /**
      * Set mixing mode.
      *
@@ -167,8 +304,29 @@ public:
 
     /**
      * Check if the buffer have been filled.
+     * A trailing sample that can't hold a whole stereo frame is left alone.
+     */
+    bool notFinished() const { return m_sampleCount - m_sampleIndex >= (m_stereo ? 2u : 1u); }
+
+    /**
+     * Get the statistics of each SID.
+     */
+    const std::vector<sidstats_t> &sidStats() const { return m_stats; }
+
+    /**
+     * Get the number of frames mixed.
+     */
+    uint_least64_t frames() const { return m_frames; }
+
+    /**
+     * Get the time spent mixing in nanoseconds.
+     */
+    uint_least64_t mixTime() const { return m_mixTime; }
+
+    /**
+     * Clear the statistics.
      */
-    bool notFinished() const { return m_sampleIndex != m_sampleCount; }
+    void resetStats();
 
     /**
      * Get the number of samples generated up to now.
@@ -24,30 +24,52 @@
 #include "player.h"
 
 #include <ctime>
+#include <cstring>
 //#include <time.h>
 
 #include "SidTune.h"
 #include "sidemu.h"
 #include "psiddrv.h"
 #include "romCheck.h"
-
-#if defined(__WATCOMC__) || defined(_WIN32)
-#define _CRT_NONSTDC_NO_DEPRECATE
-#include <conio.h>
-#endif
+#include "sidstate.h"
+#include "sidprofile.h"
 
 SIDPLAYFP_NAMESPACE_START
 
 
 const char TXT_NA[]             = "NA";
 
+const char ERR_STATE_UNSUPPORTED[] = "SIDPLAYER ERROR: Unable to save the state of the SID emulation.";
+const char ERR_STATE_INVALID[]     = "SIDPLAYER ERROR: State saved with a different tune, song or configuration.";
+
+/**
+ * Marks the layout of the saved state,
+ * to be changed whenever anything saved changes.
+ */
+const uint32_t STATE_VERSION = 0x53494403;
+
+/**
+ * Time given to the filters and resamplers to settle
+ * after silent clocking. The 8580 settles well within it,
+ * the 6581 output is still some tens of LSB off right after
+ * the seek with anything between 50 ms and 2 s.
+ */
+const uint_least32_t SEEK_WARMUP_MS = 500;
+
 
 Player::Player () :
     // Set default settings for system
     m_tune(0),
     m_errorString(TXT_NA),
     m_isPlaying(false),
-    m_rand( (unsigned int) std::time(0) )
+    m_freeRunning(false),
+    m_stopRequested(false),
+    m_stopCallback(0),
+    m_stopData(0),
+    m_thread(*this),
+    m_rand( (unsigned int) std::time(0) ),
+    m_runEnd("Player run end", *this, &Player::runEnd),
+    m_running(false)
 {
 #ifdef PC64_TESTSUITE
     m_c64.setTestEnv(this);
@@ -102,6 +124,138 @@ bool Player::fastForward(unsigned int percent)
     return true;
 }
 
+bool Player::seek(uint_least32_t ms)
+{
+    if (!m_tune)
+        return false;
+
+    EventScheduler &scheduler = *m_c64.getEventScheduler();
+    const double cpuFreq = m_c64.getMainCpuSpeed();
+
+    const event_clock_t target = (event_clock_t)(cpuFreq * ms / 1000.);
+    const event_clock_t warmup = (event_clock_t)(cpuFreq * SEEK_WARMUP_MS / 1000.);
+
+    // The emulation can only go forward, restart the tune to go back
+    if (target < scheduler.getTime(EVENT_CLOCK_PHI1))
+    {
+        try
+        {
+            initialise();
+        }
+        catch (configError const &e)
+        {
+            m_errorString = e.message();
+            return false;
+        }
+    }
+
+    m_mixer.clockChips();
+    m_mixer.resetBufs();
+
+    // Run the bulk of the way with the SIDs silent...
+    m_mixer.silent(true);
+
+    for (;;)
+    {
+        const event_clock_t now = scheduler.getTime(EVENT_CLOCK_PHI1);
+        if (now + warmup >= target)
+            break;
+
+        const event_clock_t left = target - warmup - now;
+        run((left < sidemu::OUTPUTBUFFERSIZE) ? (unsigned int)left : (unsigned int)sidemu::OUTPUTBUFFERSIZE);
+        m_mixer.clockChips();
+        // In case an emulation doesn't support silent clocking
+        m_mixer.resetBufs();
+    }
+
+    m_mixer.silent(false);
+
+    // ...then let the output settle, throwing away the samples
+    for (;;)
+    {
+        const event_clock_t now = scheduler.getTime(EVENT_CLOCK_PHI1);
+        if (now >= target)
+            break;
+
+        const event_clock_t left = target - now;
+        run((left < sidemu::OUTPUTBUFFERSIZE) ? (unsigned int)left : (unsigned int)sidemu::OUTPUTBUFFERSIZE);
+        m_mixer.clockChips();
+        m_mixer.resetBufs();
+    }
+
+    return true;
+}
+
+bool Player::serialize(sidstate &s)
+{
+    s.tag(STATE_VERSION);
+
+    // The state only applies to the song and configuration it was saved with
+    char md5[SidTune::MD5_LENGTH + 1];
+    if (!m_tune->createMD5(md5))
+        memset(md5, 0, sizeof(md5));
+
+    char savedMd5[SidTune::MD5_LENGTH];
+    memcpy(savedMd5, md5, SidTune::MD5_LENGTH);
+    s.io(savedMd5, SidTune::MD5_LENGTH);
+    if (memcmp(savedMd5, md5, SidTune::MD5_LENGTH) != 0)
+        s.fail();
+
+    s.tag(m_tune->getInfo()->currentSong());
+    s.tag(m_cfg.frequency);
+    s.tag(m_cfg.samplingMethod);
+    s.tag(m_cfg.fastSampling);
+    s.tag(m_cfg.defaultC64Model);
+    s.tag(m_cfg.forceC64Model);
+    s.tag(m_cfg.defaultSidModel);
+    s.tag(m_cfg.forceSidModel);
+
+    if (s.failed())
+        return false;
+
+    return m_c64.serialize(s) && m_mixer.serialize(s);
+}
+
+bool Player::snapshot(std::vector<uint8_t> &state)
+{
+    state.clear();
+
+    if (!m_tune)
+        return false;
+
+    sidstate s(state);
+    if (!serialize(s))
+    {
+        m_errorString = ERR_STATE_UNSUPPORTED;
+        state.clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool Player::restore(const uint8_t *state, size_t size)
+{
+    if (!m_tune)
+        return false;
+
+    sidstate s(state, size);
+    if (!serialize(s) || !s.done())
+    {
+        m_errorString = ERR_STATE_INVALID;
+
+        // The state may have been partly restored, start over
+        try
+        {
+            initialise();
+        }
+        catch (configError const &e) {}
+        return false;
+    }
+
+    return true;
+}
+
 void Player::initialise()
 {
     m_isPlaying = false;
@@ -172,18 +326,92 @@ void Player::mute(unsigned int sidNum, unsigned int voice, bool enable)
         s->voice(voice, enable);
 }
 
-uint_least32_t Player::play(short *buffer, uint_least32_t count)
+/**
+ * Run the emulation for the given number of cycles.
+ * The CPU may run many cycles within a single event
+ * so the run is bounded by an end event rather than by event count.
+ * This also makes the amount of emulated time per run
+ * independent of the CPU mode.
+ */
+void Player::run(unsigned int cycles)
+{
+    EventScheduler &scheduler = *m_c64.getEventScheduler();
+    EventContext &context = scheduler;
+
+    const uint_least64_t start = sidprofile::now();
+
+    m_running = true;
+    context.schedule(m_runEnd, cycles, EVENT_CLOCK_PHI1);
+
+    while (m_running)
+        scheduler.clock();
+
+    if (sidprofile::enabled)
+        m_stats.m_emulationTime += sidprofile::now() - start;
+}
+
+const SidStats &Player::stats()
+{
+    m_stats.m_eventNames.clear();
+    m_stats.m_eventCounts.clear();
+
+    if (sidprofile::enabled)
+    {
+        std::vector<Event*> events;
+        m_c64.getEvents(events);
+        events.push_back(&m_runEnd);
+
+        for (std::vector<Event*>::const_iterator it = events.begin(); it != events.end(); ++it)
+            m_stats.addEvent((*it)->name(), (*it)->fired());
+    }
+
+    m_stats.m_sids = m_mixer.sidStats();
+    m_stats.m_mixerFrames = m_mixer.frames();
+    m_stats.m_mixerTime = m_mixer.mixTime();
+
+    return m_stats;
+}
+
+void Player::resetStats()
+{
+    std::vector<Event*> events;
+    m_c64.getEvents(events);
+    events.push_back(&m_runEnd);
+
+    for (std::vector<Event*>::const_iterator it = events.begin(); it != events.end(); ++it)
+        EventScheduler::resetFired(**it);
+
+    m_mixer.resetStats();
+    m_stats.m_emulationTime = 0;
+    m_stats.m_playTime = 0;
+}
+
+uint_least32_t Player::play(short *buffer, uint_least32_t count, short **stems)
+{
+    m_mixer.begin(buffer, count, stems);
+    return play(count);
+}
+
+uint_least32_t Player::play(int_least32_t *buffer, uint_least32_t count, int_least32_t **stems)
+{
+    m_mixer.begin(buffer, count, stems);
+    return play(count);
+}
+
+uint_least32_t Player::play(float *buffer, uint_least32_t count, float **stems)
+{
+    m_mixer.begin(buffer, count, stems);
+    return play(count);
+}
+
+uint_least32_t Player::play(uint_least32_t count)
 {
     // Make sure a tune is loaded
     if (!m_tune)
         return 0;
 
-    //printf("_DEBUG: Player::play | count = %lu \n", count);        
-
-    //printf("_DEBUG: before m_mixer.begin()\n");
+    const uint_least64_t start = sidprofile::now();
 
-    m_mixer.begin(buffer, count);
-        
     //printf("_DEBUG: Player::play | count = %lu \n", count);           
 
     // Start the player loop
@@ -198,8 +426,7 @@ uint_least32_t Player::play(short *buffer, uint_least32_t count)
             //printf("_DEBUG: count != 0 \n");
             while (m_isPlaying && m_mixer.notFinished())
             {
-                for (int i = 0; i < sidemu::OUTPUTBUFFERSIZE; i++)
-                    m_c64.getEventScheduler()->clock();
+                run(sidemu::OUTPUTBUFFERSIZE);
 
                 m_mixer.clockChips();
                 m_mixer.doMix();
@@ -210,33 +437,9 @@ uint_least32_t Player::play(short *buffer, uint_least32_t count)
         else
         {
             //printf("_DEBUG: Player::play | count == 0 \n");
-            int size = m_c64.getMainCpuSpeed() / m_cfg.frequency;
-
-            //printf("_DEBUG: Player::play | size (initial) = %d\n", size);
-            
-            while (m_isPlaying && !kbhit())// && --size)
-            {
-                        
-                            //printf("_DEBUG: Player::play | size = %d\n", size);
-
-
-                                //printf("_DEBUG: Player::play | calling m_c64.getEventScheduler()->clock() %d times\n", sidemu::OUTPUTBUFFERSIZE);
-                for (int i = 0; i < sidemu::OUTPUTBUFFERSIZE; i++)
-                                {
-                                        m_c64.getEventScheduler()->clock();
-                                        
-                                        /*for(int j = 0; j < 10; j++)
-                                        {
-                                                // wait
-                                        }*/
-                                }
-                                
-                                //printf("_DEBUG: Player::play | calling clockChips()\n");                              
-                //m_mixer.clockChips();
-                                //printf("_DEBUG: Player::play | calling resetBufs()\n");                               
-                //m_mixer.resetBufs();
-                                //printf("_DEBUG: Player::play | clockChips() and resetBufs() completed\n");
-            }
+            m_freeRunning = true;
+            playFree();
+            return 0;
         }
     }
     else
@@ -246,11 +449,19 @@ uint_least32_t Player::play(short *buffer, uint_least32_t count)
         int size = m_c64.getMainCpuSpeed() / m_cfg.frequency;
         while (m_isPlaying && --size)
         {
-            for (int i = 0; i < sidemu::OUTPUTBUFFERSIZE; i++)
-                m_c64.getEventScheduler()->clock();
+            run(sidemu::OUTPUTBUFFERSIZE);
         }
     }
 
+    //printf("_DEBUG: before return (count = %lu)\n", count);
+
+    playEnd(start);
+
+    return count;
+}
+
+void Player::playEnd(uint_least64_t start)
+{
     if (!m_isPlaying)
     {
         //printf("_DEBUG_: m_isPlaying == FALSE \n");
@@ -261,13 +472,103 @@ uint_least32_t Player::play(short *buffer, uint_least32_t count)
         catch (configError const &e) {}
     }
 
-    //printf("_DEBUG: before return (count = %lu)\n", count);
+    if (sidprofile::enabled)
+        m_stats.m_playTime += sidprofile::now() - start;
+}
 
-    return count;
+/**
+ * The hardware playback loop, nothing is mixed.
+ * The SIDs are still clocked after each emulation run,
+ * emulations throwing away their samples.
+ * The stop request and the callback are checked once
+ * every emulation run, nothing else is polled.
+ * m_isPlaying and m_freeRunning must be set on entry.
+ */
+void Player::playFree()
+{
+    const uint_least64_t start = sidprofile::now();
+
+    while (m_isPlaying && !m_stopRequested
+        && !(m_stopCallback && m_stopCallback(m_stopData)))
+    {
+        run(sidemu::OUTPUTBUFFERSIZE);
+
+        // Emulations would otherwise run past the end of their buffers
+        m_mixer.clockChips();
+        m_mixer.resetBufs();
+    }
+
+    // Stopped rather than paused by the callback
+    if (m_stopRequested)
+    {
+        m_isPlaying = false;
+        m_stopRequested = false;
+    }
+
+    playEnd(start);
+
+    m_freeRunning = false;
+}
+
+bool Player::playHardware(stopCallback callback, void *data)
+{
+    if (!m_tune || m_freeRunning)
+        return false;
+
+    m_stopCallback = callback;
+    m_stopData = data;
+    m_stopRequested = false;
+
+    m_mixer.begin((short*)0, 0);
+    play(0);
+
+    m_stopCallback = 0;
+    m_stopData = 0;
+    return true;
+}
+
+bool Player::start()
+{
+    if (!m_tune || m_freeRunning)
+        return false;
+
+    // Let any previous thread end before reusing it
+    m_thread.join();
+
+    // Set here so that a stop() coming before
+    // the thread gets going is not lost
+    m_mixer.begin((short*)0, 0);
+    m_stopRequested = false;
+    m_isPlaying = true;
+    m_freeRunning = true;
+
+    if (!m_thread.start())
+    {
+        m_freeRunning = false;
+        return false;
+    }
+
+    return true;
+}
+
+Player::~Player()
+{
+    if (m_freeRunning)
+        m_stopRequested = true;
+
+    m_thread.join();
 }
 
 void Player::stop()
-{   // Re-start song
+{
+    // The playback loop restarts the song when it ends
+    if (m_freeRunning)
+    {
+        m_stopRequested = true;
+        return;
+    }
+
+    // Re-start song
     if (m_tune && m_isPlaying)
     {
         if (m_mixer.notFinished())
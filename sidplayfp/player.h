@@ -26,12 +26,15 @@
 
 #include <stdint.h>
 #include <cstdio>
+#include <vector>
 
 #include "siddefs.h"
 #include "SidConfig.h"
 #include "SidTuneInfo.h"
 #include "SidInfoImpl.h"
+#include "SidStatsImpl.h"
 #include "sidrandom.h"
+#include "sidthread.h"
 #include "mixer.h"
 #include "event.h"
 #include "c64/c64.h"
@@ -47,6 +50,7 @@
 class SidTune;
 class SidInfo;
 class sidbuilder;
+class sidstate;
 
 
 SIDPLAYFP_NAMESPACE_START
@@ -67,6 +71,30 @@ private:
         const char* message() const { return m_msg; }
     };
 
+    /**
+     * Runs the hardware playback, see Player::start().
+     */
+    class playbackThread : public sidthread
+    {
+    private:
+        Player &m_player;
+
+    protected:
+        void run() { m_player.playFree(); }
+
+    public:
+        playbackThread(Player &player) :
+            m_player(player) {}
+    };
+
+    friend class playbackThread;
+
+public:
+    /**
+     * Polled during hardware playback, returns true to stop.
+     */
+    typedef bool (*stopCallback)(void *data);
+
 private:
     c64 m_c64;
 
@@ -75,6 +103,8 @@ private:
     SidTune *m_tune;
     SidInfoImpl m_info;
 
+    SidStatsImpl m_stats;
+
     // User Configuration Settings
     SidConfig m_cfg;
 
@@ -82,19 +112,43 @@ private:
 
     volatile bool m_isPlaying;
 
+    /// Set while the hardware playback loop is running
+    volatile bool m_freeRunning;
+
+    /// Set by stop() to end the hardware playback loop
+    volatile bool m_stopRequested;
+
+    stopCallback m_stopCallback;
+    void *m_stopData;
+
+    playbackThread m_thread;
+
     sidrandom m_rand;
 
     /// The PAL/NTSC switch value
     uint8_t videoSwitch;
 
+    /// Marks the end of an emulation run
+    EventCallback<Player> m_runEnd;
+
+    /// Set while an emulation run is in progress
+    bool m_running;
+
 private:
     c64::model_t c64model(SidConfig::c64_model_t defaultModel, bool forced);
     void initialise();
+    void run(unsigned int cycles);
+    void runEnd() { m_running = false; }
+    uint_least32_t play(uint_least32_t count);
+    void playFree();
+    void playEnd(uint_least64_t start);
+    bool serialize(sidstate &s);
     void sidRelease();
     void sidCreate(sidbuilder *builder, SidConfig::sid_model_t defaultModel,
                     bool forced, const unsigned int secondSidAddresses);
     void sidParams(double cpuFreq, int frequency,
-                    SidConfig::sampling_method_t sampling, bool fastSampling);
+                    SidConfig::sampling_method_t sampling, bool fastSampling,
+                    SidConfig::stem_mode_t stemMode);
 
     static SidConfig::sid_model_t getModel (SidTuneInfo::model_t sidModel, SidConfig::sid_model_t defaultModel, bool forced);
 
@@ -104,21 +158,39 @@ private:
 
 public:
     Player();
-    ~Player() {}
+    ~Player();
 
     const SidConfig &config() const { return m_cfg; }
 
     const SidInfo &info() const { return m_info; }
 
+    const SidStats &stats();
+
+    void resetStats();
+
     bool config(const SidConfig &cfg);
 
     bool fastForward(unsigned int percent);
 
+    bool seek(uint_least32_t ms);
+
+    bool snapshot(std::vector<uint8_t> &state);
+
+    bool restore(const uint8_t *state, size_t size);
+
     bool load(SidTune *tune);
 
     double cpuFreq() const { return m_c64.getMainCpuSpeed(); }
 
-    uint_least32_t play(short *buffer, uint_least32_t samples);
+    uint_least32_t play(short *buffer, uint_least32_t samples, short **stems = 0);
+    uint_least32_t play(int_least32_t *buffer, uint_least32_t samples, int_least32_t **stems = 0);
+    uint_least32_t play(float *buffer, uint_least32_t samples, float **stems = 0);
+
+    bool playHardware(stopCallback callback, void *data);
+
+    bool start();
+
+    void wait() { m_thread.join(); }
 
     bool isPlaying() const { return m_isPlaying; }
 
@@ -130,6 +202,11 @@ public:
 
     void mute(unsigned int sidNum, unsigned int voice, bool enable);
 
+    bool pan(unsigned int sidNum, uint_least32_t left, uint_least32_t right)
+    {
+        return m_mixer.setPan(sidNum, left, right);
+    }
+
     const char *error() const { return m_errorString; }
 
     void setRoms(const uint8_t* kernal, const uint8_t* basic, const uint8_t* character);
@@ -37,7 +37,7 @@
 const char ERR_PSIDDRV_NO_SPACE[]  = "ERROR: No space to install psid driver in C64 ram";
 const char ERR_PSIDDRV_RELOC[]     = "ERROR: Failed whilst relocating psid driver";
 
-uint8_t psid_driver[] = {
+const uint8_t psid_driver[] = {
 #  include "psiddrv.bin"
 };
 
@@ -174,7 +174,9 @@ bool psiddrv::drvReloc()
     // Place psid driver into ram
     const uint_least16_t relocAddr = relocStartPage << 8;
 
-    reloc_driver = psid_driver;
+    m_driver.assign(psid_driver, psid_driver + sizeof (psid_driver));
+
+    reloc_driver = &m_driver[0];
     reloc_size   = sizeof (psid_driver);
 
     reloc65 relocator;
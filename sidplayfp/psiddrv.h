@@ -23,6 +23,8 @@
 
 #include <stdint.h>
 
+#include <vector>
+
 class SidTuneInfo;
 class sidmemory;
 
@@ -32,6 +34,9 @@ private:
     const SidTuneInfo *m_tuneInfo;
     const char *m_errorString;
 
+    /// Private copy of the driver, relocated in place
+    std::vector<uint8_t> m_driver;
+
     uint8_t *reloc_driver;
     int      reloc_size;
 
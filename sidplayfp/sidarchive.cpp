@@ -0,0 +1,397 @@
+/*
+ * This file is part of libsidplayfp, a SID player engine.
+ *
+ *  Copyright 2014 Leandro Nini <drfiemost@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "sidarchive.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include "SidTune.h"
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#ifdef HAVE_SYS_MMAN_H
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#endif
+
+const char ERR_NO_ERROR[]          = "No error.";
+const char ERR_NO_ARCHIVE[]        = "SIDARCHIVE ERROR: No archive loaded.";
+const char ERR_UNABLE_TO_OPEN[]    = "SIDARCHIVE ERROR: Unable to open the archive.";
+const char ERR_ARCHIVE_CORRUPT[]   = "SIDARCHIVE ERROR: Archive seems to be corrupt.";
+const char ERR_UNABLE_TO_READ[]    = "SIDARCHIVE ERROR: Unable to read a file to pack.";
+const char ERR_UNABLE_TO_WRITE[]   = "SIDARCHIVE ERROR: Unable to write the archive.";
+const char ERR_ARCHIVE_TOO_LARGE[] = "SIDARCHIVE ERROR: Files too large for an archive.";
+
+static const char MAGIC[8] = { 'S', 'I', 'D', 'P', 'A', 'C', 'K', 0 };
+
+/**
+ * Archive header, the entries follow,
+ * then the names and the file contents.
+ */
+struct sidarchive::header_t
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t count;
+    uint32_t names;
+    uint32_t reserved;
+};
+
+/**
+ * Archive entry, sorted by name.
+ * The offset of the contents is from the start of the archive.
+ */
+struct sidarchive::entry_t
+{
+    uint32_t name;
+    uint32_t nameLength;
+    uint32_t offset;
+    uint32_t length;
+};
+
+sidarchive::sidarchive() :
+    m_data(0),
+    m_size(0),
+    m_mapped(false),
+    errorString(ERR_NO_ARCHIVE) {}
+
+sidarchive::~sidarchive()
+{
+    close();
+}
+
+const sidarchive::header_t *sidarchive::header() const
+{
+    return reinterpret_cast<const header_t*>(m_data);
+}
+
+const sidarchive::entry_t *sidarchive::entries() const
+{
+    return reinterpret_cast<const entry_t*>(m_data + sizeof(header_t));
+}
+
+const char *sidarchive::names() const
+{
+    return reinterpret_cast<const char*>(entries() + header()->count);
+}
+
+bool sidarchive::pack(const char *root, const std::vector<std::string> &files, const char *filename)
+{
+    std::vector<std::string> sorted(files);
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+    const std::string dir(root);
+
+    header_t header;
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = FORMAT_VERSION;
+    header.count = sorted.size();
+    header.names = 0;
+    header.reserved = 0;
+
+    std::vector<entry_t> table(sorted.size());
+
+    for (size_t i = 0; i < sorted.size(); i++)
+    {
+        table[i].name = header.names;
+        table[i].nameLength = sorted[i].size();
+        header.names += sorted[i].size();
+    }
+
+    // Find the file sizes to lay out the contents
+    uint64_t offset = sizeof(header_t) + table.size() * sizeof(entry_t) + header.names;
+
+    for (size_t i = 0; i < sorted.size(); i++)
+    {
+        FILE *f = fopen((dir + sorted[i]).c_str(), "rb");
+        if (f == 0)
+        {
+            errorString = ERR_UNABLE_TO_READ;
+            return false;
+        }
+
+        fseek(f, 0, SEEK_END);
+        const long length = ftell(f);
+        fclose(f);
+
+        if (length < 0)
+        {
+            errorString = ERR_UNABLE_TO_READ;
+            return false;
+        }
+
+        table[i].offset = (uint32_t)offset;
+        table[i].length = (uint32_t)length;
+        offset += length;
+
+        if (offset > 0xffffffffu)
+        {
+            errorString = ERR_ARCHIVE_TOO_LARGE;
+            return false;
+        }
+    }
+
+    // Write to a temporary file and rename it so that
+    // readers never see a partial archive.
+    const std::string tmpPath = std::string(filename) + ".tmp";
+
+    {
+        std::ofstream out(tmpPath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header_t));
+        if (!table.empty())
+            out.write(reinterpret_cast<const char*>(&table[0]), table.size() * sizeof(entry_t));
+        for (size_t i = 0; i < sorted.size(); i++)
+            out.write(sorted[i].data(), sorted[i].size());
+
+        std::vector<char> buffer;
+        bool status = out.good();
+        for (size_t i = 0; status && i < sorted.size(); i++)
+        {
+            buffer.resize(table[i].length);
+
+            FILE *f = fopen((dir + sorted[i]).c_str(), "rb");
+            if (f == 0)
+            {
+                status = false;
+                break;
+            }
+
+            const size_t read = buffer.empty() ? 0 : fread(&buffer[0], 1, buffer.size(), f);
+            fclose(f);
+
+            // The file changed since its size was taken
+            if (read != buffer.size())
+            {
+                status = false;
+                break;
+            }
+
+            if (!buffer.empty())
+                out.write(&buffer[0], buffer.size());
+        }
+
+        if (!status || !out.good())
+        {
+            out.close();
+            std::remove(tmpPath.c_str());
+            errorString = status ? ERR_UNABLE_TO_WRITE : ERR_UNABLE_TO_READ;
+            return false;
+        }
+    }
+
+    if (std::rename(tmpPath.c_str(), filename) != 0)
+    {
+        // Rename doesn't replace existing files everywhere
+        std::remove(filename);
+        if (std::rename(tmpPath.c_str(), filename) != 0)
+        {
+            std::remove(tmpPath.c_str());
+            errorString = ERR_UNABLE_TO_WRITE;
+            return false;
+        }
+    }
+
+    errorString = ERR_NO_ERROR;
+    return true;
+}
+
+bool sidarchive::open(const char *filename)
+{
+    close();
+
+#ifdef HAVE_SYS_MMAN_H
+    const int fd = ::open(filename, O_RDONLY);
+    if (fd < 0)
+    {
+        errorString = ERR_UNABLE_TO_OPEN;
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(header_t))
+    {
+        ::close(fd);
+        errorString = ERR_ARCHIVE_CORRUPT;
+        return false;
+    }
+
+    // Pages are loaded on demand and shared with other processes
+    void *map = mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    if (map == MAP_FAILED)
+    {
+        errorString = ERR_UNABLE_TO_OPEN;
+        return false;
+    }
+
+    m_data = static_cast<const uint8_t*>(map);
+    m_size = st.st_size;
+    m_mapped = true;
+#else
+    std::ifstream in(filename, std::ios::in | std::ios::binary);
+    if (!in.is_open())
+    {
+        errorString = ERR_UNABLE_TO_OPEN;
+        return false;
+    }
+
+    in.seekg(0, std::ios::end);
+    const std::streamoff size = in.tellg();
+    in.seekg(0, std::ios::beg);
+
+    if (size < (std::streamoff)sizeof(header_t))
+    {
+        errorString = ERR_ARCHIVE_CORRUPT;
+        return false;
+    }
+
+    m_buffer.resize((size_t)size);
+    if (!in.read(reinterpret_cast<char*>(&m_buffer[0]), size))
+    {
+        m_buffer.clear();
+        errorString = ERR_UNABLE_TO_OPEN;
+        return false;
+    }
+
+    m_data = &m_buffer[0];
+    m_size = m_buffer.size();
+#endif
+
+    // Check that the tables fit in the file, the entries are checked on lookup
+    const header_t *h = header();
+    const bool valid = memcmp(h->magic, MAGIC, sizeof(MAGIC)) == 0
+        && h->version == FORMAT_VERSION
+        && h->count <= (m_size - sizeof(header_t)) / sizeof(entry_t)
+        && h->names <= m_size - sizeof(header_t) - h->count * sizeof(entry_t);
+
+    if (!valid)
+    {
+        close();
+        errorString = ERR_ARCHIVE_CORRUPT;
+        return false;
+    }
+
+    errorString = ERR_NO_ERROR;
+    return true;
+}
+
+void sidarchive::close()
+{
+    if (m_mapped)
+    {
+#ifdef HAVE_SYS_MMAN_H
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+    }
+
+    std::vector<uint8_t>().swap(m_buffer);
+    m_data = 0;
+    m_size = 0;
+    m_mapped = false;
+    errorString = ERR_NO_ARCHIVE;
+}
+
+unsigned int sidarchive::size() const
+{
+    return m_data ? header()->count : 0;
+}
+
+std::string sidarchive::path(unsigned int i) const
+{
+    if (i >= size())
+        return std::string();
+
+    const entry_t &e = entries()[i];
+    if (e.name > header()->names || e.nameLength > header()->names - e.name)
+        return std::string();
+
+    return std::string(names() + e.name, e.nameLength);
+}
+
+const sidarchive::entry_t *sidarchive::find(const char *path) const
+{
+    if (m_data == 0)
+        return 0;
+
+    const size_t length = strlen(path);
+    const uint32_t namesSize = header()->names;
+    const char *pool = names();
+
+    // Binary search on the names, compared as unsigned bytes like std::string does
+    const entry_t *table = entries();
+    uint32_t lo = 0;
+    uint32_t hi = header()->count;
+
+    while (lo < hi)
+    {
+        const uint32_t mid = lo + (hi - lo) / 2;
+        const entry_t &e = table[mid];
+
+        if (e.name > namesSize || e.nameLength > namesSize - e.name)
+            return 0;
+
+        const size_t n = std::min<size_t>(length, e.nameLength);
+        int cmp = memcmp(pool + e.name, path, n);
+        if (cmp == 0)
+            cmp = (e.nameLength < length) ? -1 : (e.nameLength > length) ? 1 : 0;
+
+        if (cmp == 0)
+            return &e;
+
+        if (cmp < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return 0;
+}
+
+bool sidarchive::get(const char *path, const uint_least8_t *&data, uint_least32_t &length) const
+{
+    const entry_t *e = find(path);
+    if (e == 0 || e->offset > m_size || e->length > m_size - e->offset)
+        return false;
+
+    data = m_data + e->offset;
+    length = e->length;
+    return true;
+}
+
+bool sidarchive::load(const char *path, SidTune &tune) const
+{
+    const uint_least8_t *data;
+    uint_least32_t length;
+    if (!get(path, data, length))
+        return false;
+
+    tune.attach(data, length);
+    return true;
+}
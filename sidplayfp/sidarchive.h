@@ -0,0 +1,141 @@
+/*
+ * This file is part of libsidplayfp, a SID player engine.
+ *
+ *  Copyright 2014 Leandro Nini <drfiemost@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef SIDARCHIVE_H
+#define SIDARCHIVE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <string>
+#include <vector>
+
+#include "sidplayfp/siddefs.h"
+
+class SidTune;
+
+/**
+ * A collection of tunes packed in a single uncompressed file.
+ *
+ * The archive holds a table of the file paths in sorted order
+ * followed by the file contents. Where available it is memory
+ * mapped, so serving a tune takes a binary search and no file
+ * operations: the tune is attached to a SidTune in place and
+ * only copied when placed in C64 memory.
+ * The archive is stored in native byte order.
+ *
+ * Once open, the lookups don't change the object
+ * and can be called from many threads at once.
+ */
+class SID_EXTERN sidarchive
+{
+public:
+    /// Version of the archive format.
+    static const uint32_t FORMAT_VERSION = 1;
+
+private:
+    struct header_t;
+    struct entry_t;
+
+private:
+    /// The archive, mapped or read in memory.
+    const uint8_t *m_data;
+    size_t m_size;
+    bool m_mapped;
+
+    std::vector<uint8_t> m_buffer;
+
+    const char *errorString;
+
+private:
+    const header_t *header() const;
+    const entry_t *entries() const;
+    const char *names() const;
+
+    const entry_t *find(const char *path) const;
+
+    // prevent copying
+    sidarchive(const sidarchive&);
+    sidarchive& operator=(const sidarchive&);
+
+public:
+    sidarchive();
+    ~sidarchive();
+
+    /**
+     * Pack files in an archive.
+     *
+     * @param root the directory the paths are relative to
+     * @param files the paths of the files, e.g. from a #sidcatalog
+     * @param filename the archive file to write.
+     * @return false in case of errors, true otherwise.
+     */
+    bool pack(const char *root, const std::vector<std::string> &files, const char *filename);
+
+    /**
+     * Open an archive.
+     *
+     * @param filename the archive file.
+     * @return false in case of errors, true otherwise.
+     */
+    bool open(const char *filename);
+
+    /**
+     * Close the archive.
+     */
+    void close();
+
+    /**
+     * Get the number of files.
+     */
+    unsigned int size() const;
+
+    /**
+     * Get the path of a file, in sorted order.
+     */
+    std::string path(unsigned int i) const;
+
+    /**
+     * Get the contents of a file.
+     *
+     * @param path the path as packed
+     * @param data the file contents, valid while the archive is open
+     * @param length the file length
+     * @return false if the file is not in the archive.
+     */
+    bool get(const char *path, const uint_least8_t *&data, uint_least32_t &length) const;
+
+    /**
+     * Load a tune from the archive without copying it.
+     * The archive must stay open as long as the tune is loaded.
+     *
+     * @param path the path as packed
+     * @param tune the tune to load, check its status for errors
+     * @return false if the file is not in the archive.
+     */
+    bool load(const char *path, SidTune &tune) const;
+
+    /**
+     * Get the description of the last error.
+     */
+    const char *error() const { return errorString; }
+};
+
+#endif // SIDARCHIVE_H
@@ -0,0 +1,212 @@
+/*
+ * This file is part of libsidplayfp, a SID player engine.
+ *
+ *  Copyright 2014 Leandro Nini <drfiemost@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "sidbatch.h"
+
+#include <memory>
+
+#include "sidplayfp.h"
+#include "sidbuilder.h"
+#include "SidTune.h"
+#include "sidthread.h"
+
+const char ERR_NO_BUILDER[] = "SIDBATCH ERROR: Unable to create sid builder.";
+const char ERR_NO_TUNE[]    = "SIDBATCH ERROR: No tune or sink.";
+const char ERR_STOPPED[]    = "SIDBATCH ERROR: Engine stopped.";
+const char ERR_ABORTED[]    = "SIDBATCH ERROR: Aborted by sink.";
+
+/**
+ * Renders jobs from the shared queue until the queue is empty.
+ * Every job gets a fresh engine and builder so the output
+ * doesn't depend on which worker rendered the previous jobs.
+ */
+class sidbatch::worker : public sidthread
+{
+private:
+    /// Samples rendered per play call
+    static const uint_least32_t BUFFERSIZE = 4096;
+
+private:
+    std::vector<sidjob*> &m_jobs;
+    size_t &m_next;
+    sidmutex &m_mutex;
+
+    builder_factory_t m_factory;
+    void *m_data;
+
+private:
+    sidjob *next()
+    {
+        sidlock lock(m_mutex);
+        return (m_next < m_jobs.size()) ? m_jobs[m_next++] : 0;
+    }
+
+    bool render(sidjob &job);
+
+protected:
+    void run()
+    {
+        while (sidjob *job = next())
+        {
+            job->status = render(*job);
+        }
+    }
+
+public:
+    worker(std::vector<sidjob*> &jobs, size_t &next, sidmutex &mutex,
+            builder_factory_t factory, void *data) :
+        m_jobs(jobs),
+        m_next(next),
+        m_mutex(mutex),
+        m_factory(factory),
+        m_data(data) {}
+
+    ~worker() { join(); }
+
+    /// Render in the calling thread
+    void runHere() { run(); }
+};
+
+bool sidbatch::worker::render(sidjob &job)
+{
+    job.error.clear();
+
+    if (job.tune == 0 || job.sink == 0)
+    {
+        job.error = ERR_NO_TUNE;
+        return false;
+    }
+
+    job.tune->selectSong(job.song);
+    if (!job.tune->getStatus())
+    {
+        job.error = job.tune->statusString();
+        return false;
+    }
+
+    std::auto_ptr<sidbuilder> builder(m_factory(m_data));
+    if (builder.get() == 0 || !builder->getStatus())
+    {
+        job.error = ERR_NO_BUILDER;
+        return false;
+    }
+
+    sidplayfp engine;
+
+    SidConfig cfg = job.config;
+    cfg.sidEmulation = builder.get();
+
+    if (!engine.config(cfg) || !engine.load(job.tune))
+    {
+        job.error = engine.error();
+        return false;
+    }
+
+    const unsigned int channels = (cfg.playback == SidConfig::STEREO) ? 2 : 1;
+    uint_least32_t samples = (uint_least32_t)(((uint64_t)cfg.frequency * job.length) / 1000) * channels;
+
+    std::vector<short> buffer(BUFFERSIZE * channels);
+
+    bool status = true;
+    while (samples)
+    {
+        const uint_least32_t count = samples < buffer.size() ? samples : buffer.size();
+        const uint_least32_t played = engine.play(&buffer[0], count);
+        if (played == 0)
+        {
+            job.error = ERR_STOPPED;
+            status = false;
+            break;
+        }
+
+        if (!job.sink->write(&buffer[0], played))
+        {
+            job.error = ERR_ABORTED;
+            status = false;
+            break;
+        }
+
+        samples -= played;
+    }
+
+    // Give the sids back before the builder goes away
+    cfg.sidEmulation = 0;
+    engine.config(cfg);
+
+    return status;
+}
+
+sidbatch::sidbatch(builder_factory_t factory, void *data, unsigned int threads) :
+    m_factory(factory),
+    m_data(data),
+    m_threads(sidthread::supported() ? threads : 0) {}
+
+void sidbatch::add(sidjob *job)
+{
+    job->status = false;
+    job->error.clear();
+    m_jobs.push_back(job);
+}
+
+unsigned int sidbatch::run()
+{
+    if (m_jobs.empty())
+        return 0;
+
+    size_t next = 0;
+    sidmutex mutex;
+
+    size_t count = (m_threads < m_jobs.size()) ? m_threads : m_jobs.size();
+    if (count == 0)
+        count = 1;
+
+    std::vector<worker*> workers;
+    for (size_t i = 0; i < count; i++)
+    {
+        workers.push_back(new worker(m_jobs, next, mutex, m_factory, m_data));
+    }
+
+    bool started = false;
+    if (m_threads != 0)
+    {
+        for (size_t i = 0; i < workers.size(); i++)
+        {
+            started |= workers[i]->start();
+        }
+    }
+
+    // No threads running, do the work here
+    if (!started)
+        workers[0]->runHere();
+
+    for (size_t i = 0; i < workers.size(); i++)
+    {
+        delete workers[i];
+    }
+
+    unsigned int failed = 0;
+    for (size_t i = 0; i < m_jobs.size(); i++)
+    {
+        if (!m_jobs[i]->status)
+            failed++;
+    }
+
+    return failed;
+}
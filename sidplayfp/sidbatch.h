@@ -0,0 +1,175 @@
+/*
+ * This file is part of libsidplayfp, a SID player engine.
+ *
+ *  Copyright 2014 Leandro Nini <drfiemost@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef SIDBATCH_H
+#define SIDBATCH_H
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "sidplayfp/siddefs.h"
+#include "sidplayfp/SidConfig.h"
+
+class SidTune;
+class sidbuilder;
+
+/**
+ * Destination of the samples rendered by a #sidjob.
+ */
+class SID_EXTERN sidsink
+{
+public:
+    virtual ~sidsink() {}
+
+    /**
+     * Receive rendered samples.
+     * Called from the worker thread rendering the job.
+     *
+     * @param buffer the samples, interleaved if stereo
+     * @param count the number of 16 bit samples in the buffer
+     * @return false to abort the job
+     */
+    virtual bool write(const short *buffer, uint_least32_t count) = 0;
+};
+
+/**
+ * A tune rendering request for #sidbatch.
+ */
+class SID_EXTERN sidjob
+{
+public:
+    /**
+     * The tune to render.
+     * The song is selected by the worker, so concurrent
+     * jobs must not share the same SidTune object.
+     */
+    SidTune *tune;
+
+    /**
+     * The song to render, 0 for the default one.
+     */
+    unsigned int song;
+
+    /**
+     * Rendering length in milliseconds.
+     */
+    uint_least32_t length;
+
+    /**
+     * Engine configuration.
+     * The sidEmulation field is ignored, each worker
+     * uses its own builder.
+     */
+    SidConfig config;
+
+    /**
+     * Where to write the samples.
+     */
+    sidsink *sink;
+
+    /**
+     * Result of the job, set when the batch has run.
+     */
+    //@{
+    bool status;
+    std::string error;
+    //@}
+
+public:
+    sidjob() :
+        tune(0),
+        song(0),
+        length(0),
+        sink(0),
+        status(false) {}
+};
+
+/**
+ * Render many tunes in parallel.
+ *
+ * Each job is rendered by a complete engine with its own
+ * sid builder, so no emulation state is shared among jobs
+ * and the output is the same whatever the number of threads.
+ * Where threads are not available the jobs are
+ * rendered one after another in the calling thread.
+ */
+class SID_EXTERN sidbatch
+{
+public:
+    /**
+     * Create a builder for a job.
+     * Called from the worker threads, the builder must have
+     * already created the needed emus and is deleted by the batch
+     * when the job is done.
+     *
+     * @param data the user data passed to the batch
+     * @return a new builder, 0 on failure
+     */
+    typedef sidbuilder* (*builder_factory_t)(void *data);
+
+private:
+    class worker;
+
+private:
+    builder_factory_t m_factory;
+    void *m_data;
+
+    const unsigned int m_threads;
+
+    std::vector<sidjob*> m_jobs;
+
+private:
+    // prevent copying
+    sidbatch(const sidbatch&);
+    sidbatch& operator=(const sidbatch&);
+
+public:
+    /**
+     * @param factory function creating the builders for the workers
+     * @param data user data for the factory
+     * @param threads the number of worker threads, 0 renders in the calling thread
+     */
+    sidbatch(builder_factory_t factory, void *data, unsigned int threads);
+
+    /**
+     * Queue a job.
+     * The job must stay valid until #run returns.
+     *
+     * @param job the job to add
+     */
+    void add(sidjob *job);
+
+    /**
+     * Remove all queued jobs.
+     */
+    void clear() { m_jobs.clear(); }
+
+    /**
+     * Render all queued jobs and wait for completion.
+     * Check each job's status for the results.
+     *
+     * @return the number of failed jobs
+     */
+    unsigned int run();
+};
+
+#endif // SIDBATCH_H
@@ -0,0 +1,566 @@
+/*
+ * This file is part of libsidplayfp, a SID player engine.
+ *
+ *  Copyright 2014 Leandro Nini <drfiemost@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "sidcatalog.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include "sidthread.h"
+#include "utils/SidDatabase.h"
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#if defined(_WIN32)
+#  include <windows.h>
+#elif defined(HAVE_DIRENT_H)
+#  include <dirent.h>
+#  include <sys/stat.h>
+#endif
+
+const char ERR_NO_ERROR[]        = "No error.";
+const char ERR_NO_DIRECTORY[]    = "SIDCATALOG ERROR: Unable to read the directory.";
+const char ERR_UNABLE_TO_READ[]  = "SIDCATALOG ERROR: Unable to read the catalog.";
+const char ERR_UNABLE_TO_WRITE[] = "SIDCATALOG ERROR: Unable to write the catalog.";
+const char ERR_CATALOG_CORRUPT[] = "SIDCATALOG ERROR: Catalog seems to be corrupt.";
+
+static const char MAGIC[8] = { 'S', 'I', 'D', 'C', 'A', 'T', 'L', 'G' };
+
+static const unsigned int DIGEST_LENGTH = 16;
+
+/// Largest tune file, C64KB+LOAD+PSID
+static const uint_least32_t MAX_FILELEN = 65536 + 2 + 0x7c;
+
+/**
+ * Catalog header, the columns follow in this order:
+ * - md5 digests, 16 bytes each;
+ * - uint32 offsets of path, title, author and released in the strings;
+ * - uint32 position of the first song length;
+ * - the int32 song lengths;
+ * - uint16 load, init and play address, second sid address,
+ *   number of songs and start song;
+ * - uint8 compatibility, clock, sid models and flags;
+ * - the null terminated strings.
+ */
+struct sidcatalog::header_t
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t count;
+    uint32_t lengths;
+    uint32_t strings;
+};
+
+/**
+ * Loads tunes from the shared list until the list is done.
+ */
+class sidcatalog::worker : public sidthread
+{
+private:
+    const std::string &m_root;
+    const std::vector<std::string> &m_files;
+    std::vector<sidcatalog::entry> &m_entries;
+
+    size_t &m_next;
+    sidmutex &m_mutex;
+
+    stil_check_t m_stilCheck;
+    void *m_stilData;
+
+    /// File contents, one byte more than the largest tune to detect longer ones
+    std::vector<uint_least8_t> m_buffer;
+
+    SidTune m_tune;
+
+private:
+    size_t next()
+    {
+        sidlock lock(m_mutex);
+        return (m_next < m_files.size()) ? m_next++ : m_files.size();
+    }
+
+    bool load(size_t i);
+
+protected:
+    void run()
+    {
+        for (size_t i = next(); i < m_files.size(); i = next())
+        {
+            if (!load(i))
+                m_entries[i].md5[0] = '\0';
+        }
+    }
+
+public:
+    worker(const std::string &root, const std::vector<std::string> &files,
+            std::vector<sidcatalog::entry> &entries, size_t &next, sidmutex &mutex,
+            stil_check_t stilCheck, void *stilData) :
+        m_root(root),
+        m_files(files),
+        m_entries(entries),
+        m_next(next),
+        m_mutex(mutex),
+        m_stilCheck(stilCheck),
+        m_stilData(stilData),
+        m_buffer(MAX_FILELEN + 1),
+        m_tune(0) {}
+
+    ~worker() { join(); }
+
+    /// Scan in the calling thread
+    void runHere() { run(); }
+};
+
+bool sidcatalog::worker::load(size_t i)
+{
+    const std::string fileName = m_root + m_files[i];
+
+    FILE *file = fopen(fileName.c_str(), "rb");
+    if (file == 0)
+        return false;
+
+    const size_t length = fread(&m_buffer[0], 1, m_buffer.size(), file);
+    fclose(file);
+
+    // A single read and no file name extension probing,
+    // tunes in HVSC are all in one file
+    m_tune.read(&m_buffer[0], length);
+    if (!m_tune.getStatus())
+        return false;
+
+    const SidTuneInfo *info = m_tune.getInfo();
+
+    sidcatalog::entry &e = m_entries[i];
+    e.path = m_files[i];
+    m_tune.createMD5(e.md5);
+
+    e.title = info->numberOfInfoStrings() > 0 ? info->infoString(0) : "";
+    e.author = info->numberOfInfoStrings() > 1 ? info->infoString(1) : "";
+    e.released = info->numberOfInfoStrings() > 2 ? info->infoString(2) : "";
+
+    e.loadAddr = info->loadAddr();
+    e.initAddr = info->initAddr();
+    e.playAddr = info->playAddr();
+    e.sidChipBase2 = info->sidChipBase2();
+    e.songs = info->songs();
+    e.startSong = info->startSong();
+    e.compatibility = info->compatibility();
+    e.clockSpeed = info->clockSpeed();
+    e.sidModel1 = info->sidModel1();
+    e.sidModel2 = info->sidModel2();
+    e.flags = m_stilCheck ? m_stilCheck(e.path.c_str(), m_stilData) : 0;
+    e.lengths.assign(e.songs, -1);
+
+    return true;
+}
+
+static bool isTune(const std::string &path)
+{
+    if (path.size() < 4)
+        return false;
+
+    std::string ext = path.substr(path.size() - 4);
+    for (std::string::iterator it = ext.begin(); it != ext.end(); ++it)
+        *it = tolower(*it);
+
+    return ext == ".sid";
+}
+
+sidcatalog::sidcatalog(unsigned int threads) :
+    m_threads(sidthread::supported() ? threads : 0),
+    m_database(0),
+    m_stilCheck(0),
+    m_stilData(0),
+    m_failed(0),
+    m_time(0),
+    errorString(ERR_NO_ERROR) {}
+
+bool sidcatalog::listFiles(const std::string &dir, const std::string &relPath,
+                           std::vector<std::string> &files)
+{
+#if defined(_WIN32)
+    WIN32_FIND_DATAA data;
+    const HANDLE find = FindFirstFileA((dir + relPath + "\\*").c_str(), &data);
+    if (find == INVALID_HANDLE_VALUE)
+        return false;
+
+    do
+    {
+        const std::string name(data.cFileName);
+        if (name == "." || name == "..")
+            continue;
+
+        const std::string path = relPath + "/" + name;
+        if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            listFiles(dir, path, files);
+        else if (isTune(name))
+            files.push_back(path);
+    }
+    while (FindNextFileA(find, &data));
+
+    FindClose(find);
+    return true;
+#elif defined(HAVE_DIRENT_H)
+    DIR *d = opendir((dir + relPath).c_str());
+    if (d == 0)
+        return false;
+
+    while (const dirent *de = readdir(d))
+    {
+        const std::string name(de->d_name);
+        if (name == "." || name == "..")
+            continue;
+
+        const std::string path = relPath + "/" + name;
+
+        struct stat st;
+        if (stat((dir + path).c_str(), &st) != 0)
+            continue;
+
+        if (S_ISDIR(st.st_mode))
+            listFiles(dir, path, files);
+        else if (S_ISREG(st.st_mode) && isTune(name))
+            files.push_back(path);
+    }
+
+    closedir(d);
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool sidcatalog::scan(const char *root)
+{
+    const uint_least64_t start = sidthread::now();
+
+    m_entries.clear();
+    m_failed = 0;
+    m_time = 0;
+
+    std::string dir(root);
+    while (dir.size() > 1 && (*(dir.end() - 1) == '/' || *(dir.end() - 1) == '\\'))
+        dir.erase(dir.end() - 1);
+
+    std::vector<std::string> files;
+    if (!listFiles(dir, "", files))
+    {
+        errorString = ERR_NO_DIRECTORY;
+        return false;
+    }
+
+    std::sort(files.begin(), files.end());
+
+    m_entries.resize(files.size());
+
+    {
+        size_t next = 0;
+        sidmutex mutex;
+
+        size_t count = (m_threads < files.size()) ? m_threads : files.size();
+        if (count == 0)
+            count = 1;
+
+        std::vector<worker*> workers;
+        for (size_t i = 0; i < count; i++)
+        {
+            workers.push_back(new worker(dir, files, m_entries, next, mutex, m_stilCheck, m_stilData));
+        }
+
+        bool started = false;
+        if (m_threads != 0)
+        {
+            for (size_t i = 0; i < workers.size(); i++)
+            {
+                started |= workers[i]->start();
+            }
+        }
+
+        // No threads running, do the work here
+        if (!started && !workers.empty())
+            workers[0]->runHere();
+
+        for (size_t i = 0; i < workers.size(); i++)
+        {
+            delete workers[i];
+        }
+    }
+
+    // Drop the files that failed to load
+    size_t n = 0;
+    for (size_t i = 0; i < m_entries.size(); i++)
+    {
+        if (m_entries[i].md5[0] == '\0')
+            continue;
+
+        if (n != i)
+            std::swap(m_entries[n], m_entries[i]);
+        n++;
+    }
+    m_failed = m_entries.size() - n;
+    m_entries.resize(n);
+
+    // The database lookups are cheap, do them here
+    // rather than requiring a thread safe database
+    if (m_database)
+    {
+        for (std::vector<entry>::iterator it = m_entries.begin(); it != m_entries.end(); ++it)
+        {
+            for (unsigned int s = 0; s < it->songs; s++)
+            {
+                it->lengths[s] = m_database->lengthMs(it->md5, s + 1);
+            }
+        }
+    }
+
+    m_time = sidthread::now() - start;
+    errorString = ERR_NO_ERROR;
+    return true;
+}
+
+double sidcatalog::filesPerSecond() const
+{
+    return m_time ? (m_entries.size() + m_failed) * 1e9 / m_time : 0.;
+}
+
+static uint32_t addString(std::vector<char> &strings, const std::string &str)
+{
+    const uint32_t offset = strings.size();
+    strings.insert(strings.end(), str.begin(), str.end());
+    strings.push_back('\0');
+    return offset;
+}
+
+static int hexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return 0;
+}
+
+template<class T>
+static void writeColumn(std::ofstream &out, const std::vector<T> &column)
+{
+    if (!column.empty())
+        out.write(reinterpret_cast<const char*>(&column[0]), column.size() * sizeof(T));
+}
+
+bool sidcatalog::write(const char *filename)
+{
+    const size_t count = m_entries.size();
+
+    std::vector<uint8_t> md5(count * DIGEST_LENGTH);
+    std::vector<uint32_t> offsets(count * 4);
+    std::vector<uint32_t> first(count);
+    std::vector<int32_t> lengths;
+    std::vector<uint16_t> words(count * 6);
+    std::vector<uint8_t> bytes(count * 5);
+    std::vector<char> strings;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const entry &e = m_entries[i];
+
+        for (unsigned int b = 0; b < DIGEST_LENGTH; b++)
+            md5[i * DIGEST_LENGTH + b] = (hexValue(e.md5[b * 2]) << 4) | hexValue(e.md5[b * 2 + 1]);
+
+        offsets[i] = addString(strings, e.path);
+        offsets[count + i] = addString(strings, e.title);
+        offsets[count * 2 + i] = addString(strings, e.author);
+        offsets[count * 3 + i] = addString(strings, e.released);
+
+        first[i] = lengths.size();
+        lengths.insert(lengths.end(), e.lengths.begin(), e.lengths.end());
+
+        words[i] = e.loadAddr;
+        words[count + i] = e.initAddr;
+        words[count * 2 + i] = e.playAddr;
+        words[count * 3 + i] = e.sidChipBase2;
+        words[count * 4 + i] = e.songs;
+        words[count * 5 + i] = e.startSong;
+
+        bytes[i] = e.compatibility;
+        bytes[count + i] = e.clockSpeed;
+        bytes[count * 2 + i] = e.sidModel1;
+        bytes[count * 3 + i] = e.sidModel2;
+        bytes[count * 4 + i] = e.flags;
+    }
+
+    header_t header;
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = FORMAT_VERSION;
+    header.count = count;
+    header.lengths = lengths.size();
+    header.strings = strings.size();
+
+    // Write to a temporary file and rename it so that
+    // readers never see a partial catalog.
+    const std::string tmpPath = std::string(filename) + ".tmp";
+
+    {
+        std::ofstream out(tmpPath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header_t));
+        writeColumn(out, md5);
+        writeColumn(out, offsets);
+        writeColumn(out, first);
+        writeColumn(out, lengths);
+        writeColumn(out, words);
+        writeColumn(out, bytes);
+        writeColumn(out, strings);
+
+        if (!out.good())
+        {
+            out.close();
+            std::remove(tmpPath.c_str());
+            errorString = ERR_UNABLE_TO_WRITE;
+            return false;
+        }
+    }
+
+    if (std::rename(tmpPath.c_str(), filename) != 0)
+    {
+        // Rename doesn't replace existing files everywhere
+        std::remove(filename);
+        if (std::rename(tmpPath.c_str(), filename) != 0)
+        {
+            std::remove(tmpPath.c_str());
+            errorString = ERR_UNABLE_TO_WRITE;
+            return false;
+        }
+    }
+
+    errorString = ERR_NO_ERROR;
+    return true;
+}
+
+bool sidcatalog::open(const char *filename)
+{
+    std::ifstream in(filename, std::ios::in | std::ios::binary);
+    if (!in.is_open())
+    {
+        errorString = ERR_UNABLE_TO_READ;
+        return false;
+    }
+
+    in.seekg(0, std::ios::end);
+    const std::streamoff size = in.tellg();
+    in.seekg(0, std::ios::beg);
+
+    if (size < (std::streamoff)sizeof(header_t))
+    {
+        errorString = ERR_CATALOG_CORRUPT;
+        return false;
+    }
+
+    std::vector<uint32_t> buffer(((size_t)size + sizeof(uint32_t) - 1) / sizeof(uint32_t));
+    const char *data = reinterpret_cast<const char*>(&buffer[0]);
+    if (!in.read(reinterpret_cast<char*>(&buffer[0]), size))
+    {
+        errorString = ERR_UNABLE_TO_READ;
+        return false;
+    }
+
+    header_t header;
+    memcpy(&header, data, sizeof(header_t));
+
+    const uint64_t count = header.count;
+    const uint64_t expected = sizeof(header_t)
+        + count * (DIGEST_LENGTH + 5 * sizeof(uint32_t) + 6 * sizeof(uint16_t) + 5)
+        + (uint64_t)header.lengths * sizeof(int32_t)
+        + header.strings;
+
+    if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0
+        || header.version != FORMAT_VERSION
+        || expected != (uint64_t)size
+        || (header.strings != 0 && data[size - 1] != '\0'))
+    {
+        errorString = ERR_CATALOG_CORRUPT;
+        return false;
+    }
+
+    const uint8_t *md5 = reinterpret_cast<const uint8_t*>(data + sizeof(header_t));
+    const uint32_t *offsets = reinterpret_cast<const uint32_t*>(md5 + count * DIGEST_LENGTH);
+    const uint32_t *first = offsets + count * 4;
+    const int32_t *lengths = reinterpret_cast<const int32_t*>(first + count);
+    const uint16_t *words = reinterpret_cast<const uint16_t*>(lengths + header.lengths);
+    const uint8_t *bytes = reinterpret_cast<const uint8_t*>(words + count * 6);
+    const char *strings = reinterpret_cast<const char*>(bytes + count * 5);
+
+    std::vector<entry> entries(header.count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        entry &e = entries[i];
+
+        for (unsigned int b = 0; b < DIGEST_LENGTH; b++)
+            sprintf(e.md5 + b * 2, "%02x", md5[i * DIGEST_LENGTH + b]);
+
+        for (unsigned int s = 0; s < 4; s++)
+        {
+            if (offsets[count * s + i] >= header.strings)
+            {
+                errorString = ERR_CATALOG_CORRUPT;
+                return false;
+            }
+        }
+
+        e.path = strings + offsets[i];
+        e.title = strings + offsets[count + i];
+        e.author = strings + offsets[count * 2 + i];
+        e.released = strings + offsets[count * 3 + i];
+
+        e.loadAddr = words[i];
+        e.initAddr = words[count + i];
+        e.playAddr = words[count * 2 + i];
+        e.sidChipBase2 = words[count * 3 + i];
+        e.songs = words[count * 4 + i];
+        e.startSong = words[count * 5 + i];
+
+        if (first[i] > header.lengths || e.songs > header.lengths - first[i])
+        {
+            errorString = ERR_CATALOG_CORRUPT;
+            return false;
+        }
+
+        e.lengths.assign(lengths + first[i], lengths + first[i] + e.songs);
+
+        e.compatibility = (SidTuneInfo::compatibility_t)bytes[i];
+        e.clockSpeed = (SidTuneInfo::clock_t)bytes[count + i];
+        e.sidModel1 = (SidTuneInfo::model_t)bytes[count * 2 + i];
+        e.sidModel2 = (SidTuneInfo::model_t)bytes[count * 3 + i];
+        e.flags = bytes[count * 4 + i];
+    }
+
+    m_entries.swap(entries);
+    m_failed = 0;
+    m_time = 0;
+    errorString = ERR_NO_ERROR;
+    return true;
+}
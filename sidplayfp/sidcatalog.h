@@ -0,0 +1,218 @@
+/*
+ * This file is part of libsidplayfp, a SID player engine.
+ *
+ *  Copyright 2014 Leandro Nini <drfiemost@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef SIDCATALOG_H
+#define SIDCATALOG_H
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "sidplayfp/siddefs.h"
+#include "sidplayfp/SidTune.h"
+#include "sidplayfp/SidTuneInfo.h"
+
+class SidDatabase;
+
+/**
+ * Metadata of a collection of tunes, such as HVSC.
+ *
+ * The tunes under a directory are loaded by a pool of worker
+ * threads, straight from memory buffers and without placing them
+ * in C64 memory, to collect their header fields and MD5.
+ * Song lengths come from a SidDatabase and STIL presence
+ * from a user supplied check.
+ *
+ * The catalog is stored by columns, each field of all the tunes
+ * together, with the strings in a shared pool.
+ * It is stored in native byte order.
+ */
+class SID_EXTERN sidcatalog
+{
+public:
+    /// Version of the catalog format.
+    static const uint32_t FORMAT_VERSION = 1;
+
+    /// Flags of an entry.
+    enum
+    {
+        HAS_STIL = 1 << 0,  ///< The tune has a STIL entry
+        HAS_BUG  = 1 << 1   ///< The tune has a BUGlist entry
+    };
+
+    /**
+     * Check the STIL of a tune.
+     * Called from the worker threads.
+     *
+     * @param path the path of the tune relative to the scanned
+     *        directory, starting with a slash
+     * @param data the user data passed to #setStilCheck
+     * @return the HAS_STIL and HAS_BUG flags
+     */
+    typedef unsigned int (*stil_check_t)(const char *path, void *data);
+
+    /**
+     * The metadata of a tune.
+     */
+    class entry
+    {
+    public:
+        /// Path relative to the scanned directory, with slashes.
+        std::string path;
+
+        char md5[SidTune::MD5_LENGTH + 1];
+
+        std::string title;
+        std::string author;
+        std::string released;
+
+        uint_least16_t loadAddr;
+        uint_least16_t initAddr;
+        uint_least16_t playAddr;
+        uint_least16_t sidChipBase2;
+
+        unsigned int songs;
+        unsigned int startSong;
+
+        SidTuneInfo::compatibility_t compatibility;
+        SidTuneInfo::clock_t clockSpeed;
+        SidTuneInfo::model_t sidModel1;
+        SidTuneInfo::model_t sidModel2;
+
+        unsigned int flags;
+
+        /// Length of each song in milliseconds, -1 if unknown.
+        std::vector<int_least32_t> lengths;
+
+    public:
+        entry() { md5[0] = '\0'; }
+    };
+
+private:
+    class worker;
+
+    struct header_t;
+
+private:
+    const unsigned int m_threads;
+
+    SidDatabase *m_database;
+
+    stil_check_t m_stilCheck;
+    void *m_stilData;
+
+    std::vector<entry> m_entries;
+
+    unsigned int m_failed;
+    uint_least64_t m_time;
+
+    const char *errorString;
+
+private:
+    static bool listFiles(const std::string &dir, const std::string &relPath,
+                          std::vector<std::string> &files);
+
+    // prevent copying
+    sidcatalog(const sidcatalog&);
+    sidcatalog& operator=(const sidcatalog&);
+
+public:
+    /**
+     * @param threads the number of worker threads, 0 scans in the calling thread
+     */
+    sidcatalog(unsigned int threads);
+
+    /**
+     * Set the songlength database used by #scan.
+     * The database is only used from the calling thread.
+     *
+     * @param database the database, 0 to leave the lengths unknown
+     */
+    void setDatabase(SidDatabase *database) { m_database = database; }
+
+    /**
+     * Set the STIL check used by #scan.
+     *
+     * @param check the function, 0 to leave the flags clear
+     * @param data user data for the function
+     */
+    void setStilCheck(stil_check_t check, void *data) { m_stilCheck = check; m_stilData = data; }
+
+    /**
+     * Scan the files ending in .sid under a directory
+     * and replace the contents of the catalog.
+     * Files that can't be loaded are counted and left out.
+     *
+     * @param root the directory
+     * @return false if the directory can't be read
+     */
+    bool scan(const char *root);
+
+    /**
+     * Write the catalog.
+     *
+     * @param filename the catalog file to write.
+     * @return false in case of errors, true otherwise.
+     */
+    bool write(const char *filename);
+
+    /**
+     * Read a catalog written by #write,
+     * replacing the contents of this one.
+     *
+     * @param filename the catalog file to read.
+     * @return false in case of errors, true otherwise.
+     */
+    bool open(const char *filename);
+
+    /**
+     * Get the number of tunes.
+     */
+    unsigned int size() const { return m_entries.size(); }
+
+    /**
+     * Get the metadata of a tune, sorted by path.
+     */
+    const entry &operator[](unsigned int i) const { return m_entries[i]; }
+
+    /**
+     * Get the number of files the last scan failed to load.
+     */
+    unsigned int failed() const { return m_failed; }
+
+    /**
+     * Get the duration of the last scan in seconds.
+     */
+    double seconds() const { return m_time / 1e9; }
+
+    /**
+     * Get the throughput of the last scan in files per second,
+     * counting the failed ones too.
+     */
+    double filesPerSecond() const;
+
+    /**
+     * Get the description of the last error.
+     */
+    const char *error() const { return errorString; }
+};
+
+#endif // SIDCATALOG_H
@@ -0,0 +1,431 @@
+/*
+ * This file is part of libsidplayfp, a SID player engine.
+ *
+ *  Copyright 2014 Leandro Nini <drfiemost@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "sidcheckpoints.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#include "sidplayfp.h"
+#include "SidConfig.h"
+#include "SidTune.h"
+#include "SidTuneInfo.h"
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#ifdef HAVE_SYS_MMAN_H
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#endif
+
+const char ERR_NOT_OPEN[]     = "SIDCHECKPOINTS ERROR: No index open.";
+const char ERR_CANT_READ[]    = "SIDCHECKPOINTS ERROR: Unable to read the index.";
+const char ERR_CANT_WRITE[]   = "SIDCHECKPOINTS ERROR: Unable to write the index.";
+const char ERR_CORRUPT[]      = "SIDCHECKPOINTS ERROR: Index seems to be corrupt or from a different version.";
+const char ERR_NO_MD5[]       = "SIDCHECKPOINTS ERROR: Tune has no MD5.";
+const char ERR_BAD_INTERVAL[] = "SIDCHECKPOINTS ERROR: Invalid checkpoint interval.";
+const char ERR_CONFIG[]       = "SIDCHECKPOINTS ERROR: Engine configuration doesn't match the index.";
+const char ERR_STOPPED[]      = "SIDCHECKPOINTS ERROR: Engine stopped.";
+
+static const char MAGIC[8] = { 'S', 'I', 'D', 'C', 'K', 'P', 'T', 0 };
+
+/// Samples played per call while rendering.
+static const uint_least32_t BUFFERSIZE = 4096;
+
+/**
+ * File header, stored in native byte order as the states are.
+ */
+struct sidcheckpoints::header_t
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t song;
+    char md5[SidTune::MD5_LENGTH];
+    uint32_t frequency;
+    uint32_t channels;
+    uint32_t interval;
+    uint32_t count;
+};
+
+/**
+ * Entry of the checkpoint table that follows the header.
+ */
+struct sidcheckpoints::entry_t
+{
+    /// Samples played before the checkpoint.
+    uint64_t position;
+
+    /// Location of the state in the file, aligned to 8 bytes.
+    uint64_t offset;
+    uint64_t size;
+
+    /// FNV-1a hash of the state, checked before restoring it.
+    uint32_t checksum;
+    uint32_t reserved;
+};
+
+/**
+ * FNV-1a hash of a saved state.
+ */
+static uint32_t checksum(const uint8_t *data, size_t size)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++)
+        hash = (hash ^ data[i]) * 16777619u;
+    return hash;
+}
+
+/**
+ * Number of samples played in the given time.
+ */
+static uint64_t samples(uint_least32_t ms, uint32_t frequency, uint32_t channels)
+{
+    return (uint64_t)ms * frequency / 1000 * channels;
+}
+
+/**
+ * Play and throw away samples until the position is reached.
+ */
+static bool playTo(sidplayfp &engine, uint64_t position, uint64_t target)
+{
+    const uint32_t channels = engine.config().playback;
+
+    std::vector<short> buffer(BUFFERSIZE * channels);
+
+    while (position < target)
+    {
+        const uint64_t left = target - position;
+        const uint_least32_t count = (left < buffer.size()) ? (uint_least32_t)left : (uint_least32_t)buffer.size();
+
+        const uint_least32_t played = engine.play(&buffer[0], count);
+        if (played == 0)
+            return false;
+
+        position += played;
+    }
+
+    return true;
+}
+
+sidcheckpoints::sidcheckpoints() :
+    m_data(0),
+    m_size(0),
+    m_mapped(false),
+    m_errorString(ERR_NOT_OPEN) {}
+
+sidcheckpoints::~sidcheckpoints()
+{
+    close();
+}
+
+const sidcheckpoints::header_t *sidcheckpoints::header() const
+{
+    return reinterpret_cast<const header_t*>(m_data);
+}
+
+const sidcheckpoints::entry_t *sidcheckpoints::entries() const
+{
+    return reinterpret_cast<const entry_t*>(m_data + sizeof(header_t));
+}
+
+bool sidcheckpoints::create(sidplayfp &engine, SidTune &tune, uint_least32_t length,
+                            uint_least32_t interval, const char *filename)
+{
+    if (interval == 0)
+    {
+        m_errorString = ERR_BAD_INTERVAL;
+        return false;
+    }
+
+    char md5[SidTune::MD5_LENGTH + 1];
+    if (!tune.createMD5(md5))
+    {
+        m_errorString = ERR_NO_MD5;
+        return false;
+    }
+
+    if (!engine.load(&tune))
+    {
+        m_errorString = engine.error();
+        return false;
+    }
+
+    header_t header;
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = FORMAT_VERSION;
+    header.song = tune.getInfo()->currentSong();
+    memcpy(header.md5, md5, SidTune::MD5_LENGTH);
+    header.frequency = engine.config().frequency;
+    header.channels = engine.config().playback;
+    header.interval = interval;
+    header.count = (length > interval) ? (length + interval - 1) / interval : 1;
+
+    std::vector<entry_t> table(header.count);
+    std::vector<uint8_t> state;
+
+    // Write to a temporary file and rename it so that
+    // readers never see a partial index.
+    const std::string tmpPath = std::string(filename) + ".tmp";
+
+    {
+        std::ofstream out(tmpPath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header_t));
+        out.write(reinterpret_cast<const char*>(&table[0]), table.size() * sizeof(entry_t));
+
+        uint64_t offset = sizeof(header_t) + table.size() * sizeof(entry_t);
+        uint64_t position = 0;
+
+        for (unsigned int i = 0; i < header.count && out.good(); i++)
+        {
+            const uint64_t target = samples(i * interval, header.frequency, header.channels);
+            if (!playTo(engine, position, target))
+            {
+                out.close();
+                std::remove(tmpPath.c_str());
+                m_errorString = ERR_STOPPED;
+                return false;
+            }
+            position = target;
+
+            if (!engine.snapshot(state))
+            {
+                out.close();
+                std::remove(tmpPath.c_str());
+                m_errorString = engine.error();
+                return false;
+            }
+
+            table[i].position = position;
+            table[i].offset = offset;
+            table[i].size = state.size();
+            table[i].checksum = checksum(&state[0], state.size());
+            table[i].reserved = 0;
+
+            static const char padding[8] = { 0 };
+            const size_t pad = (8 - (state.size() & 7)) & 7;
+
+            out.write(reinterpret_cast<const char*>(&state[0]), state.size());
+            out.write(padding, pad);
+            offset += state.size() + pad;
+        }
+
+        out.seekp(sizeof(header_t));
+        out.write(reinterpret_cast<const char*>(&table[0]), table.size() * sizeof(entry_t));
+
+        if (!out.good())
+        {
+            out.close();
+            std::remove(tmpPath.c_str());
+            m_errorString = ERR_CANT_WRITE;
+            return false;
+        }
+    }
+
+    if (std::rename(tmpPath.c_str(), filename) != 0)
+    {
+        // Rename doesn't replace existing files everywhere
+        std::remove(filename);
+        if (std::rename(tmpPath.c_str(), filename) != 0)
+        {
+            std::remove(tmpPath.c_str());
+            m_errorString = ERR_CANT_WRITE;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool sidcheckpoints::open(const char *filename)
+{
+    close();
+
+#ifdef HAVE_SYS_MMAN_H
+    const int fd = ::open(filename, O_RDONLY);
+    if (fd < 0)
+    {
+        m_errorString = ERR_CANT_READ;
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(header_t))
+    {
+        ::close(fd);
+        m_errorString = ERR_CORRUPT;
+        return false;
+    }
+
+    // Pages are loaded on demand and shared with other processes
+    void *map = mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    if (map == MAP_FAILED)
+    {
+        m_errorString = ERR_CANT_READ;
+        return false;
+    }
+
+    m_data = static_cast<const uint8_t*>(map);
+    m_size = st.st_size;
+    m_mapped = true;
+#else
+    std::ifstream in(filename, std::ios::in | std::ios::binary);
+    if (!in.is_open())
+    {
+        m_errorString = ERR_CANT_READ;
+        return false;
+    }
+
+    in.seekg(0, std::ios::end);
+    const std::streamoff size = in.tellg();
+    in.seekg(0, std::ios::beg);
+
+    if (size < (std::streamoff)sizeof(header_t))
+    {
+        m_errorString = ERR_CORRUPT;
+        return false;
+    }
+
+    m_buffer.resize((size_t)size);
+    if (!in.read(reinterpret_cast<char*>(&m_buffer[0]), size))
+    {
+        m_buffer.clear();
+        m_errorString = ERR_CANT_READ;
+        return false;
+    }
+
+    m_data = &m_buffer[0];
+    m_size = m_buffer.size();
+#endif
+
+    // Check the header and that the table and the states fit in the file
+    const header_t *h = header();
+    bool valid = memcmp(h->magic, MAGIC, sizeof(MAGIC)) == 0
+        && h->version == FORMAT_VERSION
+        && h->count > 0
+        && h->interval > 0
+        && h->count <= (m_size - sizeof(header_t)) / sizeof(entry_t);
+
+    for (unsigned int i = 0; valid && i < h->count; i++)
+    {
+        const entry_t &e = entries()[i];
+        valid = e.offset >= sizeof(header_t) + h->count * sizeof(entry_t)
+            && e.offset <= m_size
+            && e.size <= m_size - e.offset;
+    }
+
+    if (!valid)
+    {
+        close();
+        m_errorString = ERR_CORRUPT;
+        return false;
+    }
+
+    return true;
+}
+
+void sidcheckpoints::close()
+{
+    if (m_mapped)
+    {
+#ifdef HAVE_SYS_MMAN_H
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+    }
+
+    m_buffer.clear();
+    m_data = 0;
+    m_size = 0;
+    m_mapped = false;
+    m_errorString = ERR_NOT_OPEN;
+}
+
+bool sidcheckpoints::seek(sidplayfp &engine, uint_least32_t ms)
+{
+    if (!m_data)
+    {
+        m_errorString = ERR_NOT_OPEN;
+        return false;
+    }
+
+    const header_t *h = header();
+
+    if (engine.config().frequency != h->frequency
+        || (uint32_t)engine.config().playback != h->channels)
+    {
+        m_errorString = ERR_CONFIG;
+        return false;
+    }
+
+    unsigned int i = ms / h->interval;
+    if (i >= h->count)
+        i = h->count - 1;
+
+    const entry_t &e = entries()[i];
+
+    // The states are restored into the engine, don't trust damaged ones
+    if (checksum(m_data + e.offset, (size_t)e.size) != e.checksum)
+    {
+        m_errorString = ERR_CORRUPT;
+        return false;
+    }
+
+    if (!engine.restore(m_data + e.offset, (size_t)e.size))
+    {
+        m_errorString = engine.error();
+        return false;
+    }
+
+    if (!playTo(engine, e.position, samples(ms, h->frequency, h->channels)))
+    {
+        m_errorString = ERR_STOPPED;
+        return false;
+    }
+
+    return true;
+}
+
+const char *sidcheckpoints::md5() const
+{
+    return m_data ? header()->md5 : 0;
+}
+
+unsigned int sidcheckpoints::song() const
+{
+    return m_data ? header()->song : 0;
+}
+
+uint_least32_t sidcheckpoints::interval() const
+{
+    return m_data ? header()->interval : 0;
+}
+
+unsigned int sidcheckpoints::count() const
+{
+    return m_data ? header()->count : 0;
+}
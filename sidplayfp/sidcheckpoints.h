@@ -0,0 +1,151 @@
+/*
+ * This file is part of libsidplayfp, a SID player engine.
+ *
+ *  Copyright 2014 Leandro Nini <drfiemost@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef SIDCHECKPOINTS_H
+#define SIDCHECKPOINTS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <vector>
+
+#include "sidplayfp/siddefs.h"
+
+class SidTune;
+class sidplayfp;
+
+/**
+ * Index of emulator checkpoints for a song.
+ *
+ * The song is rendered once and the state of the engine is saved
+ * at regular intervals into a sidecar file, so that a position can
+ * later be reached by restoring the previous checkpoint and playing
+ * at most one interval, instead of playing from the start.
+ * The output after a seek is the same as playing straight through.
+ *
+ * The file starts with a fixed header holding the MD5 of the tune
+ * and the song, followed by a table of the checkpoints and the
+ * saved states. Each entry holds a checksum of its state, which is
+ * verified before the state is restored. Where available the file
+ * is memory mapped and the states are restored in place.
+ * Like the states, the file is only valid for the same build of the
+ * library and the same engine configuration.
+ */
+class SID_EXTERN sidcheckpoints
+{
+public:
+    /// Version of the file format.
+    static const uint32_t FORMAT_VERSION = 2;
+
+private:
+    struct header_t;
+    struct entry_t;
+
+private:
+    /// The whole file, mapped or read in memory.
+    const uint8_t *m_data;
+    size_t m_size;
+    bool m_mapped;
+
+    std::vector<uint8_t> m_buffer;
+
+    const char *m_errorString;
+
+private:
+    const header_t *header() const;
+    const entry_t *entries() const;
+
+    // prevent copying
+    sidcheckpoints(const sidcheckpoints&);
+    sidcheckpoints& operator=(const sidcheckpoints&);
+
+public:
+    sidcheckpoints();
+    ~sidcheckpoints();
+
+    /**
+     * Render the selected song of a tune and write its checkpoints.
+     * The tune is loaded into the engine, which must already be
+     * configured as it will be for playback.
+     *
+     * @param engine the engine to render with
+     * @param tune the tune, with the song to render selected
+     * @param length how long to render, in milliseconds
+     * @param interval time between checkpoints, in milliseconds
+     * @param filename the index file to write
+     * @return false in case of errors
+     */
+    bool create(sidplayfp &engine, SidTune &tune, uint_least32_t length,
+                uint_least32_t interval, const char *filename);
+
+    /**
+     * Open an index file.
+     *
+     * @param filename the index file
+     * @return false if the file can't be read or isn't a valid index
+     */
+    bool open(const char *filename);
+
+    /**
+     * Close the index file.
+     */
+    void close();
+
+    /**
+     * Move the engine to the given position in the song.
+     * The engine must have the song of the index loaded with the
+     * configuration used to create it. Samples are played from the
+     * checkpoint to the position, as 16 bit samples.
+     *
+     * @param engine the engine
+     * @param ms the position from the start of the song in milliseconds
+     * @return false if the index doesn't match the engine
+     */
+    bool seek(sidplayfp &engine, uint_least32_t ms);
+
+    /**
+     * Get the MD5 of the indexed tune, not terminated.
+     *
+     * @return the MD5, #SidTune::MD5_LENGTH characters, 0 if no index is open
+     */
+    const char *md5() const;
+
+    /**
+     * Get the indexed song.
+     */
+    unsigned int song() const;
+
+    /**
+     * Get the time between checkpoints in milliseconds.
+     */
+    uint_least32_t interval() const;
+
+    /**
+     * Get the number of checkpoints.
+     */
+    unsigned int count() const;
+
+    /**
+     * Get descriptive error message.
+     */
+    const char *error() const { return m_errorString; }
+};
+
+#endif // SIDCHECKPOINTS_H
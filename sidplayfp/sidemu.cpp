@@ -22,7 +22,10 @@
 
 #include "sidemu.h"
 
+#include "sidstate.h"
+
 std::string sidemu::m_credit;
+sidmutex sidemu::m_creditMutex;
 
 const char sidemu::ERR_UNSUPPORTED_FREQ[] = "Unable to set desired output frequency.";
 const char sidemu::ERR_INVALID_SAMPLING[] = "Invalid sampling method.";
@@ -44,3 +47,31 @@ void sidemu::unlock()
     m_locked  = false;
     m_context = 0;
 }
+
+bool sidemu::serialize(sidstate &s)
+{
+    if (!serializeChip(s))
+        return false;
+
+    s.io(m_accessClk);
+    s.io(m_bufferpos);
+
+    if (m_bufferpos < 0 || m_bufferpos > OUTPUTBUFFERSIZE || (m_bufferpos && !m_buffer))
+    {
+        s.fail();
+        return false;
+    }
+
+    if (m_bufferpos)
+        s.io(m_buffer, m_bufferpos);
+
+    s.tag(m_stemBuffer != 0);
+
+    if (m_bufferpos && m_stemBuffer)
+    {
+        for (unsigned int voice = 0; voice < 3; voice++)
+            s.io(stemBuffer(voice), m_bufferpos);
+    }
+
+    return !s.failed();
+}
@@ -28,10 +28,12 @@
 #include "SidConfig.h"
 #include "siddefs.h"
 #include "event.h"
+#include "sidthread.h"
 #include "c64/c64sid.h"
 
 class sidbuilder;
 class EventContext;
+class sidstate;
 
 /**
  * Inherit this class to create a new SID emulation.
@@ -53,6 +55,9 @@ private:
 protected:
     static std::string m_credit;
 
+    /// Guards the lazily built credits string
+    static sidmutex m_creditMutex;
+
 protected:
     static const char ERR_UNSUPPORTED_FREQ[];
     static const char ERR_INVALID_SAMPLING[];
@@ -63,22 +68,41 @@ protected:
 
     event_clock_t m_accessClk;
 
-    short *m_buffer;
+    /// Output samples, not clipped to 16 bits by every emulation
+    int *m_buffer;
     int m_bufferpos;
 
+    /// Output of each voice, OUTPUTBUFFERSIZE samples each, 0 without stems
+    int *m_stemBuffer;
+
     bool m_status;
     bool m_locked;
 
+    /// Clock without producing samples
+    bool m_silent;
+
     std::string m_error;
 
+protected:
+    /**
+     * Save or restore the state of the chip emulation.
+     * By default the state is not supported, as with hardware SIDs.
+     *
+     * @param s the state stream
+     * @return false if the state can't be saved or restored
+     */
+    virtual bool serializeChip(sidstate &s SID_UNUSED) { return false; }
+
 public:
     sidemu(sidbuilder *builder) :
         m_builder (builder),
         m_context(0),
         m_buffer(0),
         m_bufferpos(0),
+        m_stemBuffer(0),
         m_status(true),
         m_locked(false),
+        m_silent(false),
         m_error("N/A") {}
     virtual ~sidemu() {}
 
@@ -97,13 +121,49 @@ public:
     virtual void sampling(float systemfreq SID_UNUSED, float outputfreq SID_UNUSED,
         SidConfig::sampling_method_t method SID_UNUSED, bool fast SID_UNUSED) {}
 
+    /**
+     * Render each voice to its own buffer along with the output,
+     * filling the stem buffers up to #bufferpos as the output one.
+     * By default only STEMS_OFF is supported.
+     *
+     * @param mode how the voices are rendered
+     * @return false if the emulation doesn't support the mode
+     */
+    virtual bool stems(SidConfig::stem_mode_t mode) { return mode == SidConfig::STEMS_OFF; }
+
+    /**
+     * Clock the emulation as fast as possible without producing samples,
+     * used for seeking.
+     * Emulations may skip anything that doesn't show in the SID registers,
+     * so the output needs a while to settle after switching back.
+     * Hardware SIDs ignore it.
+     */
+    void silent(bool enable) { m_silent = enable; }
+
+    /**
+     * Save or restore the state of the emulation,
+     * along with the samples not mixed yet.
+     *
+     * @param s the state stream
+     * @return false if the state can't be saved or restored
+     */
+    bool serialize(sidstate &s);
+
     const char *error() const { return m_error.c_str(); }
 
     sidbuilder *builder() const { return m_builder; }
 
     int bufferpos() const { return m_bufferpos; }
     void bufferpos(int pos) { m_bufferpos = pos; }
-    short *buffer() const { return m_buffer; }
+    int *buffer() const { return m_buffer; }
+
+    /**
+     * Get the stem buffer of a voice, 0 if stems are off.
+     */
+    int *stemBuffer(unsigned int voice) const { return m_stemBuffer ? m_stemBuffer + voice * OUTPUTBUFFERSIZE : 0; }
+
+    /// Get the clock the emulation has been brought up to
+    event_clock_t accessClk() const { return m_accessClk; }
 
     void poke(uint_least16_t address, uint8_t value) { write(address & 0x1f, value); }
     uint8_t peek(uint_least16_t address) { return read(address & 0x1f); }
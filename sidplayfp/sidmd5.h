@@ -85,7 +85,7 @@ public:
         const int len = 16;
         const int strLeng = (len << 1) + 1;
         
-        static char ss[strLeng];
+        char ss[strLeng];
         char* ss_temp = ss;
 
         for (int di = 0; di < len; ++di)
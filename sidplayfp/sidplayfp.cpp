@@ -56,11 +56,71 @@ void sidplayfp::stop()
     sidplayer.stop();
 }
 
+bool sidplayfp::playHardware(stopCallback callback, void *data)
+{
+    return sidplayer.playHardware(callback, data);
+}
+
+bool sidplayfp::start()
+{
+    return sidplayer.start();
+}
+
+void sidplayfp::wait()
+{
+    sidplayer.wait();
+}
+
 uint_least32_t sidplayfp::play(short *buffer, uint_least32_t count)
 {
     return sidplayer.play(buffer, count);
 }
 
+uint_least32_t sidplayfp::playInt32(int_least32_t *buffer, uint_least32_t count)
+{
+    return sidplayer.play(buffer, count);
+}
+
+uint_least32_t sidplayfp::playFloat(float *buffer, uint_least32_t count)
+{
+    return sidplayer.play(buffer, count);
+}
+
+uint_least32_t sidplayfp::play(short *buffer, uint_least32_t count, short **stems)
+{
+    return sidplayer.play(buffer, count, stems);
+}
+
+uint_least32_t sidplayfp::playInt32(int_least32_t *buffer, uint_least32_t count, int_least32_t **stems)
+{
+    return sidplayer.play(buffer, count, stems);
+}
+
+uint_least32_t sidplayfp::playFloat(float *buffer, uint_least32_t count, float **stems)
+{
+    return sidplayer.play(buffer, count, stems);
+}
+
+bool sidplayfp::seek(uint_least32_t ms)
+{
+    return sidplayer.seek(ms);
+}
+
+bool sidplayfp::snapshot(std::vector<uint8_t> &state)
+{
+    return sidplayer.snapshot(state);
+}
+
+bool sidplayfp::restore(const std::vector<uint8_t> &state)
+{
+    return sidplayer.restore(state.empty() ? 0 : &state[0], state.size());
+}
+
+bool sidplayfp::restore(const uint8_t *state, size_t size)
+{
+    return sidplayer.restore(state, size);
+}
+
 bool sidplayfp::load(SidTune *tune)
 {
     return sidplayer.load(tune);
@@ -71,6 +131,16 @@ const SidInfo &sidplayfp::info() const
     return sidplayer.info();
 }
 
+const SidStats &sidplayfp::stats() const
+{
+    return sidplayer.stats();
+}
+
+void sidplayfp::resetStats()
+{
+    sidplayer.resetStats();
+}
+
 uint_least32_t sidplayfp::time() const
 {
     return sidplayer.time();
@@ -91,6 +161,11 @@ void sidplayfp::mute(unsigned int sidNum, unsigned int voice, bool enable)
     sidplayer.mute(sidNum, voice, enable);
 }
 
+bool sidplayfp::pan(unsigned int sidNum, uint_least32_t left, uint_least32_t right)
+{
+    return sidplayer.pan(sidNum, left, right);
+}
+
 void sidplayfp::debug(bool enable, FILE *out)
 {
     sidplayer.debug(enable, out);
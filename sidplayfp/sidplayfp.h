@@ -26,12 +26,15 @@
 #include <stdint.h>
 #include <stdio.h>
 
+#include <vector>
+
 #include "sidplayfp/siddefs.h"
 #include "sidplayfp/sidversion.h"
 
 class  SidConfig;
 class  SidTune;
 class  SidInfo;
+class  SidStats;
 class  EventContext;
 
 // Private Sidplayer
@@ -66,6 +69,20 @@ public:
      */
     const SidInfo &info() const;
 
+    /**
+     * Get the emulation statistics collected since the last
+     * #resetStats, only available if the library is built
+     * with profiling enabled.
+     *
+     * @return a const reference to the statistics, valid until the next call.
+     */
+    const SidStats &stats() const;
+
+    /**
+     * Clear the emulation statistics.
+     */
+    void resetStats();
+
     /**
      * Configure the engine.
      * Check #error for detailed message if something goes wrong.
@@ -98,8 +115,57 @@ public:
      */
     bool load(SidTune *tune);
 
+    /**
+     * Move to the given position in the current song.
+     * The SID emulations are clocked without producing samples up to
+     * shortly before the position, so seeking is much faster than playing.
+     * Going back restarts the song. Hardware SIDs play through in real time.
+     * The output after a seek matches playing through to the same position
+     * within the dither on the 8580. On the 6581 it differs by up to
+     * 30-50 LSB for the first seconds, with either emulation, as the
+     * state left by silent clocking isn't exactly the one playing leaves.
+     *
+     * @param ms the position from the start of the song in milliseconds.
+     * @return false if no tune is loaded or the song can't be restarted.
+     */
+    bool seek(uint_least32_t ms);
+
+    /**
+     * Save the state of the emulation, so that playback can go on
+     * from this point later.
+     * The state holds the whole C64, the SID emulations and the
+     * samples not yet returned by #play. It can only be restored
+     * by the same version of the library, with the same tune, song
+     * and configuration. Hardware SIDs are not supported.
+     *
+     * @param state where to store the state, any previous content is dropped.
+     * @return false if no tune is loaded or the SID emulation doesn't support it.
+     */
+    bool snapshot(std::vector<uint8_t> &state);
+
+    /**
+     * Restore a state saved by #snapshot.
+     * If the state doesn't match, the song is restarted.
+     *
+     * @param state the saved state.
+     * @return false if no tune is loaded or the state doesn't match.
+     */
+    bool restore(const std::vector<uint8_t> &state);
+
+    /**
+     * Restore a state saved by #snapshot from memory,
+     * such as a memory mapped file.
+     *
+     * @param state the saved state.
+     * @param size the size of the state in bytes.
+     * @return false if no tune is loaded or the state doesn't match.
+     */
+    bool restore(const uint8_t *state, size_t size);
+
     /**
      * Produce samples to play.
+     * With a count of 0 the engine plays on hardware SIDs
+     * until #stop is called, as #playHardware without a callback.
      *
      * @param buffer pointer to the buffer to fill with samples.
      * @param count the size of the buffer measured in 16 bit samples.
@@ -107,6 +173,51 @@ public:
      */
     uint_least32_t play(short *buffer, uint_least32_t count);
 
+    /**
+     * Produce 32 bit integer samples to play.
+     * The samples are not dithered, 16 bit full scale maps to 32 bit full scale.
+     * Neither the mix nor the output of reSIDfp is clipped to 16 bit,
+     * the samples saturate only at 32 bit full scale.
+     *
+     * @param buffer pointer to the buffer to fill with samples.
+     * @param count the size of the buffer measured in samples.
+     * @return the number of produced samples.
+     */
+    uint_least32_t playInt32(int_least32_t *buffer, uint_least32_t count);
+
+    /**
+     * Produce floating point samples to play.
+     * The samples are not dithered, full scale is -1.0 to 1.0.
+     * Neither the mix nor the output of reSIDfp is clipped,
+     * so the samples may go past full scale.
+     * reSID still clips its own output to 16 bit before mixing.
+     *
+     * @param buffer pointer to the buffer to fill with samples.
+     * @param count the size of the buffer measured in samples.
+     * @return the number of produced samples.
+     */
+    uint_least32_t playFloat(float *buffer, uint_least32_t count);
+
+    /**
+     * Produce samples to play along with the stems,
+     * the output of each voice on its own, as set up by SidConfig::stemMode.
+     * The C64 is emulated once for the mix and all the stems.
+     * Each stem is mono at the volume of its SID and gets a sample
+     * for each frame of the output, so count / channels at most.
+     * The stems are left alone if stemMode is STEMS_OFF.
+     *
+     * @param buffer pointer to the buffer to fill with samples.
+     * @param count the size of the buffer measured in samples.
+     * @param stems three buffers for each SID, first the voices
+     *        of the first SID then the ones of the second.
+     * @return the number of produced samples.
+     */
+    //@{
+    uint_least32_t play(short *buffer, uint_least32_t count, short **stems);
+    uint_least32_t playInt32(int_least32_t *buffer, uint_least32_t count, int_least32_t **stems);
+    uint_least32_t playFloat(float *buffer, uint_least32_t count, float **stems);
+    //@}
+
     /**
      * Check if the engine is playing or stopped.
      *
@@ -117,6 +228,44 @@ public:
     /** Stop the engine. */
     void stop();
 
+    /**
+     * Polled during hardware playback.
+     *
+     * @param data the pointer passed along with the callback.
+     * @return true to stop playing.
+     */
+    typedef bool (*stopCallback)(void *data);
+
+    /**
+     * Play on hardware SIDs in the calling thread.
+     * Returns when #stop is called, from a signal handler or
+     * another thread, which restarts the song, or when the callback
+     * returns true, which pauses and a later call goes on from there.
+     * The callback is polled a few hundred times a second
+     * so it should be cheap.
+     *
+     * @param callback the stop callback, may be null.
+     * @param data passed to the callback.
+     * @return false if no tune is loaded or hardware playback
+     *         is already running.
+     */
+    bool playHardware(stopCallback callback = 0, void *data = 0);
+
+    /**
+     * Start playing on hardware SIDs in a dedicated thread.
+     * Until #wait returns only #stop, #isPlaying and #time may be called.
+     *
+     * @return false if no tune is loaded, hardware playback is already
+     *         running or threads are not supported on this platform.
+     */
+    bool start();
+
+    /**
+     * Wait for the playback thread to end after #stop.
+     * Returns immediately if no thread was started.
+     */
+    void wait();
+
     /**
      * Control debugging.
      * Only has effect if library have been compiled
@@ -136,6 +285,20 @@ public:
      */
     void mute(unsigned int sidNum, unsigned int voice, bool enable);
 
+    /**
+     * Set how much of a SID goes to each output channel,
+     * from 0 to SidConfig's maximum volume.
+     * By default in mono the SIDs are averaged, in stereo the first
+     * goes left and the second right.
+     * The setting lasts until the SIDs are set up again by #config or #load.
+     *
+     * @param sidNum the SID chip, 0 for the first one, 1 for the second.
+     * @param left share of the left channel, or of the mono one.
+     * @param right share of the right channel, unused in mono.
+     * @return false if the SID doesn't exist or the values are out of range.
+     */
+    bool pan(unsigned int sidNum, uint_least32_t left, uint_least32_t right);
+
     /**
      * Get the current playing time with respect to resolution returned by timebase.
      *
@@ -0,0 +1,78 @@
+/*
+ * This file is part of libsidplayfp, a SID player engine.
+ *
+ *  Copyright 2014 Leandro Nini <drfiemost@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef SIDPROFILE_H
+#define SIDPROFILE_H
+
+#include <stdint.h>
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#ifdef SIDPLAYFP_PROFILING
+#  ifdef _WIN32
+#    include <windows.h>
+#  else
+#    include <time.h>
+#  endif
+#endif
+
+/**
+ * Support for the emulation statistics.
+ *
+ * The counters are only updated when built with --enable-profiling,
+ * otherwise the checks on #enabled are compiled out.
+ */
+namespace sidprofile
+{
+
+#ifdef SIDPLAYFP_PROFILING
+const bool enabled = true;
+#else
+const bool enabled = false;
+#endif
+
+/**
+ * Get a monotonic time stamp.
+ *
+ * @return the time in nanoseconds, 0 if profiling is disabled
+ */
+inline uint_least64_t now()
+{
+#ifdef SIDPLAYFP_PROFILING
+#  ifdef _WIN32
+    LARGE_INTEGER count, frequency;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&frequency);
+    return (uint_least64_t)(count.QuadPart * (1000000000. / frequency.QuadPart));
+#  else
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint_least64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#  endif
+#else
+    return 0;
+#endif
+}
+
+}
+
+#endif // SIDPROFILE_H
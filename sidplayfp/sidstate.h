@@ -0,0 +1,157 @@
+/*
+ * This file is part of libsidplayfp, a SID player engine.
+ *
+ *  Copyright 2014 Leandro Nini <drfiemost@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef SIDSTATE_H
+#define SIDSTATE_H
+
+#include <stdint.h>
+#include <cstring>
+#include <vector>
+
+/**
+ * Binary stream for the emulation state.
+ *
+ * Components save and restore their state in a single
+ * serialize() method, the direction depends on the stream,
+ * so the two can't get out of step.
+ * Values are stored as they are laid out in memory,
+ * a state can only be restored by the same build of the library.
+ */
+class sidstate
+{
+private:
+    std::vector<uint8_t> *m_out;
+
+    const uint8_t *m_in;
+    size_t m_size;
+    size_t m_pos;
+
+    bool m_failed;
+
+private:
+    void raw(void *data, size_t length)
+    {
+        if (m_out)
+        {
+            const uint8_t *p = static_cast<const uint8_t*>(data);
+            m_out->insert(m_out->end(), p, p + length);
+        }
+        else if (!m_failed && length <= m_size - m_pos)
+        {
+            memcpy(data, m_in + m_pos, length);
+            m_pos += length;
+        }
+        else
+        {
+            m_failed = true;
+        }
+    }
+
+public:
+    /**
+     * Create a stream saving the state at the end of data.
+     */
+    explicit sidstate(std::vector<uint8_t> &data) :
+        m_out(&data),
+        m_in(0),
+        m_size(0),
+        m_pos(0),
+        m_failed(false) {}
+
+    /**
+     * Create a stream restoring the state from data.
+     */
+    sidstate(const uint8_t *data, size_t size) :
+        m_out(0),
+        m_in(data),
+        m_size(size),
+        m_pos(0),
+        m_failed(false) {}
+
+    /**
+     * Check whether the state is being saved or restored.
+     */
+    bool saving() const { return m_out != 0; }
+
+    /**
+     * Save or restore a value.
+     * When restoring past the end of the data
+     * the value is left alone and the stream fails.
+     */
+    template<typename T>
+    void io(T &value) { raw(&value, sizeof(T)); }
+
+    /**
+     * Save or restore an array of values.
+     */
+    template<typename T>
+    void io(T *values, size_t count) { raw(values, sizeof(T) * count); }
+
+    /**
+     * Save or restore a block of data of variable length.
+     */
+    void io(std::vector<uint8_t> &data)
+    {
+        uint32_t size = (uint32_t)data.size();
+        io(size);
+
+        if (!saving())
+        {
+            if (m_failed || size > m_size - m_pos)
+            {
+                m_failed = true;
+                return;
+            }
+            data.resize(size);
+        }
+
+        if (size)
+            raw(&data[0], size);
+    }
+
+    /**
+     * Check a marker, so that restoring data saved
+     * in a different layout fails early.
+     */
+    void tag(uint32_t id)
+    {
+        uint32_t value = id;
+        io(value);
+        if (value != id)
+            m_failed = true;
+    }
+
+    /**
+     * Mark the data as invalid.
+     */
+    void fail() { m_failed = true; }
+
+    /**
+     * Check whether restoring has run into invalid data.
+     */
+    bool failed() const { return m_failed; }
+
+    /**
+     * Check whether all the data has been restored successfully.
+     */
+    bool done() const { return !m_failed && (m_out || m_pos == m_size); }
+};
+
+#endif
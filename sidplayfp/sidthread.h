@@ -0,0 +1,233 @@
+/*
+ * This file is part of libsidplayfp, a SID player engine.
+ *
+ *  Copyright 2014 Leandro Nini <drfiemost@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef SIDTHREAD_H
+#define SIDTHREAD_H
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#if defined(_WIN32)
+#  include <windows.h>
+#elif defined(HAVE_PTHREAD_H)
+#  include <pthread.h>
+#  include <unistd.h>
+#  include <time.h>
+#else
+#  include <ctime>
+#endif
+
+#include <stdint.h>
+
+/**
+ * Minimal portable threading support.
+ *
+ * Uses Win32 threads on Windows and pthreads where available.
+ * On other platforms, i.e. DOS, threads can't be started
+ * and mutexes do nothing.
+ */
+
+/**
+ * Mutual exclusion lock.
+ */
+class sidmutex
+{
+private:
+#if defined(_WIN32)
+    CRITICAL_SECTION m_mutex;
+#elif defined(HAVE_PTHREAD_H)
+    pthread_mutex_t m_mutex;
+#endif
+
+private:
+    // prevent copying
+    sidmutex(const sidmutex&);
+    sidmutex& operator=(const sidmutex&);
+
+public:
+#if defined(_WIN32)
+    sidmutex() { InitializeCriticalSection(&m_mutex); }
+    ~sidmutex() { DeleteCriticalSection(&m_mutex); }
+
+    void lock() { EnterCriticalSection(&m_mutex); }
+    void unlock() { LeaveCriticalSection(&m_mutex); }
+#elif defined(HAVE_PTHREAD_H)
+    sidmutex() { pthread_mutex_init(&m_mutex, 0); }
+    ~sidmutex() { pthread_mutex_destroy(&m_mutex); }
+
+    void lock() { pthread_mutex_lock(&m_mutex); }
+    void unlock() { pthread_mutex_unlock(&m_mutex); }
+#else
+    sidmutex() {}
+
+    void lock() {}
+    void unlock() {}
+#endif
+};
+
+/**
+ * Holds a sidmutex for the lifetime of the object.
+ */
+class sidlock
+{
+private:
+    sidmutex &m_mutex;
+
+private:
+    // prevent copying
+    sidlock(const sidlock&);
+    sidlock& operator=(const sidlock&);
+
+public:
+    sidlock(sidmutex &mutex) :
+        m_mutex(mutex) { m_mutex.lock(); }
+
+    ~sidlock() { m_mutex.unlock(); }
+};
+
+/**
+ * Base class for threads, derived classes implement run().
+ */
+class sidthread
+{
+private:
+#if defined(_WIN32)
+    HANDLE m_thread;
+#elif defined(HAVE_PTHREAD_H)
+    pthread_t m_thread;
+#endif
+
+    bool m_started;
+
+private:
+#if defined(_WIN32)
+    static DWORD WINAPI entry(LPVOID arg)
+    {
+        static_cast<sidthread*>(arg)->run();
+        return 0;
+    }
+#elif defined(HAVE_PTHREAD_H)
+    static void* entry(void *arg)
+    {
+        static_cast<sidthread*>(arg)->run();
+        return 0;
+    }
+#endif
+
+    // prevent copying
+    sidthread(const sidthread&);
+    sidthread& operator=(const sidthread&);
+
+protected:
+    /**
+     * The thread body.
+     */
+    virtual void run() = 0;
+
+public:
+    sidthread() :
+        m_started(false) {}
+
+    virtual ~sidthread() { join(); }
+
+    /**
+     * Check if threads are supported on this platform.
+     */
+    static bool supported()
+    {
+#if defined(_WIN32) || defined(HAVE_PTHREAD_H)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * Give up the processor for about the given time.
+     * Does nothing where threads are not supported.
+     */
+    static void sleep(unsigned int ms)
+    {
+#if defined(_WIN32)
+        Sleep(ms);
+#elif defined(HAVE_PTHREAD_H)
+        usleep(ms * 1000);
+#endif
+    }
+
+    /**
+     * Get a monotonic time stamp in nanoseconds.
+     * Falls back to the processor time where threads are not supported.
+     */
+    static uint_least64_t now()
+    {
+#if defined(_WIN32)
+        LARGE_INTEGER count, frequency;
+        QueryPerformanceCounter(&count);
+        QueryPerformanceFrequency(&frequency);
+        return (uint_least64_t)(count.QuadPart * (1000000000. / frequency.QuadPart));
+#elif defined(HAVE_PTHREAD_H)
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint_least64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+        return (uint_least64_t)(clock() * (1000000000. / CLOCKS_PER_SEC));
+#endif
+    }
+
+    /**
+     * Start running the thread.
+     *
+     * @return false if the thread couldn't be started
+     */
+    bool start()
+    {
+        if (m_started)
+            return false;
+
+#if defined(_WIN32)
+        m_thread = CreateThread(0, 0, entry, this, 0, 0);
+        m_started = m_thread != 0;
+#elif defined(HAVE_PTHREAD_H)
+        m_started = pthread_create(&m_thread, 0, entry, this) == 0;
+#endif
+        return m_started;
+    }
+
+    /**
+     * Wait for the thread to finish.
+     */
+    void join()
+    {
+        if (!m_started)
+            return;
+
+#if defined(_WIN32)
+        WaitForSingleObject(m_thread, INFINITE);
+        CloseHandle(m_thread);
+#elif defined(HAVE_PTHREAD_H)
+        pthread_join(m_thread, 0);
+#endif
+        m_started = false;
+    }
+};
+
+#endif // SIDTHREAD_H
@@ -0,0 +1,188 @@
+/*
+ * This file is part of libsidplayfp, a SID player engine.
+ *
+ *  Copyright 2014 Leandro Nini <drfiemost@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "sidtimedwriter.h"
+
+/**
+ * Waits longer than this are slept rather than spun, in ns.
+ */
+const uint_least64_t SLEEP_THRESHOLD = 2000000;
+
+/**
+ * Falling behind by more than this, in ns, means the emulation
+ * didn't keep up, the timing is moved rather than rushing
+ * through the late accesses.
+ */
+const uint_least64_t MAX_LATENESS = 10000000;
+
+sidtimedwriter::sidtimedwriter(port &port, event_clock_t latency) :
+    m_port(port),
+    m_queued(0),
+    m_latency(latency),
+    m_busy(false),
+    m_resync(true),
+    m_abort(false),
+    m_quit(false),
+    m_running(false),
+    m_cpuFreq(1000000.) {}
+
+sidtimedwriter::~sidtimedwriter()
+{
+    m_quit = true;
+    m_abort = true;
+    join();
+}
+
+bool sidtimedwriter::start(double cpuFreq)
+{
+    m_cpuFreq = cpuFreq;
+
+    if (!m_running)
+    {
+        m_quit = false;
+        m_resync = true;
+        m_running = sidthread::start();
+    }
+
+    return m_running;
+}
+
+bool sidtimedwriter::pending()
+{
+    sidlock lock(m_mutex);
+    return m_busy || !m_queue.empty();
+}
+
+void sidtimedwriter::transfer(const uint32_t *packets, unsigned int count)
+{
+    if (!m_running)
+        return;
+
+    event_clock_t cycles = 0;
+    for (unsigned int i = 0; i < count; i++)
+        cycles += sidwritequeue::cycles(packets[i]);
+
+    event_clock_t queued;
+    {
+        sidlock lock(m_mutex);
+        m_queue.insert(m_queue.end(), packets, packets + count);
+        m_queued += cycles;
+        queued = m_queued;
+    }
+
+    // Keep the emulation from getting too far ahead
+    while (queued > m_latency && !m_quit)
+    {
+        sleep(1);
+
+        sidlock lock(m_mutex);
+        queued = m_queued;
+    }
+}
+
+void sidtimedwriter::drain()
+{
+    while (m_running && pending())
+        sleep(1);
+}
+
+void sidtimedwriter::reset()
+{
+    {
+        sidlock lock(m_mutex);
+        m_queue.clear();
+        m_resync = true;
+        m_abort = true;
+    }
+
+    drain();
+
+    sidlock lock(m_mutex);
+    m_queued = 0;
+    m_abort = false;
+}
+
+void sidtimedwriter::run()
+{
+    std::vector<uint32_t> batch;
+
+    // Time of the first cycle and cycles played since
+    uint_least64_t start = 0;
+    event_clock_t clk = 0;
+
+    while (!m_quit)
+    {
+        bool resync;
+        {
+            sidlock lock(m_mutex);
+            batch.swap(m_queue);
+            m_busy = !batch.empty();
+            resync = m_busy && m_resync;
+            if (resync)
+                m_resync = false;
+        }
+
+        if (batch.empty())
+        {
+            sleep(1);
+            continue;
+        }
+
+        if (resync)
+        {
+            start = now();
+            clk = 0;
+        }
+
+        const double nsPerCycle = 1000000000. / m_cpuFreq;
+
+        for (std::vector<uint32_t>::const_iterator it = batch.begin(); it != batch.end() && !m_abort; ++it)
+        {
+            const unsigned int cycles = sidwritequeue::cycles(*it);
+            clk += cycles;
+
+            const uint_least64_t target = start + (uint_least64_t)(clk * nsPerCycle);
+            for (;;)
+            {
+                const uint_least64_t time = now();
+                if (time >= target)
+                {
+                    if (time - target > MAX_LATENESS)
+                        start += time - target;
+                    break;
+                }
+
+                if (target - time > SLEEP_THRESHOLD)
+                    sleep(1);
+            }
+
+            if (!sidwritequeue::isDelay(*it))
+                m_port.replay(sidwritequeue::addr(*it), sidwritequeue::data(*it));
+
+            sidlock lock(m_mutex);
+            m_queued -= cycles;
+        }
+
+        batch.clear();
+
+        sidlock lock(m_mutex);
+        m_busy = false;
+    }
+}
@@ -0,0 +1,120 @@
+/*
+ * This file is part of libsidplayfp, a SID player engine.
+ *
+ *  Copyright 2014 Leandro Nini <drfiemost@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef SIDTIMEDWRITER_H
+#define SIDTIMEDWRITER_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "sidthread.h"
+#include "sidwritequeue.h"
+
+/**
+ * Plays the batches of a sidwritequeue in real time from
+ * a dedicated thread, for chips without a buffer of their own
+ * like the Innovation SSI-2001 on the ISA bus.
+ *
+ * The emulation only has to keep ahead of the playback,
+ * #transfer blocks while more than the latency is queued.
+ * Only usable where threads are supported, see #start.
+ */
+class sidtimedwriter : public sidwritequeue::device, private sidthread
+{
+public:
+    /**
+     * Accesses the chip, called from the playback thread.
+     */
+    class port
+    {
+    public:
+        virtual ~port() {}
+
+        virtual void replay(uint_least8_t addr, uint8_t data) = 0;
+    };
+
+private:
+    port &m_port;
+
+    /// Guards the members shared with the playback thread
+    sidmutex m_mutex;
+
+    /// Packets waiting for the playback thread
+    std::vector<uint32_t> m_queue;
+
+    /// Cycles waiting to be played
+    event_clock_t m_queued;
+
+    /// Maximum cycles to queue
+    event_clock_t m_latency;
+
+    /// Set while the thread plays a batch
+    bool m_busy;
+
+    /// Start the timing over on the next batch
+    bool m_resync;
+
+    /// Drop the batch being played
+    volatile bool m_abort;
+
+    volatile bool m_quit;
+
+    volatile bool m_running;
+
+    double m_cpuFreq;
+
+private:
+    void run();
+
+    bool pending();
+
+public:
+    /**
+     * @param port where the accesses go
+     * @param latency how far ahead the emulation may get, in cycles
+     */
+    sidtimedwriter(port &port, event_clock_t latency);
+    ~sidtimedwriter();
+
+    /**
+     * Start the playback thread, or change the clock if running.
+     *
+     * @param cpuFreq the frequency of the emulated system
+     * @return false if the thread can't be started
+     */
+    bool start(double cpuFreq);
+
+    bool running() const { return m_running; }
+
+    void transfer(const uint32_t *packets, unsigned int count);
+
+    /**
+     * Wait until the queued packets have been played.
+     */
+    void drain();
+
+    /**
+     * Drop the queued packets, waiting for the one
+     * being played. The timing starts over with the next batch.
+     */
+    void reset();
+};
+
+#endif // SIDTIMEDWRITER_H
@@ -110,28 +110,32 @@ static const int psid_maxStrLen = 32;
 
 
 SidTuneBase* PSID::load(buffer_t& dataBuf)
+{
+    return dataBuf.empty() ? 0 : load(&dataBuf[0], dataBuf.size());
+}
+
+SidTuneBase* PSID::load(const uint_least8_t* dataBuf, uint_least32_t dataLen)
 {
     // File format check
-    if (dataBuf.size() < 4
-        || ((endian_big32(&dataBuf[0]) != PSID_ID)
-        && (endian_big32(&dataBuf[0]) != RSID_ID)))
+    if (dataLen < 4
+        || ((endian_big32(dataBuf) != PSID_ID)
+        && (endian_big32(dataBuf) != RSID_ID)))
     {
         return 0;
     }
 
     std::auto_ptr<PSID> tune(new PSID());
-    tune->tryLoad(dataBuf);
+    tune->tryLoad(dataBuf, dataLen);
 
     return tune.release();
 }
 
-void PSID::tryLoad(buffer_t& dataBuf)
+void PSID::tryLoad(const uint_least8_t* dataBuf, uint_least32_t dataLen)
 {
     // Due to security concerns, input must be at least as long as version 1
     // header plus 16-bit C64 load address. That is the area which will be
     // accessed.
-    const buffer_t::size_type bufLen = dataBuf.size();
-    if (bufLen < (sizeof(psidHeader) - 6 + 2))
+    if (dataLen < (sizeof(psidHeader) - 6 + 2))
     {
         throw loadError(ERR_TRUNCATED);
     }
@@ -140,7 +144,7 @@ void PSID::tryLoad(buffer_t& dataBuf)
 
     // Require a valid ID and version number.
     // FIXME not entirely safe due to possible struct padding
-    const psidHeader* pHeader = reinterpret_cast<const psidHeader*>(&dataBuf[0]);
+    const psidHeader* pHeader = reinterpret_cast<const psidHeader*>(dataBuf);
 
     if (endian_big32(pHeader->id) == PSID_ID)
     {
@@ -301,7 +305,7 @@ const char *PSID::createMD5(char *md5)
     // Include C64 data.
     sidmd5 myMD5;
     uint8_t tmp[2];
-    myMD5.append(&cache[fileOffset], info->m_c64dataLen);
+    myMD5.append(&fileData[fileOffset], info->m_c64dataLen);
 
     // Include INIT and PLAY address.
     endian_little16(tmp,info->m_initAddr);
@@ -33,7 +33,7 @@ private:
     char m_md5[SidTune::MD5_LENGTH+1];
 
 private:
-    void tryLoad(buffer_t& dataBuf);
+    void tryLoad(const uint_least8_t* dataBuf, uint_least32_t dataLen);
 
 protected:
     PSID() {}
@@ -43,6 +43,12 @@ public:
 
     static SidTuneBase* load(buffer_t& dataBuf);
 
+    /**
+     * Parse the header of a PSID file in memory.
+     * The data is not kept.
+     */
+    static SidTuneBase* load(const uint_least8_t* dataBuf, uint_least32_t dataLen);
+
     virtual const char *createMD5(char *md5);
 
 private:
@@ -168,8 +168,8 @@ bool SidTuneBase::placeSidTuneInC64mem(sidmemory* mem)
         mem->writeMemWord(0xac, start);
         mem->writeMemWord(0xae, end);
 
-        // Copy data from cache to the correct destination.
-        mem->fillRam(info->m_loadAddr, &cache[fileOffset], info->m_c64dataLen);
+        // Copy data from the file to the correct destination.
+        mem->fillRam(info->m_loadAddr, &fileData[fileOffset], info->m_c64dataLen);
 
         return true;
     }
@@ -244,7 +244,8 @@ void SidTuneBase::loadFile(const char* fileName, buffer_t& bufferRef)
 
 SidTuneBase::SidTuneBase() :
     info(new SidTuneInfoImpl()),
-    fileOffset(0)
+    fileOffset(0),
+    fileData(0)
 {
     // Initialize the object with some safe defaults.
     for (unsigned int si = 0; si < MAX_SONGS; si++)
@@ -305,8 +306,44 @@ SidTuneBase* SidTuneBase::getFromBuffer(const uint_least8_t* const buffer, uint_
     throw loadError(ERR_UNRECOGNIZED_FORMAT);
 }
 
+SidTuneBase* SidTuneBase::attach(const uint_least8_t* sourceBuffer, uint_least32_t bufferLen)
+{
+    if (sourceBuffer == 0 || bufferLen == 0)
+    {
+        throw loadError(ERR_EMPTY);
+    }
+
+    if (bufferLen > MAX_FILELEN)
+    {
+        throw loadError(ERR_FILE_TOO_LONG);
+    }
+
+    // Only PSID is used in place, MUS data gets
+    // merged with the player and needs a copy.
+    std::auto_ptr<SidTuneBase> s(PSID::load(sourceBuffer, bufferLen));
+    if (!s.get())
+    {
+        return getFromBuffer(sourceBuffer, bufferLen);
+    }
+
+    s->setFileNames("-", "-", false);
+    s->checkSidTune(sourceBuffer, bufferLen);
+    s->fileData = sourceBuffer;
+    return s.release();
+}
+
 void SidTuneBase::acceptSidTune(const char* dataFileName, const char* infoFileName,
                             buffer_t& buf, bool isSlashedFileName)
+{
+    setFileNames(dataFileName, infoFileName, isSlashedFileName);
+    checkSidTune(&buf[0], buf.size());
+
+    cache.swap(buf);
+    fileData = &cache[0];
+}
+
+void SidTuneBase::setFileNames(const char* dataFileName, const char* infoFileName,
+                            bool isSlashedFileName)
 {
     // Make a copy of the data file name and path, if available.
     if (dataFileName != 0)
@@ -326,6 +363,14 @@ void SidTuneBase::acceptSidTune(const char* dataFileName, const char* infoFileNa
             SidTuneTools::fileNameWithoutPath(infoFileName);
         info->m_infoFileName = std::string(infoFileName + fileNamePos);
     }
+}
+
+void SidTuneBase::checkSidTune(const uint_least8_t* data, uint_least32_t dataLen)
+{
+    if (fileOffset > dataLen)
+    {
+        throw loadError(ERR_CORRUPT);
+    }
 
     // Fix bad sidtune set up.
     if (info->m_songs > MAX_SONGS)
@@ -346,12 +391,12 @@ void SidTuneBase::acceptSidTune(const char* dataFileName, const char* infoFileNa
         info->m_startSong++;
     }
 
-    info->m_dataFileLen = buf.size();
-    info->m_c64dataLen = buf.size() - fileOffset;
+    info->m_dataFileLen = dataLen;
+    info->m_c64dataLen = dataLen - fileOffset;
 
     // Calculate any remaining addresses and then
     // confirm all the file details are correct
-    resolveAddrs(&buf[fileOffset]);
+    resolveAddrs(&data[fileOffset]);
 
     if (checkRelocInfo() == false)
     {
@@ -367,7 +412,7 @@ void SidTuneBase::acceptSidTune(const char* dataFileName, const char* infoFileNa
         // We only detect an offset of two. Some position independent
         // sidtunes contain a load address of 0xE000, but are loaded
         // to 0x0FFE and call player at 0x1000.
-        info->m_fixLoad = (endian_little16(&buf[fileOffset])==(info->m_loadAddr+2));
+        info->m_fixLoad = (endian_little16(&data[fileOffset])==(info->m_loadAddr+2));
     }
 
     // Check the size of the data.
@@ -379,8 +424,6 @@ void SidTuneBase::acceptSidTune(const char* dataFileName, const char* infoFileNa
     {
         throw loadError(ERR_EMPTY);
     }
-
-    cache.swap(buf);
 }
 
 void SidTuneBase::createNewFileName(std::string& destString,
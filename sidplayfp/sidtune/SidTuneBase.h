@@ -90,6 +90,13 @@ public:  // ----------------------------------------------------------------
      */
     static SidTuneBase* read(const uint_least8_t* sourceBuffer, uint_least32_t bufferLen);
 
+    /**
+     * Load a single-file sidtune from a memory buffer without copying it.
+     * PSID files are used in place, other formats are copied.
+     * The buffer must stay valid and unchanged while the tune is in use.
+     */
+    static SidTuneBase* attach(const uint_least8_t* sourceBuffer, uint_least32_t bufferLen);
+
     /**
      * Select sub-song (0 = default starting song)
      * and return active song number out of [1,2,..,SIDTUNE_MAX_SONGS].
@@ -132,6 +139,9 @@ protected:  // -------------------------------------------------------------
 
     buffer_t cache;
 
+    /// The file data, either in the cache or borrowed from the caller
+    const uint_least8_t* fileData;
+
 protected:
     SidTuneBase();
 
@@ -181,6 +191,17 @@ protected:
     virtual void acceptSidTune(const char* dataFileName, const char* infoFileName,
                         buffer_t& buf, bool isSlashedFileName);
 
+    /**
+     * Store the file names, see #acceptSidTune.
+     */
+    void setFileNames(const char* dataFileName, const char* infoFileName,
+                        bool isSlashedFileName);
+
+    /**
+     * Fix up and check the tune details against the file data.
+     */
+    void checkSidTune(const uint_least8_t* data, uint_least32_t dataLen);
+
     class PetsciiToAscii
     {
     private:
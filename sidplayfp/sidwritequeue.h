@@ -0,0 +1,177 @@
+/*
+ * This file is part of libsidplayfp, a SID player engine.
+ *
+ *  Copyright 2014 Leandro Nini <drfiemost@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef SIDWRITEQUEUE_H
+#define SIDWRITEQUEUE_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "event.h"
+
+/**
+ * Collects the register accesses of a hardware SID and
+ * hands them over to the device in batches, about a frame long,
+ * instead of one system call or port access for each of them.
+ *
+ * Accesses are stored as 32 bit packets in the format of
+ * the HardSID driver: the cycles since the previous packet
+ * in the upper 16 bits, the register in bits 8-12 and the value
+ * in the low byte. Longer gaps are split into delay packets,
+ * marked by bit 15, which don't access the chip.
+ */
+class sidwritequeue
+{
+public:
+    /**
+     * The receiving end of the queue.
+     */
+    class device
+    {
+    public:
+        virtual ~device() {}
+
+        /**
+         * Send a batch of packets to the chip.
+         * Devices without their own timing may block here
+         * to keep the emulation from running too far ahead.
+         *
+         * @param packets the packets
+         * @param count the number of packets, at least 1
+         */
+        virtual void transfer(const uint32_t *packets, unsigned int count) = 0;
+    };
+
+public:
+    /// Marks a delay packet
+    static const uint32_t DELAY = 0x8000;
+
+    /// Longest delay of a single packet
+    static const unsigned int MAX_DELAY = 0xffff;
+
+    /// Default length of a batch, about a PAL frame
+    static const unsigned int BATCH_CYCLES = 20000;
+
+private:
+    device *m_device;
+
+    std::vector<uint32_t> m_packets;
+
+    /// Length of a batch in cycles
+    event_clock_t m_batchCycles;
+
+    /// Cycles covered by the queued packets
+    event_clock_t m_cycles;
+
+    /// Cycles since the last queued packet
+    event_clock_t m_pending;
+
+private:
+    void addDelays(event_clock_t max)
+    {
+        while (m_pending > max)
+        {
+            const event_clock_t cycles = m_pending < MAX_DELAY ? m_pending : MAX_DELAY;
+            m_packets.push_back((uint32_t)(cycles << 16) | DELAY);
+            m_pending -= cycles;
+        }
+    }
+
+public:
+    static uint32_t packet(event_clock_t cycles, uint_least8_t addr, uint8_t data)
+    {
+        return (uint32_t)(cycles << 16) | ((addr & 0x1f) << 8) | data;
+    }
+
+    static unsigned int cycles(uint32_t packet) { return packet >> 16; }
+    static bool isDelay(uint32_t packet) { return (packet & DELAY) != 0; }
+    static uint_least8_t addr(uint32_t packet) { return (packet >> 8) & 0x1f; }
+    static uint8_t data(uint32_t packet) { return packet & 0xff; }
+
+public:
+    sidwritequeue(event_clock_t batchCycles = BATCH_CYCLES) :
+        m_device(0),
+        m_batchCycles(batchCycles),
+        m_cycles(0),
+        m_pending(0) {}
+
+    void setDevice(device *dev) { m_device = dev; }
+
+    void setBatchCycles(event_clock_t cycles) { m_batchCycles = cycles; }
+
+    /**
+     * Queue a register write.
+     *
+     * @param cycles the cycles since the previous access or delay
+     * @param addr the register
+     * @param data the value
+     */
+    void write(event_clock_t cycles, uint_least8_t addr, uint8_t data)
+    {
+        m_pending += cycles;
+        m_cycles += cycles;
+        addDelays(MAX_DELAY);
+        m_packets.push_back(packet(m_pending, addr, data));
+        m_pending = 0;
+
+        if (m_cycles >= m_batchCycles)
+            flush();
+    }
+
+    /**
+     * Let time pass without accessing the chip.
+     *
+     * @param cycles the cycles since the previous access or delay
+     */
+    void delay(event_clock_t cycles)
+    {
+        m_pending += cycles;
+        m_cycles += cycles;
+
+        if (m_cycles >= m_batchCycles)
+            flush();
+    }
+
+    /**
+     * Send the queued packets, including the time since the last one.
+     */
+    void flush()
+    {
+        addDelays(0);
+
+        if (m_device && !m_packets.empty())
+            m_device->transfer(&m_packets[0], m_packets.size());
+
+        m_packets.clear();
+        m_cycles = 0;
+    }
+
+    /**
+     * Drop the queued packets.
+     */
+    void clear()
+    {
+        m_packets.clear();
+        m_cycles = 0;
+        m_pending = 0;
+    }
+};
+
+#endif // SIDWRITEQUEUE_H
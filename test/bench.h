@@ -0,0 +1,177 @@
+/*
+ * This file is part of libsidplayfp, a SID player engine.
+ *
+ * Copyright 2014 Leandro Nini <drfiemost@users.sourceforge.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+/**
+ * Minimal benchmark runner shared by the benchmark programs.
+ *
+ * A benchmark is a functor running the measured operation
+ * a given number of times. Unless fixed, the number of iterations
+ * is raised until a run lasts long enough to be timed, then the run
+ * is repeated and the median is reported.
+ *
+ * Results go to stdout as CSV lines
+ * <tt>name,iterations,ns_per_op</tt>
+ * after a header, other information is on lines starting with #.
+ * All the inputs are generated from fixed seeds so the
+ * work done is the same on every run.
+ */
+namespace bench
+{
+
+/// Results of the measured code end up here so it's not optimized away.
+static volatile int sink;
+
+class options
+{
+public:
+    /// Only run the benchmarks whose name contains this.
+    const char *filter;
+
+    /// Times each measurement is repeated.
+    int repetitions;
+
+    /// Minimum duration of a measurement in seconds.
+    double minTime;
+
+public:
+    options() :
+        filter(0),
+        repetitions(3),
+        minTime(0.2) {}
+
+    /**
+     * Parse the common options, -f<filter> -r<repetitions> -t<seconds>.
+     * Other arguments are left in place.
+     *
+     * @return false on unknown options
+     */
+    bool parse(int &argc, const char *argv[])
+    {
+        int n = 1;
+        for (int i = 1; i < argc; i++)
+        {
+            const char *arg = argv[i];
+
+            if (arg[0] != '-')
+                argv[n++] = arg;
+            else if (arg[1] == 'f')
+                filter = arg + 2;
+            else if (arg[1] == 'r')
+                repetitions = std::max(1, atoi(arg + 2));
+            else if (arg[1] == 't')
+                minTime = atof(arg + 2);
+            else
+                return false;
+        }
+        argc = n;
+        return true;
+    }
+
+    static void usage(const char *extra = "")
+    {
+        std::cerr << "  -f<text>  only run the benchmarks whose name contains text" << std::endl
+                  << "  -r<num>   repetitions of each measurement, default 3" << std::endl
+                  << "  -t<secs>  minimum time of each measurement, default 0.2" << std::endl
+                  << extra;
+    }
+};
+
+inline void header()
+{
+    std::cout << "benchmark,iterations,ns_per_op" << std::endl;
+}
+
+template<class T>
+double measure(T &bench, long iterations)
+{
+    const clock_t start = clock();
+    bench(iterations);
+    const clock_t end = clock();
+    return (double)(end - start) / CLOCKS_PER_SEC;
+}
+
+/**
+ * Check if a benchmark is selected by the options.
+ */
+inline bool selected(const char *name, const options &opt)
+{
+    return !opt.filter || strstr(name, opt.filter);
+}
+
+/**
+ * Run a benchmark and print its result.
+ *
+ * @param name the name, unique within the program
+ * @param bench the functor, called with the number of iterations
+ * @param opt the options
+ * @param iterations the iterations of each measurement,
+ *        0 to pick them so that it lasts long enough
+ */
+template<class T>
+void run(const char *name, T &bench, const options &opt, long iterations = 0)
+{
+    if (!selected(name, opt))
+        return;
+
+    // Warm up, then find how many iterations last long enough
+    const bool calibrate = iterations == 0;
+    if (calibrate)
+    {
+        iterations = 1;
+        bench(iterations);
+    }
+
+    while (calibrate)
+    {
+        const double elapsed = measure(bench, iterations);
+        if (elapsed >= opt.minTime)
+            break;
+
+        const double scale = (elapsed > 0.) ? opt.minTime * 1.4 / elapsed : 10.;
+        iterations = (long)(iterations * std::min(std::max(scale, 2.), 10.));
+    }
+
+    std::vector<double> times;
+    for (int r = 0; r < opt.repetitions; r++)
+    {
+        times.push_back(measure(bench, iterations));
+    }
+
+    std::sort(times.begin(), times.end());
+    const double median = times[times.size() / 2];
+
+    std::cout << name << ',' << iterations << ','
+              << std::fixed << std::setprecision(3) << median * 1e9 / iterations << std::endl;
+}
+
+}
+
+#endif // BENCH_H
@@ -0,0 +1,540 @@
+/*
+ * This file is part of libsidplayfp, a SID player engine.
+ *
+ * Copyright 2014 Leandro Nini <drfiemost@users.sourceforge.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "bench.h"
+
+#include "EventScheduler.h"
+#include "mixer.h"
+#include "sidemu.h"
+#include "c64/CPU/mos6510.h"
+
+#include "Filter6581.h"
+#include "Filter8580.h"
+#include "FilterModelConfig.h"
+#include "Integrator.h"
+#include "WaveformCalculator.h"
+#include "WaveformGenerator.h"
+#include "resample/SincResampler.h"
+
+/*
+ * Micro benchmarks of the inner loops of the engine.
+ * The parts are driven directly with synthetic input,
+ * so the figures don't depend on any tune.
+ */
+
+static unsigned int lcg(unsigned int &seed)
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 16;
+}
+
+// Samples of a voice, a sawtooth with a decaying envelope
+static std::vector<int> voiceSamples(unsigned int step)
+{
+    std::vector<int> samples(4096);
+    for (size_t i = 0; i < samples.size(); i++)
+    {
+        const int wave = (int)((i * step) & 0xfff) - 0x800;
+        const int envelope = 255 - (int)(i * 255 / samples.size());
+        samples[i] = wave * envelope;
+    }
+    return samples;
+}
+
+/******************************************************************************
+ * Event scheduler
+ ******************************************************************************/
+
+/**
+ * An event rescheduling itself at pseudo random delays,
+ * like the timers of the chips do.
+ */
+class periodicEvent : public Event
+{
+private:
+    EventContext &m_context;
+    unsigned int m_seed;
+
+public:
+    periodicEvent(EventContext &context, unsigned int seed) :
+        Event("Periodic"),
+        m_context(context),
+        m_seed(seed) {}
+
+    // Event has no public virtual destructor to delete through
+    virtual ~periodicEvent() {}
+
+    void event()
+    {
+        m_context.schedule(*this, 1 + lcg(m_seed) % 20000, EVENT_CLOCK_PHI1);
+    }
+};
+
+/**
+ * Insert and pop an event with a number of other events pending.
+ * One operation is an event fired and rescheduled.
+ */
+class schedulerBench
+{
+private:
+    EventScheduler m_scheduler;
+    std::vector<periodicEvent*> m_events;
+
+public:
+    schedulerBench(EventScheduler::queue_t queue, unsigned int pending) :
+        m_scheduler(queue)
+    {
+        for (unsigned int i = 0; i < pending; i++)
+        {
+            m_events.push_back(new periodicEvent(m_scheduler, i + 1));
+            m_events.back()->event();
+        }
+    }
+
+    ~schedulerBench()
+    {
+        for (size_t i = 0; i < m_events.size(); i++)
+        {
+            delete m_events[i];
+        }
+    }
+
+    void operator()(long iterations)
+    {
+        for (long i = 0; i < iterations; i++)
+        {
+            m_scheduler.clock();
+        }
+    }
+};
+
+/******************************************************************************
+ * CPU
+ ******************************************************************************/
+
+/**
+ * A CPU with flat RAM, looping over a mix of
+ * loads, stores, arithmetic and branches.
+ */
+class ramCpu : public MOS6510
+{
+private:
+    uint8_t m_ram[0x10000];
+
+public:
+    ramCpu(EventContext *context) :
+        MOS6510(context)
+    {
+        static const uint8_t code[] =
+        {
+            0xa2, 0x00,         // LDX #$00
+            0xbd, 0x00, 0x20,   // LDA $2000,X
+            0x18,               // CLC
+            0x69, 0x03,         // ADC #$03
+            0x9d, 0x00, 0x20,   // STA $2000,X
+            0x45, 0x10,         // EOR $10
+            0x85, 0x10,         // STA $10
+            0xe8,               // INX
+            0xd0, 0xf0,         // BNE $1002
+            0x20, 0x18, 0x10,   // JSR $1018
+            0x4c, 0x00, 0x10,   // JMP $1000
+            0xe6, 0x11,         // INC $11
+            0x60,               // RTS
+        };
+
+        std::fill(m_ram, m_ram + sizeof(m_ram), 0);
+        std::copy(code, code + sizeof(code), m_ram + 0x1000);
+        m_ram[0xfffc] = 0x00;
+        m_ram[0xfffd] = 0x10;
+    }
+
+    uint8_t cpuRead(uint_least16_t addr) { return m_ram[addr]; }
+    void cpuWrite(uint_least16_t addr, uint8_t data) { m_ram[addr] = data; }
+
+#ifdef PC64_TESTSUITE
+    void loadFile(const char *) {}
+#endif
+
+    uint8_t result() const { return m_ram[0x10]; }
+};
+
+/**
+ * Run the CPU, one operation is a cycle.
+ */
+class cpuBench
+{
+private:
+    EventScheduler m_scheduler;
+    ramCpu m_cpu;
+    EventCallback<cpuBench> m_end;
+    bool m_running;
+
+    void end() { m_running = false; }
+
+public:
+    cpuBench(bool batch) :
+        m_cpu(&m_scheduler),
+        m_end("End", *this, &cpuBench::end),
+        m_running(false)
+    {
+        m_cpu.setBatchMode(batch);
+        // The CPU schedules itself on construction
+        m_scheduler.reset();
+        m_cpu.reset();
+    }
+
+    void operator()(long iterations)
+    {
+        EventContext &context = m_scheduler;
+
+        m_running = true;
+        context.schedule(m_end, iterations, EVENT_CLOCK_PHI1);
+        while (m_running)
+            m_scheduler.clock();
+        bench::sink += m_cpu.result();
+    }
+};
+
+/******************************************************************************
+ * reSIDfp
+ ******************************************************************************/
+
+/**
+ * Clock an oscillator, one operation is a cycle.
+ */
+class waveformBench
+{
+private:
+    reSIDfp::WaveformGenerator m_wave;
+
+public:
+    waveformBench(unsigned char control)
+    {
+        m_wave.setWaveformModels(reSIDfp::WaveformCalculator::getInstance()->buildTable(reSIDfp::MOS6581));
+        m_wave.setChipModel(reSIDfp::MOS6581);
+        m_wave.reset();
+        m_wave.writeFREQ_LO(0x37);
+        m_wave.writeFREQ_HI(0x1d);
+        m_wave.writePW_LO(0x00);
+        m_wave.writePW_HI(0x08);
+        m_wave.writeCONTROL_REG(control);
+    }
+
+    void operator()(long iterations)
+    {
+        int sum = 0;
+        for (long i = 0; i < iterations; i++)
+        {
+            m_wave.clock();
+            sum += m_wave.output(&m_wave);
+        }
+        bench::sink += sum;
+    }
+};
+
+/**
+ * Clock a filter with all voices routed through it,
+ * one operation is a cycle.
+ */
+template<class F>
+class filterBench
+{
+private:
+    F m_filter;
+    std::vector<int> m_voice1;
+    std::vector<int> m_voice2;
+    std::vector<int> m_voice3;
+
+public:
+    filterBench() :
+        m_voice1(voiceSamples(7)),
+        m_voice2(voiceSamples(11)),
+        m_voice3(voiceSamples(13))
+    {
+        m_filter.reset();
+        m_filter.enable(true);
+        m_filter.writeFC_LO(0x05);
+        m_filter.writeFC_HI(0x40);
+        m_filter.writeRES_FILT(0xa7);
+        m_filter.writeMODE_VOL(0x1f);
+    }
+
+    void operator()(long iterations)
+    {
+        int sum = 0;
+        const long mask = (long)m_voice1.size() - 1;
+        for (long i = 0; i < iterations; i++)
+        {
+            const long j = i & mask;
+            sum += m_filter.clock(m_voice1[j], m_voice2[j], m_voice3[j]);
+        }
+        bench::sink += sum;
+    }
+};
+
+/**
+ * Solve the integrators of a 6581 filter loop,
+ * one operation is a solve.
+ */
+class integratorBench
+{
+private:
+    std::auto_ptr<reSIDfp::Integrator> m_hp;
+    std::auto_ptr<reSIDfp::Integrator> m_bp;
+    const unsigned short *m_summer;
+    const unsigned short *m_resonance;
+    std::vector<int> m_input;
+
+public:
+    integratorBench()
+    {
+        reSIDfp::FilterModelConfig *config = reSIDfp::FilterModelConfig::getInstance();
+
+        m_hp = config->buildIntegrator();
+        m_bp = config->buildIntegrator();
+
+        const unsigned short *dac = config->getDAC(0.5);
+        m_hp->setVw(dac[0x400]);
+        m_bp->setVw(dac[0x400]);
+        delete [] dac;
+
+        // One voice at the filter input, medium resonance
+        m_summer = config->getSummer()[1];
+        m_resonance = config->getGain()[~8 & 0xf];
+
+        const std::vector<int> voice = voiceSamples(7);
+        const int scale = config->getVoiceScaleS14();
+        const int dc = config->getVoiceDC();
+        for (size_t i = 0; i < voice.size(); i++)
+        {
+            m_input.push_back((voice[i] * scale >> 18) + dc);
+        }
+    }
+
+    void operator()(long iterations)
+    {
+        int Vhp = 0, Vbp = 0, Vlp = 0;
+        const long mask = (long)m_input.size() - 1;
+        for (long i = 0; i < iterations; i += 2)
+        {
+            const int oldVhp = Vhp;
+            Vhp = m_summer[m_resonance[Vbp] + Vlp + m_input[(i >> 1) & mask]];
+            Vlp = m_bp->solve(Vbp);
+            Vbp = m_hp->solve(oldVhp);
+        }
+        bench::sink += Vlp;
+    }
+};
+
+/**
+ * Feed the sinc resampler, one operation is an input sample.
+ */
+class resamplerBench
+{
+private:
+    reSIDfp::SincResampler m_resampler;
+    std::vector<int> m_input;
+
+public:
+    resamplerBench(double frequency) :
+        m_resampler(985248., frequency, 20000.),
+        m_input(voiceSamples(7))
+    {
+        for (size_t i = 0; i < m_input.size(); i++)
+        {
+            m_input[i] >>= 5;
+        }
+    }
+
+    void operator()(long iterations)
+    {
+        int sum = 0;
+        const long mask = (long)m_input.size() - 1;
+        for (long i = 0; i < iterations; i++)
+        {
+            if (m_resampler.input(m_input[i & mask]))
+                sum += m_resampler.output();
+        }
+        bench::sink += sum;
+    }
+};
+
+/******************************************************************************
+ * Mixer
+ ******************************************************************************/
+
+/**
+ * A SID whose buffer is filled with noise once,
+ * clocking only moves the buffer position as many samples
+ * as the player gets from reSIDfp at 44.1 kHz.
+ */
+class noiseSid : public sidemu
+{
+private:
+    static const int CHUNK = 224;
+
+public:
+    noiseSid(unsigned int seed) :
+        sidemu(0)
+    {
+        m_buffer = new int[OUTPUTBUFFERSIZE];
+        for (int i = 0; i < OUTPUTBUFFERSIZE; i++)
+        {
+            m_buffer[i] = (short)lcg(seed);
+        }
+    }
+
+    ~noiseSid() { delete [] m_buffer; }
+
+    void clock() { m_bufferpos += CHUNK; }
+
+    void voice(unsigned int, bool) {}
+    void model(SidConfig::sid_model_t) {}
+    void reset(uint8_t) {}
+    uint8_t read(uint_least8_t) { return 0; }
+    void write(uint_least8_t, uint8_t) {}
+};
+
+/**
+ * Mix SIDs into 16 bit samples, one operation is an output frame.
+ */
+class mixerBench
+{
+private:
+    static const uint_least32_t BUFFERSIZE = 4096;
+
+private:
+    std::vector<noiseSid*> m_chips;
+    Mixer m_mixer;
+    std::vector<short> m_buffer;
+    unsigned int m_channels;
+
+public:
+    mixerBench(unsigned int sids, bool stereo) :
+        m_buffer(BUFFERSIZE),
+        m_channels(stereo ? 2 : 1)
+    {
+        m_mixer.setStereo(stereo);
+        for (unsigned int i = 0; i < sids; i++)
+        {
+            m_chips.push_back(new noiseSid(i + 1));
+            m_mixer.addSid(m_chips.back());
+        }
+    }
+
+    ~mixerBench()
+    {
+        for (size_t i = 0; i < m_chips.size(); i++)
+        {
+            delete m_chips[i];
+        }
+    }
+
+    void operator()(long iterations)
+    {
+        long frames = 0;
+        while (frames < iterations)
+        {
+            m_mixer.begin(&m_buffer[0], BUFFERSIZE);
+            while (m_mixer.notFinished())
+            {
+                m_mixer.clockChips();
+                m_mixer.doMix();
+            }
+            frames += m_mixer.samplesGenerated() / m_channels;
+        }
+        bench::sink += m_buffer[BUFFERSIZE - 1];
+    }
+};
+
+int main(int argc, const char* argv[])
+{
+    bench::options opt;
+    if (!opt.parse(argc, argv) || argc > 1)
+    {
+        std::cerr << "Usage: microbench [options]" << std::endl;
+        bench::options::usage();
+        return EXIT_FAILURE;
+    }
+
+    bench::header();
+
+    {
+        const unsigned int pending[] = { 8, 64 };
+        const char *names[2][2] =
+        {
+            { "EventScheduler/list/8", "EventScheduler/list/64" },
+            { "EventScheduler/calendar/8", "EventScheduler/calendar/64" },
+        };
+        for (int q = 0; q < 2; q++)
+        {
+            for (int p = 0; p < 2; p++)
+            {
+                schedulerBench b(q ? EventScheduler::CALENDAR : EventScheduler::LINKED_LIST, pending[p]);
+                bench::run(names[q][p], b, opt);
+            }
+        }
+    }
+
+    {
+        cpuBench batch(true);
+        bench::run("MOS6510/batch", batch, opt);
+        cpuBench cycle(false);
+        bench::run("MOS6510/cycle", cycle, opt);
+    }
+
+    {
+        waveformBench saw(0x21);
+        bench::run("WaveformGenerator::clock/saw", saw, opt);
+        waveformBench pulse(0x41);
+        bench::run("WaveformGenerator::clock/pulse", pulse, opt);
+        waveformBench noise(0x81);
+        bench::run("WaveformGenerator::clock/noise", noise, opt);
+    }
+
+    {
+        filterBench<reSIDfp::Filter6581> f6581;
+        bench::run("Filter6581::clock", f6581, opt);
+        filterBench<reSIDfp::Filter8580> f8580;
+        bench::run("Filter8580::clock", f8580, opt);
+        integratorBench integrator;
+        bench::run("Integrator::solve", integrator, opt);
+    }
+
+    {
+        resamplerBench r44(44100.);
+        bench::run("SincResampler::input/44100", r44, opt);
+        resamplerBench r96(96000.);
+        bench::run("SincResampler::input/96000", r96, opt);
+    }
+
+    {
+        mixerBench mono(1, false);
+        bench::run("Mixer::doMix/1/mono", mono, opt);
+        mixerBench stereo(2, true);
+        bench::run("Mixer::doMix/2/stereo", stereo, opt);
+    }
+
+    return EXIT_SUCCESS;
+}
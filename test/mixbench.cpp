@@ -0,0 +1,174 @@
+/*
+ * This file is part of libsidplayfp, a SID player engine.
+ *
+ * Copyright 2014 Leandro Nini <drfiemost@users.sourceforge.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+#include "mixer.h"
+#include "sidemu.h"
+
+/**
+ * A SID playing back noise, as many samples per clock
+ * as the player gets from reSIDfp at 44.1 kHz.
+ */
+class noiseSid : public sidemu
+{
+private:
+    static const int CHUNK = 224;
+    static const int NOISESIZE = 8192;
+
+private:
+    std::vector<int> m_noise;
+    int m_pos;
+
+public:
+    noiseSid(unsigned int seed) :
+        sidemu(0),
+        m_noise(NOISESIZE + CHUNK),
+        m_pos(0)
+    {
+        m_buffer = new int[OUTPUTBUFFERSIZE];
+
+        for (size_t i = 0; i < m_noise.size(); i++)
+        {
+            seed = seed * 1103515245 + 12345;
+            m_noise[i] = (short)(seed >> 16);
+        }
+    }
+
+    ~noiseSid() { delete [] m_buffer; }
+
+    void clock()
+    {
+        std::copy(&m_noise[m_pos], &m_noise[m_pos] + CHUNK, m_buffer + m_bufferpos);
+        m_bufferpos += CHUNK;
+        m_pos = (m_pos + CHUNK) % NOISESIZE;
+    }
+
+    void voice(unsigned int, bool) {}
+    void model(SidConfig::sid_model_t) {}
+    void reset(uint8_t) {}
+    uint8_t read(uint_least8_t) { return 0; }
+    void write(uint_least8_t, uint8_t) {}
+};
+
+/**
+ * Mix into the buffer matching the output format.
+ */
+static void begin(Mixer &mixer, Mixer::sample_format_t format, uint_least32_t count,
+                  std::vector<short> &s16, std::vector<int_least32_t> &s32, std::vector<float> &flt)
+{
+    switch (format)
+    {
+    case Mixer::SAMPLE_S16:
+        mixer.begin(&s16[0], count);
+        break;
+    case Mixer::SAMPLE_S32:
+        mixer.begin(&s32[0], count);
+        break;
+    case Mixer::SAMPLE_FLOAT:
+        mixer.begin(&flt[0], count);
+        break;
+    }
+}
+
+/**
+ * Report the mixing time per output sample for different numbers
+ * of SIDs, channels, fast forward factors and output formats.
+ */
+int main()
+{
+    const unsigned int sids[] = { 1, 2, 4 };
+    const int ffs[] = { 1, 4 };
+    const Mixer::sample_format_t formats[] = { Mixer::SAMPLE_S16, Mixer::SAMPLE_S32, Mixer::SAMPLE_FLOAT };
+    const char* formatNames[] = { "s16", "s32", "float" };
+    const uint_least32_t SAMPLES = 20000000;
+    const uint_least32_t BUFFERSIZE = 4096;
+
+    std::vector<short> buffer(BUFFERSIZE);
+    std::vector<int_least32_t> buffer32(BUFFERSIZE);
+    std::vector<float> bufferFloat(BUFFERSIZE);
+    unsigned int checksum = 0;
+
+    std::cout << std::setw(6) << "sids" << std::setw(8) << "mode" << std::setw(4) << "ff"
+        << std::setw(8) << "format"
+        << std::setw(12) << "ns/sample" << std::endl;
+
+    for (size_t s = 0; s < sizeof(sids) / sizeof(sids[0]); s++)
+    {
+        for (int stereo = 0; stereo < 2; stereo++)
+        {
+            for (size_t f = 0; f < sizeof(ffs) / sizeof(ffs[0]); f++)
+            {
+                for (size_t fmt = 0; fmt < sizeof(formats) / sizeof(formats[0]); fmt++)
+                {
+                    std::vector<noiseSid*> chips;
+                    Mixer mixer;
+
+                    mixer.setStereo(stereo != 0);
+                    mixer.setVolume(Mixer::VOLUME_MAX, Mixer::VOLUME_MAX);
+                    mixer.setFastForward(ffs[f]);
+
+                    for (unsigned int i = 0; i < sids[s]; i++)
+                    {
+                        chips.push_back(new noiseSid(i + 1));
+                        mixer.addSid(chips.back());
+                    }
+
+                    const clock_t start = clock();
+
+                    uint_least32_t left = SAMPLES;
+                    while (left)
+                    {
+                        begin(mixer, formats[fmt], BUFFERSIZE, buffer, buffer32, bufferFloat);
+                        while (mixer.notFinished())
+                        {
+                            mixer.clockChips();
+                            mixer.doMix();
+                        }
+                        checksum += buffer[BUFFERSIZE - 1] + buffer32[BUFFERSIZE - 1] + (int)bufferFloat[BUFFERSIZE - 1];
+                        left -= left < BUFFERSIZE ? left : BUFFERSIZE;
+                    }
+
+                    const clock_t end = clock();
+
+                    // Includes copying the noise to the SID buffers
+                    const double ns = (double)(end - start) / CLOCKS_PER_SEC * 1e9 / SAMPLES;
+                    std::cout << std::setw(6) << sids[s] << std::setw(8) << (stereo ? "stereo" : "mono")
+                        << std::setw(4) << ffs[f] << std::setw(8) << formatNames[fmt] << std::setw(12) << std::fixed << std::setprecision(2) << ns << std::endl;
+
+                    for (size_t i = 0; i < chips.size(); i++)
+                    {
+                        delete chips[i];
+                    }
+                }
+            }
+        }
+    }
+
+    // Print the checksum so the mixing is not optimized away
+    std::cout << "checksum " << checksum << std::endl;
+
+    return EXIT_SUCCESS;
+}
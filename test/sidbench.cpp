@@ -0,0 +1,350 @@
+/*
+ * This file is part of libsidplayfp, a SID player engine.
+ *
+ * Copyright 2014 Leandro Nini <drfiemost@users.sourceforge.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <stdint.h>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+
+#include "sidplayfp/sidplayfp.h"
+#include "sidplayfp/sidbuilder.h"
+#include "sidplayfp/SidConfig.h"
+#include "sidplayfp/SidTune.h"
+#include "builders/residfp-builder/residfp.h"
+#include "builders/resid-builder/resid.h"
+
+/*
+ * Macro benchmarks: render a few seconds of some tunes with each
+ * builder and sampling method, one operation is an output frame.
+ * The bundled tunes are generated here, tune files can be added
+ * on the command line.
+ * Each measurement restarts the song. The checksum of the output
+ * of the first one, from a freshly configured engine, is printed
+ * to catch changes in the output along with changes in speed.
+ */
+
+/**
+ * Assembles a PSID file around a small player
+ * sweeping the voices and the filter every frame.
+ */
+class psidBuilder
+{
+private:
+    static const uint_least16_t LOAD = 0x1000;
+    static const uint8_t COUNTER = 0xfb;
+
+private:
+    std::vector<uint8_t> m_code;
+
+private:
+    void emit(uint8_t byte) { m_code.push_back(byte); }
+    void emit(uint8_t opcode, uint_least16_t addr) { emit(opcode); emit(addr & 0xff); emit(addr >> 8); }
+
+    void ldaImm(uint8_t value) { emit(0xa9); emit(value); }
+    void ldaZp(uint8_t addr) { emit(0xa5); emit(addr); }
+    void incZp(uint8_t addr) { emit(0xe6); emit(addr); }
+    void sta(uint_least16_t addr) { emit(0x8d, addr); }
+    void andImm(uint8_t value) { emit(0x29); emit(value); }
+    void oraImm(uint8_t value) { emit(0x09); emit(value); }
+    void eorImm(uint8_t value) { emit(0x49); emit(value); }
+    void lsr() { emit(0x4a); }
+    void rts() { emit(0x60); }
+
+    uint_least16_t pc() const { return LOAD + m_code.size(); }
+
+public:
+    /**
+     * Build the tune.
+     *
+     * @param regs initial value of the SID registers
+     * @param model 1 for 6581, 2 for 8580
+     * @param cia play on the CIA timer instead of the vertical blank
+     * @param sids 1 or 2, the second one at $d420
+     * @return the PSID file
+     */
+    std::vector<uint8_t> build(const uint8_t regs[25], unsigned int model, bool cia, unsigned int sids)
+    {
+        m_code.clear();
+
+        const uint_least16_t init = pc();
+        for (unsigned int s = 0; s < sids; s++)
+        {
+            for (unsigned int r = 0; r < 25; r++)
+            {
+                ldaImm(regs[r]);
+                sta(0xd400 + s * 0x20 + r);
+            }
+        }
+        ldaImm(0);
+        emit(0x85); emit(COUNTER);
+        rts();
+
+        const uint_least16_t play = pc();
+        incZp(COUNTER);
+        for (unsigned int s = 0; s < sids; s++)
+        {
+            const uint_least16_t base = 0xd400 + s * 0x20;
+
+            // Sweep the pitch of voices 1 and 2, the cutoff and the pulse widths
+            ldaZp(COUNTER);
+            if (s)
+                eorImm(0x55);
+            sta(base + 0x01);
+            sta(base + 0x16);
+            eorImm(0xff);
+            sta(base + 0x08);
+            lsr();
+            sta(base + 0x03);
+            sta(base + 0x0a);
+
+            // Retrigger voice 1 every 8 frames
+            ldaZp(COUNTER);
+            lsr(); lsr(); lsr();
+            andImm(0x01);
+            oraImm(regs[0x04] & 0xfe);
+            sta(base + 0x04);
+
+            ldaZp(COUNTER);
+            andImm(0x3f);
+            sta(base + 0x0f);
+        }
+        rts();
+
+        std::vector<uint8_t> psid(0x7c, 0);
+        memcpy(&psid[0], "PSID", 4);
+        psid[0x05] = sids > 1 ? 3 : 2;
+        psid[0x07] = 0x7c;
+        psid[0x0a] = init >> 8;
+        psid[0x0b] = init & 0xff;
+        psid[0x0c] = play >> 8;
+        psid[0x0d] = play & 0xff;
+        psid[0x0f] = 1;
+        psid[0x11] = 1;
+        psid[0x15] = cia ? 1 : 0;
+        memcpy(&psid[0x16], "Benchmark", 9);
+        // PAL, SID model for both chips
+        psid[0x77] = 0x04 | (model << 4) | (sids > 1 ? model << 6 : 0);
+        if (sids > 1)
+            psid[0x7a] = 0x42;
+
+        psid.push_back(LOAD & 0xff);
+        psid.push_back(LOAD >> 8);
+        psid.insert(psid.end(), m_code.begin(), m_code.end());
+        return psid;
+    }
+};
+
+/**
+ * Render a tune, one operation is an output frame.
+ */
+class renderBench
+{
+private:
+    static const uint_least32_t BUFFERSIZE = 4096;
+
+private:
+    SidTune &m_tune;
+    std::auto_ptr<sidbuilder> m_builder;
+    sidplayfp m_engine;
+    std::vector<short> m_buffer;
+    unsigned int m_channels;
+    uint_least32_t m_checksum;
+    bool m_first;
+    bool m_ok;
+
+public:
+    renderBench(SidTune &tune, bool resid, SidConfig::sampling_method_t method, bool stereo) :
+        m_tune(tune),
+        m_buffer(BUFFERSIZE),
+        m_channels(stereo ? 2 : 1),
+        m_checksum(0),
+        m_first(true),
+        m_ok(false)
+    {
+        if (resid)
+        {
+            ReSIDBuilder *rs = new ReSIDBuilder("sidbench");
+            m_builder.reset(rs);
+            rs->create(2);
+        }
+        else
+        {
+            ReSIDfpBuilder *rs = new ReSIDfpBuilder("sidbench");
+            m_builder.reset(rs);
+            rs->create(2);
+        }
+
+        SidConfig cfg;
+        cfg.powerOnDelay = 0x100;
+        cfg.samplingMethod = method;
+        cfg.playback = stereo ? SidConfig::STEREO : SidConfig::MONO;
+        cfg.sidEmulation = m_builder.get();
+        m_ok = m_builder->getStatus() && m_engine.config(cfg);
+        if (!m_ok)
+            std::cerr << m_engine.error() << std::endl;
+    }
+
+    bool ok() const { return m_ok; }
+
+    uint_least32_t checksum() const { return m_checksum; }
+
+    void operator()(long iterations)
+    {
+        m_engine.load(&m_tune);
+
+        uint_least32_t checksum = 0;
+        long samples = iterations * m_channels;
+        while (samples > 0)
+        {
+            const uint_least32_t count = samples < (long)BUFFERSIZE ? samples : BUFFERSIZE;
+            const uint_least32_t played = m_engine.play(&m_buffer[0], count);
+            if (played == 0)
+                break;
+
+            for (uint_least32_t i = 0; i < played; i++)
+            {
+                checksum = (checksum * 31) + (uint16_t)m_buffer[i];
+            }
+            samples -= played;
+        }
+
+        // The dither goes on across songs
+        if (m_first)
+            m_checksum = checksum;
+        m_first = false;
+    }
+};
+
+int main(int argc, const char* argv[])
+{
+    bench::options opt;
+    if (!opt.parse(argc, argv))
+    {
+        std::cerr << "Usage: sidbench [options] [tunes]" << std::endl;
+        bench::options::usage("  tunes are rendered in mono, 10 seconds of each\n");
+        return EXIT_FAILURE;
+    }
+
+    const long SECONDS = 10;
+
+    std::vector<std::string> names;
+    std::vector<SidTune*> tunes;
+    std::vector<bool> stereo;
+
+    {
+        // Saw, pulse and triangle through the low pass
+        const uint8_t voices[25] =
+        {
+            0x00, 0x10, 0x00, 0x08, 0x21, 0x09, 0xa8,
+            0x00, 0x18, 0x00, 0x04, 0x41, 0x0a, 0x89,
+            0x00, 0x08, 0x00, 0x00, 0x11, 0x00, 0xf0,
+            0x00, 0x40, 0xf3, 0x1f
+        };
+        // Noise, pulse and ring modulation through the band pass
+        const uint8_t effects[25] =
+        {
+            0x00, 0x10, 0x00, 0x08, 0x81, 0x09, 0xa8,
+            0x00, 0x18, 0x00, 0x04, 0x41, 0x0a, 0x89,
+            0x00, 0x08, 0x00, 0x00, 0x15, 0x00, 0xf0,
+            0x00, 0x40, 0xf7, 0x2f
+        };
+
+        psidBuilder builder;
+        std::vector<uint8_t> psid;
+
+        psid = builder.build(voices, 1, false, 1);
+        names.push_back("vbi6581");
+        tunes.push_back(new SidTune(&psid[0], psid.size()));
+        stereo.push_back(false);
+
+        psid = builder.build(effects, 2, true, 1);
+        names.push_back("cia8580");
+        tunes.push_back(new SidTune(&psid[0], psid.size()));
+        stereo.push_back(false);
+
+        psid = builder.build(voices, 2, false, 2);
+        names.push_back("stereo8580");
+        tunes.push_back(new SidTune(&psid[0], psid.size()));
+        stereo.push_back(true);
+    }
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string name(argv[i]);
+        const size_t slash = name.find_last_of("/\\");
+        if (slash != std::string::npos)
+            name.erase(0, slash + 1);
+
+        names.push_back(name);
+        tunes.push_back(new SidTune(argv[i]));
+        stereo.push_back(false);
+    }
+
+    bench::header();
+
+    int status = EXIT_SUCCESS;
+
+    for (size_t t = 0; t < tunes.size(); t++)
+    {
+        if (!tunes[t]->getStatus())
+        {
+            std::cerr << names[t] << ": " << tunes[t]->statusString() << std::endl;
+            status = EXIT_FAILURE;
+            continue;
+        }
+
+        tunes[t]->selectSong(0);
+
+        for (int resid = 0; resid < 2; resid++)
+        {
+            for (int resample = 0; resample < 2; resample++)
+            {
+                const std::string name = "render/" + names[t]
+                    + (resid ? "/resid" : "/residfp")
+                    + (resample ? "/resample" : "/interpolate");
+
+                if (!bench::selected(name.c_str(), opt))
+                    continue;
+
+                renderBench b(*tunes[t], resid != 0,
+                    resample ? SidConfig::RESAMPLE_INTERPOLATE : SidConfig::INTERPOLATE, stereo[t]);
+                if (!b.ok())
+                {
+                    status = EXIT_FAILURE;
+                    continue;
+                }
+
+                bench::run(name.c_str(), b, opt, SECONDS * SidConfig::DEFAULT_SAMPLING_FREQ);
+                std::cout << "# " << name << " checksum " << std::hex << b.checksum() << std::dec << std::endl;
+            }
+        }
+    }
+
+    for (size_t t = 0; t < tunes.size(); t++)
+    {
+        delete tunes[t];
+    }
+
+    return status;
+}
@@ -58,6 +58,14 @@ void loadRom(const char* path, char* buffer)
     is.close();
 }
 
+/*
+ * Stop hardware playback on a key press
+ */
+bool keyPressed(void*)
+{
+    return kbhit() != 0;
+}
+
 int main(int argc, char* argv[])
 {
     sidplayfp m_engine;
@@ -160,15 +168,7 @@ int main(int argc, char* argv[])
 
 
 
-    m_engine.play(0, 0);
-
-    for (;;)
-    {
-        if(!m_engine.isPlaying () || kbhit())
-        {
-            break;
-        }
-    }
+    m_engine.playHardware(keyPressed);
 
     // flush keyboard buffer
     while(kbhit())
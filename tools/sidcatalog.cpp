@@ -0,0 +1,163 @@
+/*
+ * This file is part of libsidplayfp, a SID player engine.
+ *
+ * Copyright 2014 Leandro Nini <drfiemost@users.sourceforge.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <stdlib.h>
+
+#include <iomanip>
+#include <iostream>
+
+#include "sidplayfp/sidcatalog.h"
+#include "utils/SidDatabase.h"
+#include "utils/STILview/stilindex.h"
+
+/*
+ * Scan a collection of tunes, usually HVSC, into a catalog
+ * or list the contents of one.
+ */
+
+static void usage()
+{
+    std::cerr << "Usage: sidcatalog [options] <dir> <catalog>" << std::endl
+              << "       sidcatalog -l <catalog>" << std::endl
+              << "  -j<num>   worker threads, default 4" << std::endl
+              << "  -d<file>  songlength database, text or index" << std::endl
+              << "  -s        look for STIL entries, dir must be the HVSC root" << std::endl
+              << "  -l        list a catalog" << std::endl;
+}
+
+static unsigned int stilCheck(const char *path, void *data)
+{
+    const STILIndex *index = static_cast<const STILIndex*>(data);
+
+    STILIndex::view text;
+    unsigned int flags = 0;
+    if (index->getEntry(path, text))
+        flags |= sidcatalog::HAS_STIL;
+    if (index->getBug(path, text))
+        flags |= sidcatalog::HAS_BUG;
+    return flags;
+}
+
+static int list(const char *filename)
+{
+    sidcatalog catalog(0);
+    if (!catalog.open(filename))
+    {
+        std::cerr << catalog.error() << std::endl;
+        return -1;
+    }
+
+    for (unsigned int i = 0; i < catalog.size(); i++)
+    {
+        const sidcatalog::entry &e = catalog[i];
+
+        std::cout << e.md5 << ' ' << e.path << " \"" << e.title << "\" \"" << e.author
+                  << "\" " << e.songs << (e.flags & sidcatalog::HAS_STIL ? " STIL" : "")
+                  << (e.flags & sidcatalog::HAS_BUG ? " BUG" : "");
+
+        for (unsigned int s = 0; s < e.lengths.size(); s++)
+        {
+            const int_least32_t length = e.lengths[s];
+            if (length < 0)
+                std::cout << " -";
+            else
+                std::cout << ' ' << length / 60000 << ':' << std::setfill('0') << std::setw(2)
+                          << (length / 1000) % 60 << std::setfill(' ');
+        }
+        std::cout << std::endl;
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    unsigned int threads = 4;
+    const char *database = 0;
+    bool stil = false;
+
+    int n = 1;
+    for (; n < argc && argv[n][0] == '-'; n++)
+    {
+        switch (argv[n][1])
+        {
+        case 'j':
+            threads = atoi(argv[n] + 2);
+            break;
+        case 'd':
+            database = argv[n] + 2;
+            break;
+        case 's':
+            stil = true;
+            break;
+        case 'l':
+            if (n + 1 < argc)
+                return list(argv[n + 1]);
+            // fall through
+        default:
+            usage();
+            return -1;
+        }
+    }
+
+    if (argc - n != 2)
+    {
+        usage();
+        return -1;
+    }
+
+    const char *root = argv[n];
+    const char *filename = argv[n + 1];
+
+    sidcatalog catalog(threads);
+
+    SidDatabase songlengths;
+    if (database)
+    {
+        if (!songlengths.open(database))
+        {
+            std::cerr << songlengths.error() << std::endl;
+            return -1;
+        }
+        catalog.setDatabase(&songlengths);
+    }
+
+    STILIndex index;
+    if (stil)
+    {
+        if (!index.open(root))
+        {
+            std::cerr << index.error() << std::endl;
+            return -1;
+        }
+        catalog.setStilCheck(stilCheck, &index);
+    }
+
+    if (!catalog.scan(root) || !catalog.write(filename))
+    {
+        std::cerr << catalog.error() << std::endl;
+        return -1;
+    }
+
+    std::cout << filename << ": " << catalog.size() << " tunes, "
+              << catalog.failed() << " failed, "
+              << std::fixed << std::setprecision(2) << catalog.seconds() << " s, "
+              << std::setprecision(0) << catalog.filesPerSecond() << " files/s" << std::endl;
+    return 0;
+}
@@ -0,0 +1,173 @@
+/*
+ * This file is part of libsidplayfp, a SID player engine.
+ *
+ * Copyright 2014 Leandro Nini <drfiemost@users.sourceforge.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <stdlib.h>
+#include <cstring>
+
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "sidplayfp/sidplayfp.h"
+#include "sidplayfp/sidcheckpoints.h"
+#include "sidplayfp/sidbuilder.h"
+#include "sidplayfp/SidConfig.h"
+#include "sidplayfp/SidTune.h"
+#include "sidplayfp/SidTuneInfo.h"
+#include "builders/residfp-builder/residfp.h"
+#include "builders/resid-builder/resid.h"
+
+/*
+ * Pre-render a song and write its checkpoint index, so that a player
+ * using the same configuration can seek with sidcheckpoints::seek.
+ */
+
+static void usage()
+{
+    std::cerr << "Usage: sidcheckpoint [options] <tune>" << std::endl
+              << "  -s<num>   song to render, default is the tune's start song" << std::endl
+              << "  -t<secs>  length to render, default 180" << std::endl
+              << "  -i<secs>  time between checkpoints, default 5" << std::endl
+              << "  -f<freq>  sampling frequency, default " << SidConfig::DEFAULT_SAMPLING_FREQ << std::endl
+              << "  -d<num>   power on delay, default is random" << std::endl
+              << "  -2        stereo playback" << std::endl
+              << "  -r        use reSID instead of reSIDfp" << std::endl
+              << "  -o<file>  index file, default <md5>-<song>.sidckpt" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    unsigned int song = 0;
+    uint_least32_t length = 180;
+    uint_least32_t interval = 5;
+    uint_least32_t frequency = SidConfig::DEFAULT_SAMPLING_FREQ;
+    uint_least16_t delay = SidConfig::DEFAULT_POWER_ON_DELAY;
+    bool stereo = false;
+    bool resid = false;
+    const char *output = 0;
+    const char *filename = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+
+        if (arg[0] != '-')
+            filename = arg;
+        else if (arg[1] == 's')
+            song = atoi(arg + 2);
+        else if (arg[1] == 't')
+            length = atoi(arg + 2);
+        else if (arg[1] == 'i')
+            interval = atoi(arg + 2);
+        else if (arg[1] == 'f')
+            frequency = atoi(arg + 2);
+        else if (arg[1] == 'd')
+            delay = atoi(arg + 2);
+        else if (arg[1] == '2')
+            stereo = true;
+        else if (arg[1] == 'r')
+            resid = true;
+        else if (arg[1] == 'o')
+            output = arg + 2;
+        else
+        {
+            usage();
+            return -1;
+        }
+    }
+
+    if (!filename || length == 0 || interval == 0)
+    {
+        usage();
+        return -1;
+    }
+
+    std::auto_ptr<SidTune> tune(new SidTune(filename));
+    if (!tune->getStatus())
+    {
+        std::cerr << tune->statusString() << std::endl;
+        return -1;
+    }
+
+    tune->selectSong(song);
+
+    std::auto_ptr<sidbuilder> builder;
+    if (resid)
+    {
+        ReSIDBuilder *rs = new ReSIDBuilder("sidcheckpoint");
+        builder.reset(rs);
+        rs->create(2);
+    }
+    else
+    {
+        ReSIDfpBuilder *rs = new ReSIDfpBuilder("sidcheckpoint");
+        builder.reset(rs);
+        rs->create(2);
+    }
+
+    if (!builder->getStatus())
+    {
+        std::cerr << builder->error() << std::endl;
+        return -1;
+    }
+
+    sidplayfp engine;
+
+    SidConfig cfg;
+    cfg.frequency = frequency;
+    cfg.powerOnDelay = delay;
+    cfg.playback = stereo ? SidConfig::STEREO : SidConfig::MONO;
+    cfg.sidEmulation = builder.get();
+    if (!engine.config(cfg))
+    {
+        std::cerr << engine.error() << std::endl;
+        return -1;
+    }
+
+    std::string path;
+    if (output)
+    {
+        path = output;
+    }
+    else
+    {
+        char md5[SidTune::MD5_LENGTH + 1];
+        if (!tune->createMD5(md5))
+        {
+            std::cerr << "Tune has no MD5, use -o to name the index" << std::endl;
+            return -1;
+        }
+
+        std::ostringstream name;
+        name << md5 << '-' << tune->getInfo()->currentSong() << ".sidckpt";
+        path = name.str();
+    }
+
+    sidcheckpoints index;
+    if (!index.create(engine, *tune, length * 1000, interval * 1000, path.c_str()))
+    {
+        std::cerr << index.error() << std::endl;
+        return -1;
+    }
+
+    std::cout << path << std::endl;
+    return 0;
+}
@@ -0,0 +1,125 @@
+/*
+ * This file is part of libsidplayfp, a SID player engine.
+ *
+ * Copyright 2014 Leandro Nini <drfiemost@users.sourceforge.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <stdlib.h>
+
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "sidplayfp/sidarchive.h"
+#include "sidplayfp/sidcatalog.h"
+#include "sidplayfp/sidthread.h"
+#include "sidplayfp/SidTune.h"
+
+/*
+ * Pack the tunes under a directory, usually HVSC, in a single
+ * archive, list its contents or load all of its tunes.
+ */
+
+static void usage()
+{
+    std::cerr << "Usage: sidpack <dir> <archive>" << std::endl
+              << "       sidpack -l <archive>" << std::endl
+              << "       sidpack -t <archive>" << std::endl
+              << "  -l        list the files" << std::endl
+              << "  -t        load all the tunes and report the speed" << std::endl;
+}
+
+static int test(const sidarchive &archive)
+{
+    const uint_least64_t start = sidthread::now();
+
+    SidTune tune(0);
+    unsigned int failed = 0;
+    for (unsigned int i = 0; i < archive.size(); i++)
+    {
+        char md5[SidTune::MD5_LENGTH + 1];
+        if (!archive.load(archive.path(i).c_str(), tune) || !tune.getStatus() || !tune.createMD5(md5))
+        {
+            std::cerr << archive.path(i) << ": " << tune.statusString() << std::endl;
+            failed++;
+        }
+    }
+
+    const double seconds = (sidthread::now() - start) / 1e9;
+
+    std::cout << archive.size() << " tunes, " << failed << " failed, "
+              << std::fixed << std::setprecision(2) << seconds << " s, "
+              << std::setprecision(0) << (seconds > 0. ? archive.size() / seconds : 0.)
+              << " tunes/s" << std::endl;
+    return failed ? -1 : 0;
+}
+
+int main(int argc, char* argv[])
+{
+    sidarchive archive;
+
+    if (argc == 3 && argv[1][0] == '-')
+    {
+        if (!archive.open(argv[2]))
+        {
+            std::cerr << archive.error() << std::endl;
+            return -1;
+        }
+
+        switch (argv[1][1])
+        {
+        case 'l':
+            for (unsigned int i = 0; i < archive.size(); i++)
+                std::cout << archive.path(i) << std::endl;
+            return 0;
+        case 't':
+            return test(archive);
+        default:
+            usage();
+            return -1;
+        }
+    }
+
+    if (argc != 3)
+    {
+        usage();
+        return -1;
+    }
+
+    // Only pack the files that load
+    sidcatalog catalog(4);
+    if (!catalog.scan(argv[1]))
+    {
+        std::cerr << catalog.error() << std::endl;
+        return -1;
+    }
+
+    std::vector<std::string> files;
+    for (unsigned int i = 0; i < catalog.size(); i++)
+        files.push_back(catalog[i].path);
+
+    if (!archive.pack(argv[1], files, argv[2]))
+    {
+        std::cerr << archive.error() << std::endl;
+        return -1;
+    }
+
+    std::cout << argv[2] << ": " << files.size() << " tunes, "
+              << catalog.failed() << " skipped" << std::endl;
+    return 0;
+}
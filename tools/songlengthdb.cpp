@@ -0,0 +1,81 @@
+/*
+ * This file is part of libsidplayfp, a SID player engine.
+ *
+ * Copyright 2014 Leandro Nini <drfiemost@users.sourceforge.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <stdlib.h>
+
+#include <iomanip>
+#include <iostream>
+
+#include "utils/SidDatabase.h"
+
+/*
+ * Compile the HVSC Songlengths.txt into a binary index
+ * that SidDatabase opens without parsing, or look up
+ * a length in either of them.
+ */
+
+static void usage()
+{
+    std::cerr << "Usage: songlengthdb <Songlengths.txt> <index>" << std::endl
+              << "       songlengthdb -q <database> <md5> [song]" << std::endl
+              << "  -q        print the length of a song, default is the first one" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    SidDatabase database;
+
+    if (argc >= 4 && argv[1][0] == '-' && argv[1][1] == 'q')
+    {
+        if (!database.open(argv[2]))
+        {
+            std::cerr << database.error() << std::endl;
+            return -1;
+        }
+
+        const unsigned int song = (argc > 4) ? atoi(argv[4]) : 1;
+        const int_least32_t length = database.lengthMs(argv[3], song);
+        if (length < 0)
+        {
+            std::cerr << database.error() << std::endl;
+            return -1;
+        }
+
+        std::cout << length / 60000 << ':'
+                  << std::setfill('0') << std::setw(2) << (length / 1000) % 60 << '.'
+                  << std::setw(3) << length % 1000 << std::endl;
+        return 0;
+    }
+
+    if (argc != 3 || argv[1][0] == '-')
+    {
+        usage();
+        return -1;
+    }
+
+    if (!database.open(argv[1]) || !database.compile(argv[2]))
+    {
+        std::cerr << database.error() << std::endl;
+        return -1;
+    }
+
+    std::cout << argv[2] << std::endl;
+    return 0;
+}
@@ -0,0 +1,87 @@
+/*
+ * This file is part of libsidplayfp, a SID player engine.
+ *
+ * Copyright 2014 Leandro Nini <drfiemost@users.sourceforge.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <cstring>
+#include <iostream>
+
+#include "utils/STILview/stilindex.h"
+
+/*
+ * Compile the index of the STIL and the BUGlist of
+ * an HVSC copy, or look up the entries of a file.
+ */
+
+static void usage()
+{
+    std::cerr << "Usage: stilindex <HVSC dir> <index>" << std::endl
+              << "       stilindex -q <HVSC dir> <index|-> <path>..." << std::endl
+              << "  -q        print the entries of files, - builds the index in memory" << std::endl;
+}
+
+static void print(const char *title, const STILIndex::view &text)
+{
+    std::cout << title << std::endl;
+    std::cout.write(text.data, text.size);
+}
+
+int main(int argc, char* argv[])
+{
+    STILIndex index;
+
+    if (argc >= 5 && argv[1][0] == '-' && argv[1][1] == 'q')
+    {
+        const char *indexFile = strcmp(argv[3], "-") ? argv[3] : 0;
+        if (!index.open(argv[2], indexFile))
+        {
+            std::cerr << index.error() << std::endl;
+            return -1;
+        }
+
+        for (int i = 4; i < argc; i++)
+        {
+            std::cout << argv[i] << std::endl;
+
+            STILIndex::view text;
+            if (index.getGlobalComment(argv[i], text))
+                print("# Global comment", text);
+            if (index.getEntry(argv[i], text))
+                print("# STIL", text);
+            if (index.getBug(argv[i], text))
+                print("# BUG", text);
+        }
+        return 0;
+    }
+
+    if (argc != 3 || argv[1][0] == '-')
+    {
+        usage();
+        return -1;
+    }
+
+    if (!index.open(argv[1]) || !index.compile(argv[2]))
+    {
+        std::cerr << index.error() << std::endl;
+        return -1;
+    }
+
+    std::cout << argv[2] << ": " << index.entries() << " entries, "
+              << index.bugs() << " bugs" << std::endl;
+    return 0;
+}
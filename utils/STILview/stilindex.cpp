@@ -0,0 +1,572 @@
+/*
+ * This file is part of libsidplayfp, a SID player engine.
+ *
+ * Copyright 2014 Leandro Nini <drfiemost@users.sourceforge.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "stilindex.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#ifdef HAVE_SYS_MMAN_H
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#endif
+
+const char ERR_NO_ERROR[]              = "No error.";
+const char ERR_NOT_OPEN[]              = "STIL INDEX ERROR: No STIL loaded.";
+const char ERR_STIL_OPEN[]             = "STIL INDEX ERROR: Unable to open STIL.txt.";
+const char ERR_INDEX_OPEN[]            = "STIL INDEX ERROR: Unable to open the index.";
+const char ERR_INDEX_CORRUPT[]         = "STIL INDEX ERROR: Index seems to be corrupt.";
+const char ERR_INDEX_STALE[]           = "STIL INDEX ERROR: Index does not match the STIL files.";
+const char ERR_UNABLE_TO_WRITE_INDEX[] = "STIL INDEX ERROR: Unable to write the index.";
+
+static const char MAGIC[8] = { 'S', 'T', 'I', 'L', 'I', 'D', 'X', 0 };
+
+/**
+ * Index header, the tables of STIL.txt and BUGlist.txt follow,
+ * each one made of the buckets and then the entries.
+ * The sizes and the hashes of the texts tell if the index is outdated.
+ */
+struct STILIndex::header_t
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t stilSize;
+    uint32_t bugSize;
+    uint32_t stilBuckets;
+    uint32_t stilCount;
+    uint32_t bugBuckets;
+    uint32_t bugCount;
+    uint32_t stilHash;
+    uint32_t bugHash;
+    uint32_t reserved;
+};
+
+/**
+ * An entry, as offsets into the text.
+ */
+struct STILIndex::entry_t
+{
+    uint32_t hash;
+    uint32_t path;
+    uint32_t pathLength;
+    uint32_t body;
+    uint32_t bodyLength;
+};
+
+/**
+ * Open addressing hash table. A bucket holds the
+ * position of the entry plus one, zero if empty.
+ */
+struct STILIndex::table_t
+{
+    const uint32_t *buckets;
+    const entry_t *entries;
+    uint32_t size;
+    uint32_t count;
+};
+
+bool STILIndex::mappedFile::open(const char *filename)
+{
+    close();
+
+#ifdef HAVE_SYS_MMAN_H
+    const int fd = ::open(filename, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    if (st.st_size == 0)
+    {
+        ::close(fd);
+        return true;
+    }
+
+    // Pages are loaded on demand and shared with other processes
+    void *map = mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    if (map == MAP_FAILED)
+        return false;
+
+    m_data = static_cast<const char*>(map);
+    m_size = st.st_size;
+    m_mapped = true;
+#else
+    std::ifstream in(filename, std::ios::in | std::ios::binary);
+    if (!in.is_open())
+        return false;
+
+    in.seekg(0, std::ios::end);
+    const std::streamoff size = in.tellg();
+    in.seekg(0, std::ios::beg);
+
+    if (size <= 0)
+        return size == 0;
+
+    m_buffer.resize((size_t)size);
+    if (!in.read(&m_buffer[0], size))
+    {
+        m_buffer.clear();
+        return false;
+    }
+
+    m_data = &m_buffer[0];
+    m_size = m_buffer.size();
+#endif
+
+    return true;
+}
+
+void STILIndex::mappedFile::close()
+{
+    if (m_mapped)
+    {
+#ifdef HAVE_SYS_MMAN_H
+        munmap(const_cast<char*>(m_data), m_size);
+#endif
+    }
+
+    std::vector<char>().swap(m_buffer);
+    m_data = 0;
+    m_size = 0;
+    m_mapped = false;
+}
+
+void STILIndex::mappedFile::assign(std::vector<char> &buffer)
+{
+    close();
+
+    m_buffer.swap(buffer);
+    m_data = m_buffer.empty() ? 0 : &m_buffer[0];
+    m_size = m_buffer.size();
+}
+
+uint32_t STILIndex::hash(const char *str, size_t length)
+{
+    // FNV-1a
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < length; i++)
+    {
+        h ^= (uint8_t)str[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+void STILIndex::scan(const char *text, size_t size, std::vector<entry_t> &entries)
+{
+    // An entry starts with a line holding its path
+    // and ends with an empty line
+    bool inEntry = false;
+    entry_t entry;
+
+    size_t pos = 0;
+    while (pos < size)
+    {
+        size_t end = pos;
+        while (end < size && text[end] != '\n' && text[end] != '\r')
+            end++;
+
+        size_t next = end;
+        if (next < size)
+        {
+            if (text[next] == '\r' && next + 1 < size && text[next + 1] == '\n')
+                next += 2;
+            else
+                next++;
+        }
+
+        if (inEntry)
+        {
+            if (end == pos)
+            {
+                entry.bodyLength = pos - entry.body;
+                entries.push_back(entry);
+                inEntry = false;
+            }
+        }
+        else if (end > pos && text[pos] == '/')
+        {
+            size_t last = end;
+            while (last > pos && (text[last - 1] == ' ' || text[last - 1] == '\t'))
+                last--;
+
+            entry.path = pos;
+            entry.pathLength = last - pos;
+            entry.hash = hash(text + pos, last - pos);
+            entry.body = next;
+            inEntry = true;
+        }
+
+        pos = next;
+    }
+
+    if (inEntry)
+    {
+        entry.bodyLength = size - entry.body;
+        entries.push_back(entry);
+    }
+}
+
+void STILIndex::buildTable(const char *text, const std::vector<entry_t> &entries,
+                           std::vector<char> &image, uint32_t &buckets, uint32_t &count)
+{
+    // Keep the load factor below one half
+    uint32_t size = 1;
+    while (size < entries.size() * 2)
+        size <<= 1;
+
+    std::vector<uint32_t> bucket(size, 0);
+    std::vector<entry_t> table;
+    table.reserve(entries.size());
+
+    for (std::vector<entry_t>::const_iterator it = entries.begin(); it != entries.end(); ++it)
+    {
+        uint32_t i = it->hash & (size - 1);
+        bool duplicate = false;
+        while (bucket[i] != 0)
+        {
+            const entry_t &other = table[bucket[i] - 1];
+            if (other.hash == it->hash
+                && other.pathLength == it->pathLength
+                && memcmp(text + other.path, text + it->path, it->pathLength) == 0)
+            {
+                // The first entry wins, as with a sequential search
+                duplicate = true;
+                break;
+            }
+            i = (i + 1) & (size - 1);
+        }
+
+        if (duplicate)
+            continue;
+
+        table.push_back(*it);
+        bucket[i] = table.size();
+    }
+
+    buckets = size;
+    count = table.size();
+
+    const size_t offset = image.size();
+    image.resize(offset + size * sizeof(uint32_t) + table.size() * sizeof(entry_t));
+    memcpy(&image[offset], &bucket[0], size * sizeof(uint32_t));
+    if (!table.empty())
+        memcpy(&image[offset + size * sizeof(uint32_t)], &table[0], table.size() * sizeof(entry_t));
+}
+
+const STILIndex::entry_t *STILIndex::find(const table_t &table, const mappedFile &text, const char *path, size_t length)
+{
+    if (table.count == 0)
+        return 0;
+
+    const uint32_t h = hash(path, length);
+    uint32_t i = h & (table.size - 1);
+
+    for (uint32_t probes = 0; probes < table.size; probes++)
+    {
+        const uint32_t bucket = table.buckets[i];
+        if (bucket == 0 || bucket > table.count)
+            return 0;
+
+        const entry_t *entry = &table.entries[bucket - 1];
+        if (entry->hash == h
+            && entry->pathLength == length
+            && entry->path <= text.size() - length
+            && memcmp(text.data() + entry->path, path, length) == 0)
+        {
+            return entry;
+        }
+
+        i = (i + 1) & (table.size - 1);
+    }
+
+    return 0;
+}
+
+STILIndex::STILIndex(const char *stilPath, const char *bugsPath) :
+    PATH_TO_STIL(stilPath),
+    PATH_TO_BUGLIST(bugsPath),
+    errorString(ERR_NOT_OPEN) {}
+
+STILIndex::~STILIndex()
+{
+    close();
+}
+
+bool STILIndex::open(const char *pathToHVSC, const char *indexFile)
+{
+    close();
+
+    std::string baseDir(pathToHVSC);
+
+    // Chop the trailing slash
+    if (!baseDir.empty() && *(baseDir.end() - 1) == SLASH)
+        baseDir.erase(baseDir.end() - 1);
+
+    std::string stilName = baseDir + PATH_TO_STIL;
+    std::replace(stilName.begin(), stilName.end(), '/', SLASH);
+
+    if (!m_stil.open(stilName.c_str()) || m_stil.size() == 0)
+    {
+        close();
+        errorString = ERR_STIL_OPEN;
+        return false;
+    }
+
+    // Some earlier versions of HVSC did not have a BUGlist.txt file at all
+    std::string bugName = baseDir + PATH_TO_BUGLIST;
+    std::replace(bugName.begin(), bugName.end(), '/', SLASH);
+
+    m_bugs.open(bugName.c_str());
+
+    // An edit that keeps the size still moves the entries
+    const uint32_t stilHash = hash(m_stil.data(), m_stil.size());
+    const uint32_t bugHash = hash(m_bugs.data(), m_bugs.size());
+
+    if (indexFile)
+    {
+        if (!m_index.open(indexFile))
+        {
+            close();
+            errorString = ERR_INDEX_OPEN;
+            return false;
+        }
+    }
+    else
+    {
+        header_t header;
+        memset(&header, 0, sizeof(header_t));
+        memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = FORMAT_VERSION;
+        header.stilSize = m_stil.size();
+        header.bugSize = m_bugs.size();
+        header.stilHash = stilHash;
+        header.bugHash = bugHash;
+
+        std::vector<char> image(sizeof(header_t));
+
+        std::vector<entry_t> entries;
+        scan(m_stil.data(), m_stil.size(), entries);
+        buildTable(m_stil.data(), entries, image, header.stilBuckets, header.stilCount);
+
+        entries.clear();
+        scan(m_bugs.data(), m_bugs.size(), entries);
+        buildTable(m_bugs.data(), entries, image, header.bugBuckets, header.bugCount);
+
+        memcpy(&image[0], &header, sizeof(header_t));
+        m_index.assign(image);
+    }
+
+    return validate(stilHash, bugHash);
+}
+
+bool STILIndex::validate(uint32_t stilHash, uint32_t bugHash)
+{
+    // Check that the tables fit in the file, the entries are checked on lookup
+    const size_t size = m_index.size();
+    const header_t *h = reinterpret_cast<const header_t*>(m_index.data());
+
+    if (size < sizeof(header_t)
+        || memcmp(h->magic, MAGIC, sizeof(MAGIC)) != 0
+        || h->version != FORMAT_VERSION)
+    {
+        close();
+        errorString = ERR_INDEX_CORRUPT;
+        return false;
+    }
+
+    if (h->stilSize != m_stil.size() || h->bugSize != m_bugs.size()
+        || h->stilHash != stilHash || h->bugHash != bugHash)
+    {
+        close();
+        errorString = ERR_INDEX_STALE;
+        return false;
+    }
+
+    const uint64_t stilTable = (uint64_t)h->stilBuckets * sizeof(uint32_t) + (uint64_t)h->stilCount * sizeof(entry_t);
+    const uint64_t bugTable = (uint64_t)h->bugBuckets * sizeof(uint32_t) + (uint64_t)h->bugCount * sizeof(entry_t);
+
+    const bool valid = (h->stilBuckets & (h->stilBuckets - 1)) == 0
+        && (h->bugBuckets & (h->bugBuckets - 1)) == 0
+        && h->stilCount <= h->stilBuckets
+        && h->bugCount <= h->bugBuckets
+        && sizeof(header_t) + stilTable + bugTable <= size;
+
+    if (!valid)
+    {
+        close();
+        errorString = ERR_INDEX_CORRUPT;
+        return false;
+    }
+
+    errorString = ERR_NO_ERROR;
+    return true;
+}
+
+void STILIndex::close()
+{
+    m_index.close();
+    m_bugs.close();
+    m_stil.close();
+
+    errorString = ERR_NOT_OPEN;
+}
+
+bool STILIndex::compile(const char *filename)
+{
+    if (m_index.size() == 0)
+    {
+        errorString = ERR_NOT_OPEN;
+        return false;
+    }
+
+    // Write to a temporary file and rename it so that
+    // readers never see a partial index.
+    const std::string tmpPath = std::string(filename) + ".tmp";
+
+    {
+        std::ofstream out(tmpPath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+        out.write(m_index.data(), m_index.size());
+
+        if (!out.good())
+        {
+            out.close();
+            std::remove(tmpPath.c_str());
+            errorString = ERR_UNABLE_TO_WRITE_INDEX;
+            return false;
+        }
+    }
+
+    if (std::rename(tmpPath.c_str(), filename) != 0)
+    {
+        // Rename doesn't replace existing files everywhere
+        std::remove(filename);
+        if (std::rename(tmpPath.c_str(), filename) != 0)
+        {
+            std::remove(tmpPath.c_str());
+            errorString = ERR_UNABLE_TO_WRITE_INDEX;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+STILIndex::table_t STILIndex::stilTable() const
+{
+    table_t table = { 0, 0, 0, 0 };
+    if (m_index.size() == 0)
+        return table;
+
+    const header_t *h = reinterpret_cast<const header_t*>(m_index.data());
+    const char *data = m_index.data() + sizeof(header_t);
+
+    table.buckets = reinterpret_cast<const uint32_t*>(data);
+    table.entries = reinterpret_cast<const entry_t*>(data + h->stilBuckets * sizeof(uint32_t));
+    table.size = h->stilBuckets;
+    table.count = h->stilCount;
+    return table;
+}
+
+STILIndex::table_t STILIndex::bugTable() const
+{
+    table_t table = { 0, 0, 0, 0 };
+    if (m_index.size() == 0)
+        return table;
+
+    const header_t *h = reinterpret_cast<const header_t*>(m_index.data());
+    const char *data = m_index.data() + sizeof(header_t)
+        + h->stilBuckets * sizeof(uint32_t) + h->stilCount * sizeof(entry_t);
+
+    table.buckets = reinterpret_cast<const uint32_t*>(data);
+    table.entries = reinterpret_cast<const entry_t*>(data + h->bugBuckets * sizeof(uint32_t));
+    table.size = h->bugBuckets;
+    table.count = h->bugCount;
+    return table;
+}
+
+bool STILIndex::lookup(const table_t &table, const mappedFile &text, const char *path, size_t length, view &result)
+{
+    if (length == 0 || length > text.size())
+        return false;
+
+    const entry_t *entry = find(table, text, path, length);
+    if (entry == 0
+        || entry->body > text.size()
+        || entry->bodyLength > text.size() - entry->body)
+    {
+        return false;
+    }
+
+    result.data = text.data() + entry->body;
+    result.size = entry->bodyLength;
+    return true;
+}
+
+bool STILIndex::getEntry(const char *relPathToEntry, view &entry) const
+{
+    const size_t length = strlen(relPathToEntry);
+
+    // Section-global comments have their own call
+    if (length == 0 || relPathToEntry[length - 1] == '/')
+        return false;
+
+    return lookup(stilTable(), m_stil, relPathToEntry, length, entry);
+}
+
+bool STILIndex::getGlobalComment(const char *relPathToEntry, view &comment) const
+{
+    const char *lastSlash = strrchr(relPathToEntry, '/');
+    if (lastSlash == 0)
+        return false;
+
+    return lookup(stilTable(), m_stil, relPathToEntry, lastSlash - relPathToEntry + 1, comment);
+}
+
+bool STILIndex::getBug(const char *relPathToEntry, view &bug) const
+{
+    return lookup(bugTable(), m_bugs, relPathToEntry, strlen(relPathToEntry), bug);
+}
+
+unsigned int STILIndex::entries() const
+{
+    return stilTable().count;
+}
+
+unsigned int STILIndex::bugs() const
+{
+    return bugTable().count;
+}
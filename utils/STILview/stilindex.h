@@ -0,0 +1,211 @@
+/*
+ * This file is part of libsidplayfp, a SID player engine.
+ *
+ * Copyright 2014 Leandro Nini <drfiemost@users.sourceforge.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef STILINDEX_H
+#define STILINDEX_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <string>
+#include <vector>
+
+#include "stildefs.h"
+
+/**
+ * STILIndex
+ *
+ * Fast lookups of STIL entries and bugs.
+ *
+ * STIL.txt and BUGlist.txt are memory mapped where available and
+ * the entries are found with a hash of their HVSC path, built when
+ * the texts are opened or loaded from an index made with #compile.
+ * The index only holds offsets into the texts, lookups return
+ * pointers into the mapped text so nothing gets copied.
+ * The index is stored in native byte order.
+ *
+ * Once open, the lookups don't change the object
+ * and can be called from many threads at once.
+ * Parsing the fields of the entries is left to the caller.
+ */
+class STIL_EXTERN STILIndex
+{
+public:
+    /// Version of the index format.
+    static const uint32_t FORMAT_VERSION = 2;
+
+    /**
+     * A piece of text in the mapped file, not null terminated.
+     * Lines keep the end of line characters of the file.
+     */
+    struct view
+    {
+        const char *data;
+        size_t size;
+    };
+
+private:
+    struct header_t;
+    struct entry_t;
+    struct table_t;
+
+    /**
+     * A file mapped in memory, or read in a buffer
+     * where mapping is not available.
+     */
+    class mappedFile
+    {
+    private:
+        const char *m_data;
+        size_t m_size;
+        bool m_mapped;
+
+        std::vector<char> m_buffer;
+
+    private:
+        // prevent copying
+        mappedFile(const mappedFile&);
+        mappedFile& operator=(const mappedFile&);
+
+    public:
+        mappedFile() : m_data(0), m_size(0), m_mapped(false) {}
+        ~mappedFile() { close(); }
+
+        bool open(const char *filename);
+        void close();
+
+        /// Take over the contents of a buffer.
+        void assign(std::vector<char> &buffer);
+
+        const char *data() const { return m_data; }
+        size_t size() const { return m_size; }
+    };
+
+    static uint32_t hash(const char *str, size_t length);
+
+    static void scan(const char *text, size_t size, std::vector<entry_t> &entries);
+
+    static void buildTable(const char *text, const std::vector<entry_t> &entries,
+                           std::vector<char> &image, uint32_t &buckets, uint32_t &count);
+
+    static const entry_t *find(const table_t &table, const mappedFile &text, const char *path, size_t length);
+
+private:
+    const std::string PATH_TO_STIL;
+    const std::string PATH_TO_BUGLIST;
+
+    mappedFile m_stil;
+    mappedFile m_bugs;
+    mappedFile m_index;
+
+    const char *errorString;
+
+private:
+    bool validate(uint32_t stilHash, uint32_t bugHash);
+
+    table_t stilTable() const;
+    table_t bugTable() const;
+
+    static bool lookup(const table_t &table, const mappedFile &text, const char *path, size_t length, view &result);
+
+    // prevent copying
+    STILIndex(const STILIndex&);
+    STILIndex& operator=(const STILIndex&);
+
+public:
+    /**
+     * @param stilPath relative path to STIL file
+     * @param bugsPath relative path to BUG file
+     */
+    STILIndex(const char *stilPath = DEFAULT_PATH_TO_STIL, const char *bugsPath = DEFAULT_PATH_TO_BUGLIST);
+    ~STILIndex();
+
+    /**
+     * Open the STIL and the BUGlist of an HVSC copy.
+     * A missing BUGlist is not an error.
+     *
+     * @param pathToHVSC HVSC base directory in your machine's format
+     * @param indexFile an index made with #compile for these files,
+     *        rejected if their contents changed since,
+     *        if not given it is built from the texts.
+     * @return false in case of errors, true otherwise.
+     */
+    bool open(const char *pathToHVSC, const char *indexFile = 0);
+
+    /**
+     * Write the index of the open files.
+     *
+     * @param filename the index file to write.
+     * @return false in case of errors, true otherwise.
+     */
+    bool compile(const char *filename);
+
+    /**
+     * Close the files.
+     */
+    void close();
+
+    /**
+     * Get the STIL entry of a file.
+     *
+     * @param relPathToEntry path relative to the HVSC base directory
+     *        starting with a slash, e.g. /Hubbard_Rob/Commando.sid
+     * @param entry the lines of the entry following the path.
+     * @return false if there is no entry.
+     */
+    bool getEntry(const char *relPathToEntry, view &entry) const;
+
+    /**
+     * Get the section-global comment of the directory of a file.
+     *
+     * @param relPathToEntry path relative to the HVSC base directory
+     *        of the file or its directory, ending with a slash
+     * @param comment the lines of the comment following the path.
+     * @return false if there is no comment.
+     */
+    bool getGlobalComment(const char *relPathToEntry, view &comment) const;
+
+    /**
+     * Get the BUGlist entry of a file.
+     *
+     * @param relPathToEntry path relative to the HVSC base directory
+     * @param bug the lines of the entry following the path.
+     * @return false if there is no entry.
+     */
+    bool getBug(const char *relPathToEntry, view &bug) const;
+
+    /**
+     * Get the number of indexed STIL entries, including
+     * the section-global comments.
+     */
+    unsigned int entries() const;
+
+    /**
+     * Get the number of indexed bugs.
+     */
+    unsigned int bugs() const;
+
+    /**
+     * Get the description of the last error.
+     */
+    const char *error() const { return errorString; }
+};
+
+#endif // STILINDEX_H
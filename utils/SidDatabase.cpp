@@ -23,21 +23,87 @@
 #include <ctype.h>
 #include <stdlib.h>
 
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+
 #include "SidDatabase.h"
 
 #include "iniParser.h"
 #include "sidplayfp/SidTune.h"
 #include "sidplayfp/SidTuneInfo.h"
 
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#ifdef HAVE_SYS_MMAN_H
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#endif
+
 const char ERR_DATABASE_CORRUPT[]        = "SID DATABASE ERROR: Database seems to be corrupt.";
 const char ERR_NO_DATABASE_LOADED[]      = "SID DATABASE ERROR: Songlength database not loaded.";
 const char ERR_NO_SELECTED_SONG[]        = "SID DATABASE ERROR: No song selected for retrieving song length.";
 const char ERR_MEM_ALLOC[]               = "SID DATABASE ERROR: Memory Allocation Failure.";
 const char ERR_UNABLE_TO_LOAD_DATABASE[] = "SID DATABASE ERROR: Unable to load the songlegnth database.";
+const char ERR_UNABLE_TO_WRITE_INDEX[]   = "SID DATABASE ERROR: Unable to write the songlength index.";
+const char ERR_NO_TEXT_DATABASE[]        = "SID DATABASE ERROR: Only a text database can be compiled.";
+
+static const char MAGIC[8] = { 'S', 'I', 'D', 'S', 'L', 'D', 'B', 0 };
+
+static const unsigned int DIGEST_LENGTH = 16;
+
+/**
+ * Index header, the entries follow.
+ */
+struct SidDatabase::header_t
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t count;
+    uint32_t lengths;
+    uint32_t reserved;
+};
+
+/**
+ * Index entry, sorted by digest. The lengths of the songs follow the entries.
+ */
+struct SidDatabase::entry_t
+{
+    uint8_t md5[DIGEST_LENGTH];
+    uint32_t first;
+    uint32_t songs;
+};
+
+/**
+ * Orders the entries by digest.
+ */
+struct digestLess
+{
+    template<class T>
+    bool operator()(const T &entry, const uint8_t *md5) const
+    {
+        return memcmp(entry.md5, md5, DIGEST_LENGTH) < 0;
+    }
+
+    template<class T>
+    bool operator()(const T &a, const T &b) const
+    {
+        return memcmp(a.md5, b.md5, DIGEST_LENGTH) < 0;
+    }
+};
 
 SidDatabase::SidDatabase() :
     m_parser(0),
-    errorString(ERR_NO_DATABASE_LOADED)
+    errorString(ERR_NO_DATABASE_LOADED),
+    m_data(0),
+    m_size(0),
+    m_mapped(false)
 {}
 
 SidDatabase::~SidDatabase()
@@ -45,6 +111,27 @@ SidDatabase::~SidDatabase()
     close();
 }
 
+const SidDatabase::header_t *SidDatabase::header() const
+{
+    return reinterpret_cast<const header_t*>(m_data);
+}
+
+const SidDatabase::entry_t *SidDatabase::entries() const
+{
+    return reinterpret_cast<const entry_t*>(m_data + sizeof(header_t));
+}
+
+const uint32_t *SidDatabase::lengths() const
+{
+    return reinterpret_cast<const uint32_t*>(m_data + sizeof(header_t) + header()->count * sizeof(entry_t));
+}
+
+/**
+ * Parse a time in the form m:ss or m:ss.mmm, followed by
+ * optional attributes like (G).
+ *
+ * @return the time in milliseconds
+ */
 const char *SidDatabase::parseTime(const char *str, long &result)
 {
     char *end;
@@ -57,9 +144,19 @@ const char *SidDatabase::parseTime(const char *str, long &result)
 
     end++;
     const long seconds = strtol(end, &end, 10);
-    result = (minutes * 60) + seconds;
+    result = ((minutes * 60) + seconds) * 1000;
+
+    if (*end == '.')
+    {
+        long scale = 100;
+        while (isdigit(*++end))
+        {
+            result += (*end - '0') * scale;
+            scale /= 10;
+        }
+    }
 
-    while (!isspace(*end))
+    while (*end && !isspace(*end))
     {
         end++;
     }
@@ -67,14 +164,48 @@ const char *SidDatabase::parseTime(const char *str, long &result)
     return end;
 }
 
+bool SidDatabase::parseMD5(const char *md5, uint8_t *digest)
+{
+    for (unsigned int i = 0; i < DIGEST_LENGTH * 2; i++)
+    {
+        const int c = tolower(md5[i]);
+        int value;
+        if (c >= '0' && c <= '9')
+            value = c - '0';
+        else if (c >= 'a' && c <= 'f')
+            value = c - 'a' + 10;
+        else
+            return false;
+
+        if (i & 1)
+            digest[i / 2] |= value;
+        else
+            digest[i / 2] = value << 4;
+    }
+
+    return md5[DIGEST_LENGTH * 2] == '\0';
+}
 
 bool SidDatabase::open(const char *filename)
 {
     close();
+
+    // Tell the index from the text by its header
+    {
+        char magic[sizeof(MAGIC)] = { 0 };
+        std::ifstream in(filename, std::ios::in | std::ios::binary);
+        if (in.read(magic, sizeof(magic)) && memcmp(magic, MAGIC, sizeof(MAGIC)) == 0)
+        {
+            in.close();
+            return openIndex(filename);
+        }
+    }
+
     m_parser = new iniParser();
 
     if (!m_parser->open(filename))
     {
+        close();
         errorString = ERR_UNABLE_TO_LOAD_DATABASE;
         return false;
     }
@@ -82,13 +213,215 @@ bool SidDatabase::open(const char *filename)
     return true;
 }
 
+bool SidDatabase::openIndex(const char *filename)
+{
+#ifdef HAVE_SYS_MMAN_H
+    const int fd = ::open(filename, O_RDONLY);
+    if (fd < 0)
+    {
+        errorString = ERR_UNABLE_TO_LOAD_DATABASE;
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(header_t))
+    {
+        ::close(fd);
+        errorString = ERR_DATABASE_CORRUPT;
+        return false;
+    }
+
+    // Pages are loaded on demand and shared with other processes
+    void *map = mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    if (map == MAP_FAILED)
+    {
+        errorString = ERR_UNABLE_TO_LOAD_DATABASE;
+        return false;
+    }
+
+    m_data = static_cast<const uint8_t*>(map);
+    m_size = st.st_size;
+    m_mapped = true;
+#else
+    std::ifstream in(filename, std::ios::in | std::ios::binary);
+    if (!in.is_open())
+    {
+        errorString = ERR_UNABLE_TO_LOAD_DATABASE;
+        return false;
+    }
+
+    in.seekg(0, std::ios::end);
+    const std::streamoff size = in.tellg();
+    in.seekg(0, std::ios::beg);
+
+    if (size < (std::streamoff)sizeof(header_t))
+    {
+        errorString = ERR_DATABASE_CORRUPT;
+        return false;
+    }
+
+    m_buffer.resize((size_t)size);
+    if (!in.read(reinterpret_cast<char*>(&m_buffer[0]), size))
+    {
+        m_buffer.clear();
+        errorString = ERR_UNABLE_TO_LOAD_DATABASE;
+        return false;
+    }
+
+    m_data = &m_buffer[0];
+    m_size = m_buffer.size();
+#endif
+
+    // Check that the tables fit in the file, the entries are checked on lookup
+    const header_t *h = header();
+    const bool valid = memcmp(h->magic, MAGIC, sizeof(MAGIC)) == 0
+        && h->version == FORMAT_VERSION
+        && h->count <= (m_size - sizeof(header_t)) / sizeof(entry_t)
+        && h->lengths <= (m_size - sizeof(header_t) - h->count * sizeof(entry_t)) / sizeof(uint32_t);
+
+    if (!valid)
+    {
+        close();
+        errorString = ERR_DATABASE_CORRUPT;
+        return false;
+    }
+
+    return true;
+}
+
 void SidDatabase::close()
 {
     delete m_parser;
     m_parser = 0;
+
+    if (m_mapped)
+    {
+#ifdef HAVE_SYS_MMAN_H
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+    }
+
+    m_buffer.clear();
+    m_data = 0;
+    m_size = 0;
+    m_mapped = false;
+}
+
+bool SidDatabase::compile(const char *filename)
+{
+    if (!m_parser)
+    {
+        errorString = m_data ? ERR_NO_TEXT_DATABASE : ERR_NO_DATABASE_LOADED;
+        return false;
+    }
+
+    if (!m_parser->setSection("Database"))
+    {
+        errorString = ERR_DATABASE_CORRUPT;
+        return false;
+    }
+
+    const iniParser::keys_t &keys = m_parser->getKeys();
+
+    std::vector<entry_t> table;
+    table.reserve(keys.size());
+    std::vector<uint32_t> times;
+
+    for (iniParser::keys_t::const_iterator it = keys.begin(); it != keys.end(); ++it)
+    {
+        entry_t entry;
+        if (!parseMD5(it->first.c_str(), entry.md5))
+            continue;
+
+        entry.first = times.size();
+        entry.songs = 0;
+
+        try
+        {
+            const char *str = it->second.c_str();
+            while (*str)
+            {
+                while (isspace(*str))
+                    str++;
+                if (!*str)
+                    break;
+
+                long time;
+                str = parseTime(str, time);
+                times.push_back(time);
+                entry.songs++;
+            }
+        }
+        catch (parseError const &e)
+        {
+            times.resize(entry.first);
+            continue;
+        }
+
+        table.push_back(entry);
+    }
+
+    std::sort(table.begin(), table.end(), digestLess());
+
+    header_t header;
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = FORMAT_VERSION;
+    header.count = table.size();
+    header.lengths = times.size();
+    header.reserved = 0;
+
+    // Write to a temporary file and rename it so that
+    // readers never see a partial index.
+    const std::string tmpPath = std::string(filename) + ".tmp";
+
+    {
+        std::ofstream out(tmpPath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header_t));
+        if (!table.empty())
+            out.write(reinterpret_cast<const char*>(&table[0]), table.size() * sizeof(entry_t));
+        if (!times.empty())
+            out.write(reinterpret_cast<const char*>(&times[0]), times.size() * sizeof(uint32_t));
+
+        if (!out.good())
+        {
+            out.close();
+            std::remove(tmpPath.c_str());
+            errorString = ERR_UNABLE_TO_WRITE_INDEX;
+            return false;
+        }
+    }
+
+    if (std::rename(tmpPath.c_str(), filename) != 0)
+    {
+        // Rename doesn't replace existing files everywhere
+        std::remove(filename);
+        if (std::rename(tmpPath.c_str(), filename) != 0)
+        {
+            std::remove(tmpPath.c_str());
+            errorString = ERR_UNABLE_TO_WRITE_INDEX;
+            return false;
+        }
+    }
+
+    return true;
 }
 
 int_least32_t SidDatabase::length(SidTune &tune)
+{
+    const int_least32_t time = lengthMs(tune);
+    return (time < 0) ? -1 : time / 1000;
+}
+
+int_least32_t SidDatabase::length(const char *md5, unsigned int song)
+{
+    const int_least32_t time = lengthMs(md5, song);
+    return (time < 0) ? -1 : time / 1000;
+}
+
+int_least32_t SidDatabase::lengthMs(SidTune &tune)
 {
     const unsigned int song = tune.getInfo()->currentSong();
 
@@ -100,11 +433,38 @@ int_least32_t SidDatabase::length(SidTune &tune)
 
     char md5[SidTune::MD5_LENGTH + 1];
     tune.createMD5(md5);
-    return length(md5, song);
+    return lengthMs(md5, song);
 }
 
-int_least32_t SidDatabase::length(const char *md5, unsigned int song)
+int_least32_t SidDatabase::lengthMs(const char *md5, unsigned int song)
 {
+    if (m_data)
+    {
+        uint8_t digest[DIGEST_LENGTH];
+        if (!parseMD5(md5, digest))
+        {
+            errorString = ERR_DATABASE_CORRUPT;
+            return -1;
+        }
+
+        const entry_t *begin = entries();
+        const entry_t *end = begin + header()->count;
+        const entry_t *entry = std::lower_bound(begin, end, static_cast<const uint8_t*>(digest), digestLess());
+
+        // No entry found in database
+        if (entry == end || memcmp(entry->md5, digest, DIGEST_LENGTH) != 0
+            || song > entry->songs
+            || entry->first > header()->lengths
+            || song > header()->lengths - entry->first)
+        {
+            errorString = ERR_DATABASE_CORRUPT;
+            return -1;
+        }
+
+        // As with the text, no song means no time
+        return song ? lengths()[entry->first + song - 1] : 0;
+    }
+
     if (!m_parser)
     {
         errorString = ERR_NO_DATABASE_LOADED;
@@ -24,6 +24,9 @@
 #define SIDDATABASE_H
 
 #include <stdint.h>
+#include <stddef.h>
+
+#include <vector>
 
 #include "sidplayfp/siddefs.h"
 
@@ -33,18 +36,52 @@ class iniParser;
 /**
  * SidDatabase
  * An utility class to deal with the songlength DataBase.
+ *
+ * Reads either the Songlengths.txt file from HVSC or a binary
+ * index of it made with #compile. The index holds the MD5 hashes
+ * in sorted order, followed by the lengths of all the subtunes
+ * in milliseconds, so it can be used as is. Where available
+ * it is memory mapped and lookups are a binary search.
+ * The index is stored in native byte order.
  */
 class SID_EXTERN SidDatabase
 {
+public:
+    /// Version of the index format.
+    static const uint32_t FORMAT_VERSION = 1;
+
 private:
     class parseError {};
 
+    struct header_t;
+    struct entry_t;
+
     static const char *parseTime(const char *str, long &result);
 
+    static bool parseMD5(const char *md5, uint8_t *digest);
+
 private:
     iniParser  *m_parser;
     const char *errorString;
 
+    /// The binary index, mapped or read in memory.
+    const uint8_t *m_data;
+    size_t m_size;
+    bool m_mapped;
+
+    std::vector<uint8_t> m_buffer;
+
+private:
+    bool openIndex(const char *filename);
+
+    const header_t *header() const;
+    const entry_t *entries() const;
+    const uint32_t *lengths() const;
+
+    // prevent copying
+    SidDatabase(const SidDatabase&);
+    SidDatabase& operator=(const SidDatabase&);
+
 public:
     SidDatabase();
     ~SidDatabase();
@@ -52,11 +89,21 @@ public:
     /**
      * Open the songlength DataBase.
      *
-     * @param filename songlengthDB file name with full path.
+     * @param filename songlengthDB file name with full path,
+     *        either the text file or a binary index.
      * @return false in case of errors, true otherwise.
      */
     bool open(const char *filename);
 
+    /**
+     * Write a binary index of the open text DataBase,
+     * entries with invalid times are left out.
+     *
+     * @param filename the index file to write.
+     * @return false if no text DataBase is open or in case of errors.
+     */
+    bool compile(const char *filename);
+
     /**
      * Close the songlength DataBase.
      */
@@ -79,6 +126,23 @@ public:
      */
     int_least32_t length(const char *md5, unsigned int song);
 
+    /**
+     * Get the length of the current subtune in milliseconds.
+     *
+     * @param tune
+     * @return tune length in milliseconds, -1 in case of errors.
+     */
+    int_least32_t lengthMs(SidTune &tune);
+
+    /**
+     * Get the length of the selected subtune in milliseconds.
+     *
+     * @param md5 the md5 hash of the tune.
+     * @param song the subtune.
+     * @return tune length in milliseconds, -1 in case of errors.
+     */
+    int_least32_t lengthMs(const char *md5, unsigned int song);
+
     /**
      * Get descriptive error message.
      */
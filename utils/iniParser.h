@@ -25,8 +25,10 @@
 
 class iniParser
 {
-private:
+public:
     typedef std::map<std::string, std::string> keys_t;
+
+private:
     typedef std::map<std::string, keys_t> sections_t;
 
     class parseError {};
@@ -47,6 +49,11 @@ public:
 
     bool setSection(const char *section);
     const char *getValue(const char *key);
+
+    /**
+     * Get all the keys of the current section.
+     */
+    const keys_t &getKeys() const { return curSection->second; }
 };
 
 #endif // INIPARSER_H